@@ -1,39 +1,133 @@
+#include <algorithm>
+#include <cassert>
+#include <new>
+#include <unordered_set>
+
 #include "buffer/buffer_pool_manager.h"
+#include "buffer/clock_replacer.h"
+#include "buffer/lru_k_replacer.h"
+#include "buffer/lru_replacer.h"
+#include "buffer/page_table.h"
+#include "buffer/two_queue_replacer.h"
 
 namespace cmudb {
 
+constexpr double BufferPoolManager::LOW_WATERMARK;
+constexpr double BufferPoolManager::HIGH_WATERMARK;
+constexpr std::chrono::milliseconds BufferPoolManager::FLUSH_INTERVAL;
+constexpr size_t BufferPoolManager::LRU_K;
+constexpr size_t BufferPoolManager::MAX_COALESCED_PAGES;
+constexpr int BufferPoolManager::FRAME_CLAIMED;
+
 /*
  * BufferPoolManager Constructor
- * WARNING: Do Not Edit This Function
+ * num_shards: number of independent partitions the frames are divided into,
+ * clamped to [1, pool_size]
+ * policy: replacement policy used by the replacer of every shard
+ * lru_k: number of accesses the LRU-K policy ranks pages by
  */
 BufferPoolManager::BufferPoolManager(size_t pool_size,
-                                                 const std::string &db_file)
-    : pool_size_(pool_size), disk_manager_{db_file} {
+                                     const std::string &db_file,
+                                     size_t num_shards, ReplacerPolicy policy,
+                                     size_t lru_k)
+    : pool_size_(pool_size), policy_(policy), disk_manager_{db_file},
+      async_disk_manager_(&disk_manager_), dirty_count_(0),
+      low_watermark_(LOW_WATERMARK), high_watermark_(HIGH_WATERMARK) {
   // a consecutive memory space for buffer pool
-  pages_ = new Page[pool_size_];
-  page_table_ = new ExtendibleHash<page_id_t, Page *>(100);
-  replacer_ = new LRUReplacer<Page *>;
-  free_list_ = new std::list<Page *>;
+  arenas_.emplace_back(new FrameArena(pool_size_));
+  Page *pages = arenas_.front()->GetPages();
 
-  // put all the pages into free list
-  for (size_t i = 0; i < pool_size_; ++i) {
-    free_list_->push_back(&pages_[i]);
+  if (num_shards > pool_size_)
+    num_shards = pool_size_;
+  if (num_shards == 0)
+    num_shards = 1;
+  shards_.resize(num_shards);
+  // hand out consecutive slices of the page array
+  size_t offset = 0;
+  for (size_t i = 0; i < num_shards; ++i) {
+    size_t shard_size = GetShardTargetSize(i, pool_size_);
+    std::vector<Page *> frames;
+    for (size_t j = 0; j < shard_size; ++j)
+      frames.push_back(&pages[offset + j]);
+    shards_[i] = new BufferPoolShard(frames, policy_, lru_k);
+    offset += shard_size;
   }
+  flusher_ = std::thread(&BufferPoolManager::FlusherLoop, this);
 }
 
 /*
  * BufferPoolManager Deconstructor
- * WARNING: Do Not Edit This Function
  */
 BufferPoolManager::~BufferPoolManager() {
+  {
+    std::lock_guard<std::mutex> guard(flusher_latch_);
+    stop_flusher_ = true;
+  }
+  flusher_cv_.notify_one();
+  flusher_.join();
   FlushAllPages();
-  delete[] pages_;
+  // no prefetch may still be filling a frame when the pages go away
+  async_disk_manager_.Submit();
+  for (auto shard : shards_) {
+    for (auto &read : shard->pending_reads_)
+      read.second.wait();
+    delete shard;
+  }
+}
+
+namespace {
+// A1 gets a quarter of the frames as suggested by the 2Q paper
+size_t TwoQueueA1Max(size_t num_frames) { return num_frames / 4; }
+} // namespace
+
+BufferPoolManager::BufferPoolShard::BufferPoolShard(
+    const std::vector<Page *> &frames, ReplacerPolicy policy, size_t lru_k)
+    : frames_(frames), target_size_(frames.size()), policy_(policy) {
+  page_table_ = new PageTable(frames_.size());
+  switch (policy) {
+  case ReplacerPolicy::LRU_K:
+    replacer_ = new LRUKReplacer<Page *>(lru_k);
+    break;
+  case ReplacerPolicy::TWO_QUEUE:
+    replacer_ = new TwoQueueReplacer<Page *>(TwoQueueA1Max(target_size_));
+    break;
+  case ReplacerPolicy::CLOCK:
+    replacer_ = new ClockReplacer<Page *>;
+    break;
+  default:
+    replacer_ = new LRUReplacer<Page *>;
+    break;
+  }
+  free_list_ = new std::list<Page *>;
+
+  // put all the pages into free list
+  for (auto page : frames_) {
+    page->pin_count_ = FRAME_CLAIMED;
+    free_list_->push_back(page);
+  }
+}
+
+BufferPoolManager::BufferPoolShard::~BufferPoolShard() {
   delete page_table_;
   delete replacer_;
   delete free_list_;
 }
 
+/*
+ * Change how many frames the shard should own, the 2Q replacer's A1 share
+ * follows the new size
+ * NOTE: caller must hold the shard latch
+ */
+void BufferPoolManager::BufferPoolShard::SetTargetSize(size_t target_size) {
+  target_size_ = target_size;
+  if (policy_ == ReplacerPolicy::TWO_QUEUE)
+    static_cast<TwoQueueReplacer<Page *> *>(replacer_)->SetA1Max(
+        TwoQueueA1Max(target_size_));
+}
+
 /**
+ * 0. a resident page is pinned without taking the shard latch, see
+ *    PinResidentPage
  * 1. search hash table.
  *  1.1 if exist, pin the page and return immediately
  *  1.2 if no exist, find a replacement entry from either free list or lru
@@ -44,7 +138,47 @@ BufferPoolManager::~BufferPoolManager() {
  * 4. Update page metadata, read page content from disk file and return page
  * pointer
  */
-Page *BufferPoolManager::FetchPage(page_id_t page_id) { return nullptr; }
+Page *BufferPoolManager::FetchPage(page_id_t page_id, BufferRing *ring) {
+  if (page_id == INVALID_PAGE_ID)
+    return nullptr;
+  BufferPoolShard *shard = GetShard(page_id);
+  Page *page = PinResidentPage(shard, page_id);
+  if (page != nullptr)
+    return page;
+  std::lock_guard<std::mutex> guard(shard->latch_);
+
+  if (shard->page_table_->Find(page_id, page)) {
+    stats_.Add(BufferPoolStats::HITS);
+    if (WaitForRead(shard, page_id))
+      stats_.Add(BufferPoolStats::PIN_WAITS);
+    if (page->pin_count_++ == 0 && page->ring_ == nullptr)
+      shard->replacer_->Erase(page);
+    page->access_count_++;
+    return page;
+  }
+
+  stats_.Add(BufferPoolStats::MISSES);
+  page = ring == nullptr ? GetVictimPage(shard)
+                         : GetRingVictimPage(page_id, ring);
+  if (page == nullptr)
+    return nullptr;
+  page->page_id_ = page_id;
+  page->access_count_ = 1;
+  // lock-free lookups keep off the frame until its content is read
+  page->read_pending_ = true;
+  page->pin_count_ = 1;
+  shard->page_table_->Insert(page_id, page);
+  // the page may have been evicted recently with its write still in flight
+  if (WaitForWriteBack(page_id))
+    stats_.Add(BufferPoolStats::PIN_WAITS);
+  // submitted together with the victim's write-back, if any
+  std::future<bool> read =
+      async_disk_manager_.ReadPageAsync(page_id, page->GetData());
+  async_disk_manager_.Submit();
+  read.wait();
+  page->read_pending_ = false;
+  return page;
+}
 
 /*
  * Implementation of unpin page
@@ -53,7 +187,23 @@ Page *BufferPoolManager::FetchPage(page_id_t page_id) { return nullptr; }
  * is_dirty: set the dirty flag of this page
  */
 bool BufferPoolManager::UnpinPage(page_id_t page_id, bool is_dirty) {
-  return false;
+  if (page_id == INVALID_PAGE_ID)
+    return false;
+  BufferPoolShard *shard = GetShard(page_id);
+  std::lock_guard<std::mutex> guard(shard->latch_);
+
+  Page *page = nullptr;
+  if (!shard->page_table_->Find(page_id, page) || page->pin_count_ <= 0)
+    return false;
+  if (is_dirty)
+    SetDirty(page, true);
+  // ring frames are recycled by their ring only
+  if (--page->pin_count_ == 0 && page->ring_ == nullptr) {
+    shard->replacer_->Insert(page);
+    // a shrink may be waiting for frames of this shard
+    ReleaseExcessFrames(shard);
+  }
+  return true;
 }
 
 /*
@@ -62,12 +212,56 @@ bool BufferPoolManager::UnpinPage(page_id_t page_id, bool is_dirty) {
  * if page is not found in page table, return false
  * NOTE: make sure page_id != INVALID_PAGE_ID
  */
-bool BufferPoolManager::FlushPage(page_id_t page_id) { return false; }
+bool BufferPoolManager::FlushPage(page_id_t page_id) {
+  if (page_id == INVALID_PAGE_ID)
+    return false;
+  BufferPoolShard *shard = GetShard(page_id);
+  std::lock_guard<std::mutex> guard(shard->latch_);
+
+  Page *page = nullptr;
+  if (!shard->page_table_->Find(page_id, page))
+    return false;
+  WaitForRead(shard, page_id);
+  // queued behind the copies FlushAllPages and the flusher may still have in
+  // flight, so none of them can land after this one
+  std::future<bool> write =
+      async_disk_manager_.WritePageAsync(page_id, page->GetData());
+  async_disk_manager_.Submit();
+  write.wait();
+  stats_.Add(BufferPoolStats::WRITE_BACKS);
+  SetDirty(page, false);
+  return true;
+}
 
 /*
  * Used to flush all dirty pages in the buffer pool manager
+ * The writes of all shards are submitted as one batch, and the call returns
+ * once they and every outstanding write-back have completed.
  */
-void BufferPoolManager::FlushAllPages() {}
+void BufferPoolManager::FlushAllPages() {
+  std::vector<std::future<bool>> writes;
+  for (auto shard : shards_) {
+    std::lock_guard<std::mutex> guard(shard->latch_);
+    for (auto page : shard->frames_) {
+      if (page->page_id_ != INVALID_PAGE_ID && page->is_dirty_) {
+        writes.push_back(async_disk_manager_.WritePageAsync(page->page_id_,
+                                                            page->GetData()));
+        stats_.Add(BufferPoolStats::WRITE_BACKS);
+        SetDirty(page, false);
+      }
+    }
+  }
+  async_disk_manager_.Submit();
+  for (auto &write : writes)
+    write.wait();
+
+  std::lock_guard<std::mutex> guard(write_back_latch_);
+  // the flusher may have queued some of them without submitting yet
+  async_disk_manager_.Submit();
+  for (auto &entry : write_backs_)
+    entry.second.wait();
+  write_backs_.clear();
+}
 
 /**
  * User should call this method for deleting a page. This routine will call disk
@@ -78,7 +272,31 @@ void BufferPoolManager::FlushAllPages() {}
  * method to delete from disk file.
  * If the page is found within page table, but pin_count != 0, return false
  */
-bool BufferPoolManager::DeletePage(page_id_t page_id) { return false; }
+bool BufferPoolManager::DeletePage(page_id_t page_id) {
+  if (page_id == INVALID_PAGE_ID)
+    return false;
+  BufferPoolShard *shard = GetShard(page_id);
+  std::lock_guard<std::mutex> guard(shard->latch_);
+
+  Page *page = nullptr;
+  if (shard->page_table_->Find(page_id, page)) {
+    if (!ClaimFrame(page))
+      return false;
+    WaitForRead(shard, page_id);
+    shard->replacer_->Erase(page);
+    shard->page_table_->Remove(page_id);
+    SetDirty(page, false);
+    page->page_id_ = INVALID_PAGE_ID;
+    page->ResetMemory();
+    // a ring frame stays with its ring
+    if (page->ring_ == nullptr) {
+      shard->free_list_->push_back(page);
+      ReleaseExcessFrames(shard);
+    }
+  }
+  disk_manager_.DeallocatePage(page_id);
+  return true;
+}
 
 /**
  * User should call this method if needs to create a new page. This routine
@@ -87,7 +305,690 @@ bool BufferPoolManager::DeletePage(page_id_t page_id) { return false; }
  * free list or lru replacer(NOTE: always choose from free list first), update
  * new page's metadata, zero out memory and add corresponding entry into page
  * table.
+ * The new page is cached by the shard its page id hashes to. While that shard
+ * has neither a free nor an evictable frame further page ids are allocated,
+ * until one hashes to a shard that has, and the skipped ids are given back.
  * return nullptr is all the pages in pool are pinned
  */
-Page *BufferPoolManager::NewPage(page_id_t &page_id) { return nullptr; }
+Page *BufferPoolManager::NewPage(page_id_t &page_id) {
+  std::vector<bool> full(shards_.size(), false);
+  size_t full_count = 0;
+  std::vector<page_id_t> skipped;
+  Page *page = nullptr;
+  while (page == nullptr && full_count < shards_.size()) {
+    page_id_t new_page_id = disk_manager_.AllocatePage();
+    size_t shard_index = GetShardIndex(new_page_id);
+    if (!full[shard_index])
+      page = NewPageInShard(shards_[shard_index], new_page_id);
+    if (page == nullptr) {
+      if (!full[shard_index]) {
+        full[shard_index] = true;
+        full_count++;
+      }
+      skipped.push_back(new_page_id);
+      continue;
+    }
+    page_id = new_page_id;
+  }
+  for (auto skipped_page_id : skipped)
+    disk_manager_.DeallocatePage(skipped_page_id);
+  return page;
+}
+
+ReadPageGuard BufferPoolManager::FetchPageRead(page_id_t page_id,
+                                               BufferRing *ring) {
+  Page *page = FetchPage(page_id, ring);
+  if (page == nullptr)
+    return ReadPageGuard();
+  page->RLatch();
+  return ReadPageGuard(this, page);
+}
+
+WritePageGuard BufferPoolManager::FetchPageWrite(page_id_t page_id) {
+  Page *page = FetchPage(page_id);
+  if (page == nullptr)
+    return WritePageGuard();
+  page->WLatch();
+  return WritePageGuard(this, page);
+}
+
+OptimisticPageGuard BufferPoolManager::FetchPageOptimistic(page_id_t page_id) {
+  return OptimisticPageGuard(this, FetchPage(page_id));
+}
+
+WritePageGuard BufferPoolManager::NewPageGuarded(page_id_t &page_id) {
+  Page *page = NewPage(page_id);
+  if (page == nullptr)
+    return WritePageGuard();
+  page->WLatch();
+  return WritePageGuard(this, page);
+}
+
+/*
+ * Start reading count consecutive pages from page_id into the buffer pool
+ * without waiting for them. Pages that are already cached, beyond the last
+ * allocated page or without a free or evictable frame in their shard are
+ * skipped. The prefetched pages are left unpinned and evictable.
+ */
+void BufferPoolManager::Prefetch(page_id_t page_id, size_t count,
+                                 BufferRing *ring) {
+  if (page_id == INVALID_PAGE_ID)
+    return;
+  page_id_t end = disk_manager_.GetNextPageId();
+  for (size_t i = 0; i < count && page_id < end; ++i, ++page_id) {
+    BufferPoolShard *shard = GetShard(page_id);
+    std::lock_guard<std::mutex> guard(shard->latch_);
+
+    Page *page = nullptr;
+    if (shard->page_table_->Find(page_id, page))
+      continue;
+    page = ring == nullptr ? GetVictimPage(shard)
+                           : GetRingVictimPage(page_id, ring);
+    if (page == nullptr)
+      continue;
+    WaitForWriteBack(page_id);
+    page->page_id_ = page_id;
+    page->access_count_ = 0;
+    page->is_dirty_ = false;
+    page->read_pending_ = true;
+    page->pin_count_ = 0;
+    shard->page_table_->Insert(page_id, page);
+    shard->pending_reads_[page_id] =
+        async_disk_manager_.ReadPageAsync(page_id, page->GetData());
+    if (page->ring_ == nullptr)
+      shard->replacer_->Insert(page);
+  }
+  // the whole range goes out as one batch
+  async_disk_manager_.Submit();
+}
+
+/*
+ * Change the pool to pool_size frames, clamped to at least one per shard.
+ * Growing reclaims frames released by earlier shrinks before mapping a new
+ * arena. Shrinking evicts unpinned pages, dirty ones are written back before
+ * their frames are released; pinned frames and frames of buffer rings are
+ * released once they are unpinned or their ring is destroyed.
+ */
+void BufferPoolManager::Resize(size_t pool_size) {
+  std::lock_guard<std::mutex> resize_guard(resize_latch_);
+  if (pool_size < shards_.size())
+    pool_size = shards_.size();
+
+  // map all new frames at once rather than one arena per shard, the pool is
+  // left untouched if that fails
+  size_t missing = 0;
+  for (size_t i = 0; i < shards_.size(); ++i) {
+    std::lock_guard<std::mutex> guard(shards_[i]->latch_);
+    size_t target_size = GetShardTargetSize(i, pool_size);
+    if (shards_[i]->frames_.size() < target_size)
+      missing += target_size - shards_[i]->frames_.size();
+  }
+  std::vector<Page *> frames = AcquireFrames(missing);
+  pool_size_ = pool_size;
+
+  for (size_t i = 0; i < shards_.size(); ++i) {
+    BufferPoolShard *shard = shards_[i];
+    std::lock_guard<std::mutex> guard(shard->latch_);
+    shard->SetTargetSize(GetShardTargetSize(i, pool_size));
+    if (shard->frames_.size() >= shard->target_size_) {
+      ReleaseExcessFrames(shard);
+      continue;
+    }
+    size_t count = shard->target_size_ - shard->frames_.size();
+    // pending releases of this shard may have been completed meanwhile, if
+    // no frames are left the shard stays short of its target
+    if (frames.size() < count) {
+      try {
+        std::vector<Page *> more = AcquireFrames(count - frames.size());
+        frames.insert(frames.end(), more.begin(), more.end());
+      } catch (std::bad_alloc &) {
+        count = frames.size();
+      }
+    }
+    for (size_t j = 0; j < count; ++j) {
+      frames.back()->pin_count_ = FRAME_CLAIMED;
+      shard->frames_.push_back(frames.back());
+      shard->free_list_->push_back(frames.back());
+      frames.pop_back();
+    }
+  }
+  ReleaseFrames(frames);
+  async_disk_manager_.Submit();
+  // the watermarks are relative to the pool size
+  {
+    std::lock_guard<std::mutex> guard(flusher_latch_);
+    flush_requested_ = true;
+  }
+  flusher_cv_.notify_one();
+}
+
+size_t BufferPoolManager::GetNumFrames() {
+  size_t num_frames = 0;
+  for (auto shard : shards_) {
+    std::lock_guard<std::mutex> guard(shard->latch_);
+    num_frames += shard->frames_.size();
+  }
+  return num_frames;
+}
+
+bool BufferPoolManager::IsUsingHugePages() {
+  std::lock_guard<std::mutex> guard(arena_latch_);
+  return !arenas_.empty() && arenas_.front()->IsUsingHugePages();
+}
+
+std::vector<std::pair<page_id_t, uint64_t>>
+BufferPoolManager::GetPageAccessCounts() {
+  std::vector<std::pair<page_id_t, uint64_t>> access_counts;
+  for (auto shard : shards_) {
+    std::lock_guard<std::mutex> guard(shard->latch_);
+    for (auto page : shard->frames_) {
+      if (page->page_id_ != INVALID_PAGE_ID)
+        access_counts.emplace_back(page->page_id_, page->access_count_);
+    }
+  }
+  return access_counts;
+}
+
+/*
+ * Helper function to select the shard caching page_id
+ */
+size_t BufferPoolManager::GetShardIndex(page_id_t page_id) {
+  return static_cast<size_t>(page_id) % shards_.size();
+}
+
+BufferPoolManager::BufferPoolShard *
+BufferPoolManager::GetShard(page_id_t page_id) {
+  return shards_[GetShardIndex(page_id)];
+}
+
+/*
+ * Helper function to compute how many frames a shard gets, the first shards
+ * take one extra frame when pool_size is not a multiple of the shard count
+ */
+size_t BufferPoolManager::GetShardTargetSize(size_t shard_index,
+                                             size_t pool_size) {
+  return pool_size / shards_.size() +
+         (shard_index < pool_size % shards_.size() ? 1 : 0);
+}
+
+/*
+ * Helper function to pin a resident page without the shard latch. The frame
+ * found in the page table is pinned by raising its pin count, which fails
+ * while the frame is claimed for eviction or free. The page id is checked
+ * afterwards since the frame may have been recycled since the lookup.
+ * return nullptr if the page has to be fetched under the latch
+ */
+Page *BufferPoolManager::PinResidentPage(BufferPoolShard *shard,
+                                         page_id_t page_id) {
+  Page *page = nullptr;
+  if (!shard->page_table_->Find(page_id, page))
+    return nullptr;
+  int pin_count = page->pin_count_.load(std::memory_order_relaxed);
+  do {
+    if (pin_count == FRAME_CLAIMED)
+      return nullptr;
+  } while (!page->pin_count_.compare_exchange_weak(pin_count, pin_count + 1));
+  if (page->page_id_ != page_id || page->read_pending_) {
+    UnpinStrayPage(page);
+    return nullptr;
+  }
+  stats_.Add(BufferPoolStats::HITS);
+  page->access_count_.fetch_add(1, std::memory_order_relaxed);
+  return page;
+}
+
+/*
+ * Helper function to drop a pin taken by PinResidentPage on a frame that did
+ * not hold the expected page. If that was the last pin of whatever page the
+ * frame holds now, its own unpin did not make it evictable and this is done
+ * here under the latch.
+ */
+void BufferPoolManager::UnpinStrayPage(Page *page) {
+  if (page->pin_count_.fetch_sub(1) != 1)
+    return;
+  page_id_t page_id = page->page_id_;
+  if (page_id == INVALID_PAGE_ID)
+    return;
+  BufferPoolShard *shard = GetShard(page_id);
+  std::lock_guard<std::mutex> guard(shard->latch_);
+  Page *cached = nullptr;
+  if (shard->page_table_->Find(page_id, cached) && cached == page &&
+      page->pin_count_ == 0 && page->ring_ == nullptr)
+    shard->replacer_->Insert(page);
+}
+
+/*
+ * Helper function to take an unpinned frame away from lock-free pinning
+ * before its page is evicted or deleted
+ * return false if the page is pinned
+ */
+bool BufferPoolManager::ClaimFrame(Page *page) {
+  int pin_count = 0;
+  return page->pin_count_.compare_exchange_strong(pin_count, FRAME_CLAIMED);
+}
+
+/*
+ * Helper function to find a replacement frame within the shard, from the free
+ * list first and then from the replacer. A dirty victim's write-back is queued
+ * (the caller submits it) and its old page table entry removed.
+ * NOTE: caller must hold the shard latch
+ * return nullptr if all the frames of the shard are pinned
+ */
+Page *BufferPoolManager::GetVictimPage(BufferPoolShard *shard) {
+  Page *page = nullptr;
+  if (!shard->free_list_->empty()) {
+    page = shard->free_list_->front();
+    shard->free_list_->pop_front();
+    return page;
+  }
+  // pages pinned without the latch may still sit in the replacer, they are
+  // dropped from it and come back when unpinned
+  do {
+    if (!shard->replacer_->Victim(page))
+      return nullptr;
+  } while (!ClaimFrame(page));
+  EvictPage(shard, page);
+  return page;
+}
+
+/*
+ * Helper function to cache the freshly allocated page page_id in shard
+ * return nullptr if all the frames of the shard are pinned
+ */
+Page *BufferPoolManager::NewPageInShard(BufferPoolShard *shard,
+                                        page_id_t page_id) {
+  std::lock_guard<std::mutex> guard(shard->latch_);
+
+  // a reused page id may have been prefetched after it was deallocated
+  Page *page = nullptr;
+  if (shard->page_table_->Find(page_id, page)) {
+    // nobody may pin a page that is not allocated
+    bool claimed = ClaimFrame(page);
+    assert(claimed);
+    (void)claimed;
+    WaitForRead(shard, page_id);
+    shard->replacer_->Erase(page);
+    shard->page_table_->Remove(page_id);
+    // keep the new page out of the ring that prefetched the old one
+    if (page->ring_ != nullptr) {
+      page->page_id_ = INVALID_PAGE_ID;
+      page = GetVictimPage(shard);
+    }
+  } else {
+    page = GetVictimPage(shard);
+  }
+  if (page == nullptr)
+    return nullptr;
+  // a reused page id may still have the write-back of its previous life
+  WaitForWriteBack(page_id);
+  page->page_id_ = page_id;
+  page->access_count_ = 1;
+  page->is_dirty_ = false;
+  page->ResetMemory();
+  page->pin_count_ = 1;
+  shard->page_table_->Insert(page_id, page);
+  // start the victim's write-back, if any, without waiting for it
+  async_disk_manager_.Submit();
+  return page;
+}
+
+/*
+ * Helper function to find a frame for page_id within the ring. An unpinned
+ * frame of the ring is recycled first, the ring grows up to its capacity
+ * with frames from the pool, and once all its frames are pinned the frame is
+ * taken from the pool as usual.
+ * NOTE: caller must hold the latch of page_id's shard
+ * return nullptr if all the frames of the shard are pinned
+ */
+Page *BufferPoolManager::GetRingVictimPage(page_id_t page_id,
+                                           BufferRing *ring) {
+  size_t shard_index = GetShardIndex(page_id);
+  BufferPoolShard *shard = shards_[shard_index];
+  std::vector<Page *> &frames = ring->frames_[shard_index];
+  size_t &next_victim = ring->next_victim_[shard_index];
+  for (size_t i = 0; i < frames.size(); ++i) {
+    Page *page = frames[(next_victim + i) % frames.size()];
+    // a ring frame without a page is already claimed
+    if (page->page_id_ != INVALID_PAGE_ID && !ClaimFrame(page))
+      continue;
+    next_victim = (next_victim + i + 1) % frames.size();
+    if (page->page_id_ != INVALID_PAGE_ID)
+      EvictPage(shard, page);
+    return page;
+  }
+
+  Page *page = GetVictimPage(shard);
+  if (page != nullptr && frames.size() < ring->shard_capacity_) {
+    page->ring_ = ring;
+    frames.push_back(page);
+  }
+  return page;
+}
+
+/*
+ * Helper function to drop the page cached by an unpinned frame, a dirty page
+ * is queued for write-back
+ * NOTE: caller must hold the shard latch
+ */
+void BufferPoolManager::EvictPage(BufferPoolShard *shard, Page *page) {
+  WaitForRead(shard, page->page_id_);
+  stats_.Add(BufferPoolStats::EVICTIONS);
+  if (page->is_dirty_) {
+    WriteBackAsync(page);
+    SetDirty(page, false);
+    // the flusher is falling behind
+    {
+      std::lock_guard<std::mutex> guard(flusher_latch_);
+      flush_requested_ = true;
+    }
+    flusher_cv_.notify_one();
+  }
+  shard->page_table_->Remove(page->page_id_);
+}
+
+/*
+ * Helper function to hand the frames of a ring back to the pool. Clean pages
+ * read by the ring are dropped right away so that they do not linger in the
+ * pool, dirty ones are left to the replacer and pinned ones join it once
+ * they are unpinned.
+ */
+void BufferPoolManager::ReleaseBufferRing(BufferRing *ring) {
+  for (size_t i = 0; i < shards_.size(); ++i) {
+    BufferPoolShard *shard = shards_[i];
+    std::lock_guard<std::mutex> guard(shard->latch_);
+    for (auto page : ring->frames_[i]) {
+      page->ring_ = nullptr;
+      if (page->pin_count_ > 0)
+        continue;
+      // a clean page may still get pinned without the latch meanwhile
+      if (page->page_id_ != INVALID_PAGE_ID &&
+          (page->is_dirty_ || !ClaimFrame(page))) {
+        shard->replacer_->Insert(page);
+        continue;
+      }
+      if (page->page_id_ != INVALID_PAGE_ID) {
+        WaitForRead(shard, page->page_id_);
+        shard->page_table_->Remove(page->page_id_);
+        page->page_id_ = INVALID_PAGE_ID;
+      }
+      shard->free_list_->push_back(page);
+    }
+    ring->frames_[i].clear();
+    ReleaseExcessFrames(shard);
+  }
+}
+
+/*
+ * Helper function to queue the write-back of a dirty page. The data is
+ * copied, so the frame can be reused right away, and the async disk manager
+ * holds the write back until earlier writes of the page have completed.
+ */
+void BufferPoolManager::WriteBackAsync(Page *page) {
+  stats_.Add(BufferPoolStats::WRITE_BACKS);
+  TrackWriteBack(
+      page->page_id_,
+      async_disk_manager_.WritePageAsync(page->page_id_, page->GetData())
+          .share());
+}
+
+/*
+ * Helper function to remember an in-flight write of page_id, later accesses
+ * to the page wait for it
+ */
+void BufferPoolManager::TrackWriteBack(page_id_t page_id,
+                                       std::shared_future<bool> write) {
+  std::lock_guard<std::mutex> guard(write_back_latch_);
+  // drop finished write-backs once there are more than frames
+  if (write_backs_.size() >= pool_size_) {
+    for (auto it = write_backs_.begin(); it != write_backs_.end();) {
+      if (it->second.wait_for(std::chrono::seconds(0)) ==
+          std::future_status::ready)
+        it = write_backs_.erase(it);
+      else
+        ++it;
+    }
+  }
+  write_backs_[page_id] = write;
+}
+
+/*
+ * Helper function to wait until no write-back of page_id is in flight
+ * return whether there was a write-back to wait for
+ */
+bool BufferPoolManager::WaitForWriteBack(page_id_t page_id) {
+  std::shared_future<bool> write;
+  {
+    std::lock_guard<std::mutex> guard(write_back_latch_);
+    auto it = write_backs_.find(page_id);
+    if (it == write_backs_.end())
+      return false;
+    write = it->second;
+    write_backs_.erase(it);
+  }
+  // it may still sit in another thread's unsubmitted batch
+  async_disk_manager_.Submit();
+  write.wait();
+  return true;
+}
+
+/*
+ * Helper function to wait until the prefetch read of page_id, if any, has
+ * filled its frame
+ * NOTE: caller must hold the shard latch
+ * return whether there was a read to wait for
+ */
+bool BufferPoolManager::WaitForRead(BufferPoolShard *shard, page_id_t page_id) {
+  if (shard->pending_reads_.empty())
+    return false;
+  auto it = shard->pending_reads_.find(page_id);
+  if (it == shard->pending_reads_.end())
+    return false;
+  // it may still sit in another thread's unsubmitted batch
+  async_disk_manager_.Submit();
+  it->second.wait();
+  shard->pending_reads_.erase(it);
+  Page *page = nullptr;
+  if (shard->page_table_->Find(page_id, page))
+    page->read_pending_ = false;
+  return true;
+}
+
+/*
+ * Helper function to get count unused frames, released frames are reclaimed
+ * before a new arena is mapped
+ * throws std::bad_alloc if the arena cannot be mapped, no frames are taken
+ */
+std::vector<Page *> BufferPoolManager::AcquireFrames(size_t count) {
+  std::vector<Page *> frames;
+  std::lock_guard<std::mutex> guard(arena_latch_);
+  for (auto &arena : arenas_) {
+    Page *page;
+    while (frames.size() < count && (page = arena->ReclaimFrame()) != nullptr)
+      frames.push_back(page);
+  }
+  if (frames.size() < count) {
+    std::unique_ptr<FrameArena> arena;
+    try {
+      arena.reset(new FrameArena(count - frames.size()));
+    } catch (std::bad_alloc &) {
+      // hand the reclaimed frames back before giving up
+      for (auto page : frames) {
+        for (auto &owner : arenas_) {
+          if (owner->Contains(page))
+            owner->ReleaseFrame(page);
+        }
+      }
+      throw;
+    }
+    arenas_.push_back(std::move(arena));
+    FrameArena *added = arenas_.back().get();
+    for (size_t i = 0; i < added->GetNumFrames(); ++i)
+      frames.push_back(&added->GetPages()[i]);
+  }
+  return frames;
+}
+
+/*
+ * Helper function to hand unused frames back to their arenas, an arena is
+ * unmapped once all of its frames are released
+ */
+void BufferPoolManager::ReleaseFrames(const std::vector<Page *> &frames) {
+  if (frames.empty())
+    return;
+  std::lock_guard<std::mutex> guard(arena_latch_);
+  for (auto page : frames) {
+    auto it = std::find_if(
+        arenas_.begin(), arenas_.end(),
+        [page](const std::unique_ptr<FrameArena> &arena) {
+          return arena->Contains(page);
+        });
+    assert(it != arenas_.end());
+    (*it)->ReleaseFrame(page);
+    if ((*it)->GetNumReleased() == (*it)->GetNumFrames()) {
+      // a lock-free lookup may still hold one of its frames, only the
+      // contents go away
+      (*it)->ReleaseContents();
+      retired_arenas_.push_back(std::move(*it));
+      arenas_.erase(it);
+    }
+  }
+}
+
+/*
+ * Helper function to release frames of a shard holding more than its target
+ * size, free frames first and then replacer victims
+ * NOTE: caller must hold the shard latch
+ */
+void BufferPoolManager::ReleaseExcessFrames(BufferPoolShard *shard) {
+  if (shard->frames_.size() <= shard->target_size_)
+    return;
+  std::vector<Page *> frames;
+  while (shard->frames_.size() - frames.size() > shard->target_size_) {
+    Page *page = nullptr;
+    if (!shard->free_list_->empty()) {
+      page = shard->free_list_->front();
+      shard->free_list_->pop_front();
+    } else if (shard->replacer_->Victim(page)) {
+      if (!ClaimFrame(page))
+        continue;
+      EvictPage(shard, page);
+      page->page_id_ = INVALID_PAGE_ID;
+    } else {
+      break;
+    }
+    frames.push_back(page);
+  }
+  if (frames.empty())
+    return;
+  std::unordered_set<Page *> released(frames.begin(), frames.end());
+  shard->frames_.erase(std::remove_if(shard->frames_.begin(),
+                                      shard->frames_.end(),
+                                      [&released](Page *page) {
+                                        return released.count(page) != 0;
+                                      }),
+                       shard->frames_.end());
+  // write-backs of dirty victims work on copies, the frames can go right away
+  async_disk_manager_.Submit();
+  ReleaseFrames(frames);
+}
+
+/*
+ * Set the dirty flag of a frame and keep the dirty list of its shard and the
+ * count of dirty frames, the flusher is woken up when the count exceeds the
+ * high watermark
+ * NOTE: caller must hold the shard latch, the page id of the frame is valid
+ */
+void BufferPoolManager::SetDirty(Page *page, bool is_dirty) {
+  if (page->is_dirty_ == is_dirty)
+    return;
+  page->is_dirty_ = is_dirty;
+  BufferPoolShard *shard = GetShard(page->page_id_);
+  if (!is_dirty) {
+    shard->dirty_pages_.erase(page->page_id_);
+    dirty_count_--;
+    return;
+  }
+  shard->dirty_pages_[page->page_id_] = page;
+  if (++dirty_count_ > high_watermark_.load() * pool_size_) {
+    {
+      std::lock_guard<std::mutex> guard(flusher_latch_);
+      flush_requested_ = true;
+    }
+    flusher_cv_.notify_one();
+  }
+}
+
+/*
+ * Change the dirty watermarks of the background flusher, out of range values
+ * are clamped
+ */
+void BufferPoolManager::SetDirtyWatermarks(double low, double high) {
+  high = std::min(std::max(high, 0.0), 1.0);
+  low = std::min(std::max(low, 0.0), high);
+  low_watermark_ = low;
+  high_watermark_ = high;
+  {
+    std::lock_guard<std::mutex> guard(flusher_latch_);
+    flush_requested_ = true;
+  }
+  flusher_cv_.notify_one();
+}
+
+/*
+ * Body of the background flusher thread: every FLUSH_INTERVAL, or as soon
+ * as it is asked to, clean dirty pages down to the low watermark
+ */
+void BufferPoolManager::FlusherLoop() {
+  std::unique_lock<std::mutex> lock(flusher_latch_);
+  while (true) {
+    flusher_cv_.wait_for(lock, FLUSH_INTERVAL,
+                         [this] { return stop_flusher_ || flush_requested_; });
+    if (stop_flusher_)
+      return;
+    flush_requested_ = false;
+    lock.unlock();
+    // one batch at a time, foreground threads get the latches in between
+    size_t target = static_cast<size_t>(low_watermark_.load() * pool_size_);
+    while (dirty_count_.load() > target) {
+      size_t excess = dirty_count_.load() - target;
+      if (CleanDirtyPages(std::min(excess, MAX_COALESCED_PAGES * 4)) == 0)
+        break;
+    }
+    lock.lock();
+  }
+}
+
+/*
+ * Write back up to max_pages dirty unpinned pages, the lowest page ids of
+ * every shard first. Shards are latched one at a time and only their dirty
+ * lists are walked, pinned pages are skipped. The writes are submitted
+ * together once all shards are done, so the async disk manager merges runs of
+ * consecutive page ids across shards into one write outside the shard
+ * latches.
+ * return number of pages cleaned
+ */
+size_t BufferPoolManager::CleanDirtyPages(size_t max_pages) {
+  size_t quota = (max_pages + shards_.size() - 1) / shards_.size();
+  size_t cleaned = 0;
+  for (auto shard : shards_) {
+    std::lock_guard<std::mutex> guard(shard->latch_);
+    size_t count = 0;
+    for (auto it = shard->dirty_pages_.begin();
+         it != shard->dirty_pages_.end() && count < quota;) {
+      // SetDirty erases the entry
+      Page *page = (it++)->second;
+      // claiming keeps lock-free pins off the frame while it is copied, the
+      // page stays in the replacer meanwhile
+      if (!ClaimFrame(page))
+        continue;
+      WriteBackAsync(page);
+      SetDirty(page, false);
+      page->pin_count_ = 0;
+      count++;
+    }
+    cleaned += count;
+  }
+  async_disk_manager_.Submit();
+  return cleaned;
+}
 } // namespace cmudb
@@ -0,0 +1,60 @@
+/**
+ * buffer_pool_stats.cpp
+ */
+#include <new>
+
+#include "buffer/buffer_pool_stats.h"
+
+namespace cmudb {
+
+constexpr size_t BufferPoolStats::NUM_SLOTS;
+
+/*
+ * Constructor: over-allocate by one cache line and place the slots at the
+ * first cache line boundary, plain new does not align beyond max_align_t
+ */
+BufferPoolStats::BufferPoolStats()
+    : memory_(new char[NUM_SLOTS * sizeof(Slot) + CACHE_LINE_SIZE]) {
+  uintptr_t start = reinterpret_cast<uintptr_t>(memory_.get());
+  uintptr_t aligned = (start + CACHE_LINE_SIZE - 1) &
+                      ~static_cast<uintptr_t>(CACHE_LINE_SIZE - 1);
+  slots_ = reinterpret_cast<Slot *>(aligned);
+  for (size_t i = 0; i < NUM_SLOTS; ++i)
+    new (&slots_[i]) Slot();
+}
+
+uint64_t BufferPoolStats::Get(Counter counter) const {
+  uint64_t sum = 0;
+  for (size_t i = 0; i < NUM_SLOTS; ++i)
+    sum += slots_[i].counters_[counter].load(std::memory_order_relaxed);
+  return sum;
+}
+
+const char *BufferPoolStats::GetName(Counter counter) {
+  switch (counter) {
+  case HITS:
+    return "hits";
+  case MISSES:
+    return "misses";
+  case EVICTIONS:
+    return "evictions";
+  case WRITE_BACKS:
+    return "write_backs";
+  case PIN_WAITS:
+    return "pin_waits";
+  default:
+    return "unknown";
+  }
+}
+
+/*
+ * Helper function to pick the slot of the calling thread, slots are handed
+ * out round robin on a thread's first increment
+ */
+size_t BufferPoolStats::GetSlotIndex() {
+  static std::atomic<size_t> next_slot{0};
+  thread_local size_t slot = next_slot.fetch_add(1) % NUM_SLOTS;
+  return slot;
+}
+
+} // namespace cmudb
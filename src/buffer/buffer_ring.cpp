@@ -0,0 +1,30 @@
+/**
+ * buffer_ring.cpp
+ */
+#include "buffer/buffer_ring.h"
+#include "buffer/buffer_pool_manager.h"
+
+namespace cmudb {
+
+/*
+ * BufferRing Constructor
+ * size: number of frames the ring may take from the pool, clamped to
+ * [num_shards, pool_size / 4] so a ring never starves the pool
+ */
+BufferRing::BufferRing(BufferPoolManager *buffer_pool_manager, size_t size)
+    : buffer_pool_manager_(buffer_pool_manager) {
+  size_t num_shards = buffer_pool_manager_->GetNumShards();
+  size_t max_size = buffer_pool_manager_->GetPoolSize() / 4;
+  if (size > max_size)
+    size = max_size;
+  shard_capacity_ = (size + num_shards - 1) / num_shards;
+  if (shard_capacity_ == 0)
+    shard_capacity_ = 1;
+  size_ = shard_capacity_ * num_shards;
+  frames_.resize(num_shards);
+  next_victim_.resize(num_shards, 0);
+}
+
+BufferRing::~BufferRing() { buffer_pool_manager_->ReleaseBufferRing(this); }
+
+} // namespace cmudb
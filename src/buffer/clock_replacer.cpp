@@ -0,0 +1,91 @@
+/**
+ * CLOCK implementation
+ */
+#include "buffer/clock_replacer.h"
+#include "page/page.h"
+
+namespace cmudb {
+
+template <typename T> ClockReplacer<T>::ClockReplacer() {}
+
+template <typename T> ClockReplacer<T>::~ClockReplacer() {}
+
+/*
+ * Put value on the ring (if not there yet), make it evictable and give it a
+ * second chance
+ */
+template <typename T> void ClockReplacer<T>::Insert(const T &value) {
+  std::lock_guard<std::mutex> guard(latch_);
+  auto it = slots_.find(value);
+  size_t slot;
+  if (it != slots_.end()) {
+    slot = it->second;
+  } else if (!free_slots_.empty()) {
+    slot = free_slots_.back();
+    free_slots_.pop_back();
+    slots_[value] = slot;
+  } else {
+    slot = ring_.size();
+    ring_.push_back(Slot());
+    slots_[value] = slot;
+  }
+  Slot &entry = ring_[slot];
+  if (!entry.in_use_ || !entry.evictable_)
+    evictable_count_++;
+  entry.value_ = value;
+  entry.in_use_ = true;
+  entry.evictable_ = true;
+  entry.referenced_ = true;
+}
+
+/*
+ * Sweep the clock hand until an evictable value with a clear reference bit is
+ * found. Terminates within two rotations when anything is evictable.
+ */
+template <typename T> bool ClockReplacer<T>::Victim(T &value) {
+  std::lock_guard<std::mutex> guard(latch_);
+  if (evictable_count_ == 0)
+    return false;
+  while (true) {
+    Slot &entry = ring_[hand_];
+    size_t slot = hand_;
+    hand_ = (hand_ + 1) % ring_.size();
+    if (!entry.in_use_ || !entry.evictable_)
+      continue;
+    if (entry.referenced_) {
+      entry.referenced_ = false;
+      continue;
+    }
+    value = entry.value_;
+    entry.in_use_ = false;
+    entry.evictable_ = false;
+    slots_.erase(value);
+    free_slots_.push_back(slot);
+    evictable_count_--;
+    return true;
+  }
+}
+
+/*
+ * Make value non-evictable (it got pinned), it keeps its slot on the ring
+ */
+template <typename T> bool ClockReplacer<T>::Erase(const T &value) {
+  std::lock_guard<std::mutex> guard(latch_);
+  auto it = slots_.find(value);
+  if (it == slots_.end() || !ring_[it->second].evictable_)
+    return false;
+  ring_[it->second].evictable_ = false;
+  evictable_count_--;
+  return true;
+}
+
+template <typename T> size_t ClockReplacer<T>::Size() {
+  std::lock_guard<std::mutex> guard(latch_);
+  return evictable_count_;
+}
+
+template class ClockReplacer<Page *>;
+// test only
+template class ClockReplacer<int>;
+
+} // namespace cmudb
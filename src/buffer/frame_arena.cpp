@@ -0,0 +1,124 @@
+/**
+ * frame_arena.cpp
+ */
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <sys/mman.h>
+
+#include "buffer/frame_arena.h"
+#include "common/logger.h"
+
+namespace cmudb {
+
+/**
+ * Constructor: map the page contents and the metadata array of num_frames
+ * frames. Huge pages are only tried for pools of at least one huge page, a
+ * small pool would waste most of a reserved huge page.
+ */
+FrameArena::FrameArena(size_t num_frames) : num_frames_(num_frames) {
+  if (num_frames_ == 0)
+    return;
+  data_size_ = num_frames_ * PAGE_SIZE;
+  if (data_size_ >= HUGE_PAGE_SIZE) {
+    data_size_ = (data_size_ + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE *
+                 HUGE_PAGE_SIZE;
+    data_ = static_cast<char *>(MapRegion(data_size_, true));
+    huge_pages_ = data_ != nullptr;
+    if (!huge_pages_) {
+      LOG_DEBUG("no huge pages available for %zu frames", num_frames_);
+    }
+  }
+  if (data_ == nullptr)
+    data_ = static_cast<char *>(MapRegion(data_size_, false));
+  pages_size_ = num_frames_ * sizeof(Page);
+  void *pages = MapRegion(pages_size_, false);
+  if (data_ == nullptr || pages == nullptr) {
+    if (data_ != nullptr)
+      munmap(data_, data_size_);
+    throw std::bad_alloc();
+  }
+  // anonymous memory is zeroed, no need to reset the page contents
+  pages_ = static_cast<Page *>(pages);
+  for (size_t i = 0; i < num_frames_; ++i)
+    new (&pages_[i]) Page(data_ + i * PAGE_SIZE);
+}
+
+FrameArena::~FrameArena() {
+  if (pages_ != nullptr) {
+    for (size_t i = 0; i < num_frames_; ++i)
+      pages_[i].~Page();
+    munmap(pages_, pages_size_);
+  }
+  if (data_ != nullptr)
+    munmap(data_, data_size_);
+}
+
+/*
+ * The content is dropped right away. Ordinary pages go back to the operating
+ * system, a huge page stays mapped as long as other frames share it.
+ */
+void FrameArena::ReleaseFrame(Page *page) {
+  if (huge_pages_)
+    memset(page->GetData(), 0, PAGE_SIZE);
+  else
+    madvise(page->GetData(), PAGE_SIZE, MADV_DONTNEED);
+  released_.push_back(page);
+}
+
+void FrameArena::ReleaseContents() {
+  if (data_ != nullptr)
+    munmap(data_, data_size_);
+  data_ = nullptr;
+  released_.clear();
+}
+
+Page *FrameArena::ReclaimFrame() {
+  if (released_.empty())
+    return nullptr;
+  Page *page = released_.back();
+  released_.pop_back();
+  return page;
+}
+
+/*
+ * Map size bytes of zeroed anonymous memory, or return nullptr. Without
+ * huge_pages a region of at least one huge page is still aligned to the huge
+ * page size so that transparent huge pages can back it.
+ */
+void *FrameArena::MapRegion(size_t size, bool huge_pages) {
+  const int prot = PROT_READ | PROT_WRITE;
+  const int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+  if (huge_pages) {
+#ifdef MAP_HUGETLB
+    void *region = mmap(nullptr, size, prot, flags | MAP_HUGETLB, -1, 0);
+    return region == MAP_FAILED ? nullptr : region;
+#else
+    return nullptr;
+#endif
+  }
+  if (size < HUGE_PAGE_SIZE) {
+    void *region = mmap(nullptr, size, prot, flags, -1, 0);
+    return region == MAP_FAILED ? nullptr : region;
+  }
+
+  // over-map by one huge page and cut the aligned part out of it
+  size_t mapped_size = size + HUGE_PAGE_SIZE;
+  void *region = mmap(nullptr, mapped_size, prot, flags, -1, 0);
+  if (region == MAP_FAILED)
+    return nullptr;
+  uintptr_t start = reinterpret_cast<uintptr_t>(region);
+  uintptr_t aligned = (start + HUGE_PAGE_SIZE - 1) &
+                      ~static_cast<uintptr_t>(HUGE_PAGE_SIZE - 1);
+  if (aligned > start)
+    munmap(region, aligned - start);
+  size_t tail = start + mapped_size - (aligned + size);
+  if (tail > 0)
+    munmap(reinterpret_cast<void *>(aligned + size), tail);
+#ifdef MADV_HUGEPAGE
+  madvise(reinterpret_cast<void *>(aligned), size, MADV_HUGEPAGE);
+#endif
+  return reinterpret_cast<void *>(aligned);
+}
+
+} // namespace cmudb
@@ -0,0 +1,95 @@
+/**
+ * LRU-K implementation
+ */
+#include "buffer/lru_k_replacer.h"
+#include "page/page.h"
+
+namespace cmudb {
+
+template <typename T>
+LRUKReplacer<T>::LRUKReplacer(size_t k, uint64_t correlated_period)
+    : k_(k == 0 ? 1 : k), correlated_period_(correlated_period) {}
+
+template <typename T> LRUKReplacer<T>::~LRUKReplacer() {}
+
+/*
+ * Record a reference to value and make it evictable
+ */
+template <typename T> void LRUKReplacer<T>::Insert(const T &value) {
+  std::lock_guard<std::mutex> guard(latch_);
+  uint64_t now = ++current_timestamp_;
+  History &history = history_[value];
+  if (history.evictable_)
+    Dequeue(value, history);
+
+  auto &timestamps = history.timestamps_;
+  if (!timestamps.empty() && now - timestamps.back() <= correlated_period_) {
+    timestamps.back() = now;
+  } else {
+    timestamps.push_back(now);
+    if (timestamps.size() > k_)
+      timestamps.pop_front();
+  }
+  history.evictable_ = true;
+  Enqueue(value, history);
+}
+
+/*
+ * Evict the value with the largest backward K-distance, values with fewer than
+ * K references go first. The history of the victim is forgotten.
+ */
+template <typename T> bool LRUKReplacer<T>::Victim(T &value) {
+  std::lock_guard<std::mutex> guard(latch_);
+  auto &queue = cold_queue_.empty() ? hot_queue_ : cold_queue_;
+  if (queue.empty())
+    return false;
+  value = queue.begin()->second;
+  queue.erase(queue.begin());
+  history_.erase(value);
+  return true;
+}
+
+/*
+ * Make value non-evictable (it got pinned). Its reference history is kept so
+ * it competes with its full history once unpinned again.
+ */
+template <typename T> bool LRUKReplacer<T>::Erase(const T &value) {
+  std::lock_guard<std::mutex> guard(latch_);
+  auto it = history_.find(value);
+  if (it == history_.end() || !it->second.evictable_)
+    return false;
+  Dequeue(value, it->second);
+  it->second.evictable_ = false;
+  return true;
+}
+
+template <typename T> size_t LRUKReplacer<T>::Size() {
+  std::lock_guard<std::mutex> guard(latch_);
+  return cold_queue_.size() + hot_queue_.size();
+}
+
+template <typename T>
+std::pair<uint64_t, T> LRUKReplacer<T>::QueueKey(const T &value,
+                                                 const History &history) {
+  // with k_ references the front is the k-th most recent one, otherwise it is
+  // the first reference
+  return std::make_pair(history.timestamps_.front(), value);
+}
+
+template <typename T>
+void LRUKReplacer<T>::Enqueue(const T &value, const History &history) {
+  auto &queue = history.timestamps_.size() < k_ ? cold_queue_ : hot_queue_;
+  queue.insert(QueueKey(value, history));
+}
+
+template <typename T>
+void LRUKReplacer<T>::Dequeue(const T &value, const History &history) {
+  auto &queue = history.timestamps_.size() < k_ ? cold_queue_ : hot_queue_;
+  queue.erase(QueueKey(value, history));
+}
+
+template class LRUKReplacer<Page *>;
+// test only
+template class LRUKReplacer<int>;
+
+} // namespace cmudb
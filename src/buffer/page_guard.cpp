@@ -0,0 +1,96 @@
+/**
+ * page_guard.cpp
+ */
+#include "buffer/page_guard.h"
+#include "buffer/buffer_pool_manager.h"
+
+namespace cmudb {
+
+void PageGuard::MoveFrom(PageGuard &other) {
+  buffer_pool_manager_ = other.buffer_pool_manager_;
+  page_ = other.page_;
+  other.buffer_pool_manager_ = nullptr;
+  other.page_ = nullptr;
+}
+
+ReadPageGuard &ReadPageGuard::operator=(ReadPageGuard &&other) {
+  if (this != &other) {
+    Release();
+    MoveFrom(other);
+  }
+  return *this;
+}
+
+void ReadPageGuard::Release() {
+  if (page_ == nullptr)
+    return;
+  page_->RUnlatch();
+  buffer_pool_manager_->UnpinPage(page_->GetPageId(), false);
+  page_ = nullptr;
+}
+
+WritePageGuard::WritePageGuard(WritePageGuard &&other)
+    : is_dirty_(other.is_dirty_) {
+  MoveFrom(other);
+}
+
+WritePageGuard &WritePageGuard::operator=(WritePageGuard &&other) {
+  if (this != &other) {
+    Release();
+    MoveFrom(other);
+    is_dirty_ = other.is_dirty_;
+  }
+  return *this;
+}
+
+void WritePageGuard::Release() {
+  if (page_ == nullptr)
+    return;
+  page_->WUnlatch();
+  buffer_pool_manager_->UnpinPage(page_->GetPageId(), is_dirty_);
+  page_ = nullptr;
+}
+
+OptimisticPageGuard::OptimisticPageGuard(
+    BufferPoolManager *buffer_pool_manager, Page *page)
+    : PageGuard(buffer_pool_manager, page) {
+  if (page_ != nullptr)
+    Restart();
+}
+
+OptimisticPageGuard::OptimisticPageGuard(OptimisticPageGuard &&other)
+    : version_(other.version_) {
+  MoveFrom(other);
+}
+
+OptimisticPageGuard &OptimisticPageGuard::
+operator=(OptimisticPageGuard &&other) {
+  if (this != &other) {
+    Release();
+    MoveFrom(other);
+    version_ = other.version_;
+  }
+  return *this;
+}
+
+/*
+ * Remember the current version. While a writer holds the page the read latch
+ * is taken once to sleep until it is done instead of spinning.
+ */
+void OptimisticPageGuard::Restart() {
+  version_ = page_->GetVersion();
+  if ((version_ & 1) == 0)
+    return;
+  page_->RLatch();
+  version_ = page_->GetVersion();
+  page_->RUnlatch();
+}
+
+void OptimisticPageGuard::Release() {
+  if (page_ == nullptr)
+    return;
+  buffer_pool_manager_->UnpinPage(page_->GetPageId(), false);
+  page_ = nullptr;
+}
+
+} // namespace cmudb
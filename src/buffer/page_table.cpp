@@ -0,0 +1,158 @@
+/**
+ * page_table.cpp
+ */
+#include <cstdint>
+
+#include "buffer/page_table.h"
+
+namespace cmudb {
+
+constexpr page_id_t PageTable::MOVING_PAGE_ID;
+
+/*
+ * Constructor: room for capacity entries at a load factor of at most one
+ * half
+ */
+PageTable::PageTable(size_t capacity) {
+  size_t slots = 16;
+  while (slots < capacity * 2)
+    slots *= 2;
+  arrays_.emplace_back(new Slots(slots));
+  slots_.store(arrays_.back().get(), std::memory_order_release);
+}
+
+/*
+ * Lock-free lookup, see the header for what a concurrent writer may cause
+ */
+bool PageTable::Find(const page_id_t &page_id, Page *&page) {
+  Slots *slots = slots_.load(std::memory_order_acquire);
+  size_t mask = slots->capacity_ - 1;
+  size_t index = HashIndex(page_id, slots->capacity_);
+  for (size_t i = 0; i < slots->capacity_; ++i) {
+    Slot &slot = slots->slots_[(index + i) & mask];
+    page_id_t slot_page_id = slot.page_id_.load(std::memory_order_acquire);
+    if (slot_page_id == INVALID_PAGE_ID)
+      return false;
+    if (slot_page_id != page_id)
+      continue;
+    Page *slot_page = slot.page_.load(std::memory_order_relaxed);
+    // the slot must not have been rewritten while its frame was read
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (slot.page_id_.load(std::memory_order_relaxed) != page_id)
+      return false;
+    page = slot_page;
+    return true;
+  }
+  return false;
+}
+
+/*
+ * Remove page_id and close the gap: later entries of the cluster move back
+ * unless that would put them before their home slot
+ */
+bool PageTable::Remove(const page_id_t &page_id) {
+  Slots *slots = slots_.load(std::memory_order_relaxed);
+  size_t mask = slots->capacity_ - 1;
+  size_t hole = HashIndex(page_id, slots->capacity_);
+  while (true) {
+    page_id_t slot_page_id =
+        slots->slots_[hole].page_id_.load(std::memory_order_relaxed);
+    if (slot_page_id == INVALID_PAGE_ID)
+      return false;
+    if (slot_page_id == page_id)
+      break;
+    hole = (hole + 1) & mask;
+  }
+
+  size_t next = hole;
+  while (true) {
+    next = (next + 1) & mask;
+    Slot &slot = slots->slots_[next];
+    page_id_t slot_page_id = slot.page_id_.load(std::memory_order_relaxed);
+    if (slot_page_id == INVALID_PAGE_ID)
+      break;
+    size_t home = HashIndex(slot_page_id, slots->capacity_);
+    // the entry may only move if its home is not within (hole, next]
+    if (((next - home) & mask) < ((next - hole) & mask))
+      continue;
+    // the hole still shows the id it held, a concurrent Find must not pair
+    // it with the frame moved in
+    Slot &target = slots->slots_[hole];
+    target.page_id_.store(MOVING_PAGE_ID, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    target.page_.store(slot.page_.load(std::memory_order_relaxed),
+                       std::memory_order_relaxed);
+    target.page_id_.store(slot_page_id, std::memory_order_release);
+    hole = next;
+  }
+  slots->slots_[hole].page_id_.store(INVALID_PAGE_ID,
+                                     std::memory_order_release);
+  size_--;
+  return true;
+}
+
+/*
+ * Insert or overwrite the frame of page_id. The frame is published before
+ * the page id so that a concurrent Find never sees a half written slot.
+ */
+void PageTable::Insert(const page_id_t &page_id, Page *const &page) {
+  if ((size_ + 1) * 2 > slots_.load(std::memory_order_relaxed)->capacity_)
+    Grow();
+  Slots *slots = slots_.load(std::memory_order_relaxed);
+  size_t mask = slots->capacity_ - 1;
+  size_t index = HashIndex(page_id, slots->capacity_);
+  while (true) {
+    Slot &slot = slots->slots_[index];
+    page_id_t slot_page_id = slot.page_id_.load(std::memory_order_relaxed);
+    if (slot_page_id == page_id) {
+      slot.page_.store(page, std::memory_order_release);
+      return;
+    }
+    if (slot_page_id == INVALID_PAGE_ID) {
+      slot.page_.store(page, std::memory_order_relaxed);
+      slot.page_id_.store(page_id, std::memory_order_release);
+      size_++;
+      return;
+    }
+    index = (index + 1) & mask;
+  }
+}
+
+/*
+ * Helper function to spread page ids over the slots. Page ids of a shard are
+ * strided by the shard count, a multiplicative hash keeps them apart.
+ */
+size_t PageTable::HashIndex(page_id_t page_id, size_t capacity) {
+  uint64_t hash =
+      static_cast<uint64_t>(static_cast<uint32_t>(page_id)) *
+      UINT64_C(0x9E3779B97F4A7C15);
+  return static_cast<size_t>(hash >> 32) & (capacity - 1);
+}
+
+/*
+ * Helper function to move all entries to an array of twice the capacity, the
+ * old array stays readable for concurrent lookups
+ */
+void PageTable::Grow() {
+  Slots *old_slots = slots_.load(std::memory_order_relaxed);
+  auto new_slots = new Slots(old_slots->capacity_ * 2);
+  size_t mask = new_slots->capacity_ - 1;
+  for (size_t i = 0; i < old_slots->capacity_; ++i) {
+    Slot &slot = old_slots->slots_[i];
+    page_id_t page_id = slot.page_id_.load(std::memory_order_relaxed);
+    if (page_id == INVALID_PAGE_ID)
+      continue;
+    size_t index = HashIndex(page_id, new_slots->capacity_);
+    while (new_slots->slots_[index].page_id_.load(std::memory_order_relaxed) !=
+           INVALID_PAGE_ID)
+      index = (index + 1) & mask;
+    new_slots->slots_[index].page_.store(
+        slot.page_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    new_slots->slots_[index].page_id_.store(page_id,
+                                            std::memory_order_relaxed);
+  }
+  arrays_.emplace_back(new_slots);
+  slots_.store(new_slots, std::memory_order_release);
+}
+
+} // namespace cmudb
@@ -0,0 +1,111 @@
+/**
+ * 2Q implementation
+ */
+#include "buffer/two_queue_replacer.h"
+#include "page/page.h"
+
+namespace cmudb {
+
+template <typename T>
+TwoQueueReplacer<T>::TwoQueueReplacer(size_t a1_max)
+    : a1_max_(a1_max == 0 ? 1 : a1_max) {}
+
+template <typename T> TwoQueueReplacer<T>::~TwoQueueReplacer() {}
+
+/*
+ * Record a reference to value and make it evictable. A value already in A1
+ * moves to the tail of Am unless the reference is correlated with the
+ * previous one.
+ */
+template <typename T> void TwoQueueReplacer<T>::Insert(const T &value) {
+  std::lock_guard<std::mutex> guard(latch_);
+  bool correlated = has_last_ && last_ == value;
+  has_last_ = true;
+  last_ = value;
+
+  auto it = entries_.find(value);
+  if (it == entries_.end()) {
+    Entry &entry = entries_[value];
+    a1_list_.push_back(value);
+    entry.pos_ = std::prev(a1_list_.end());
+    entry.evictable_ = true;
+    a1_count_++;
+    return;
+  }
+
+  Entry &entry = it->second;
+  if (entry.evictable_)
+    (entry.in_am_ ? am_list_ : a1_list_).erase(entry.pos_);
+  if (!entry.in_am_ && !correlated) {
+    entry.in_am_ = true;
+    a1_count_--;
+  }
+  auto &list = entry.in_am_ ? am_list_ : a1_list_;
+  list.push_back(value);
+  entry.pos_ = std::prev(list.end());
+  entry.evictable_ = true;
+}
+
+/*
+ * Evict the head of A1 while A1 exceeds its share, the least recently used
+ * value of Am otherwise. The victim is forgotten.
+ */
+template <typename T> bool TwoQueueReplacer<T>::Victim(T &value) {
+  std::lock_guard<std::mutex> guard(latch_);
+  if (!a1_list_.empty() && (a1_count_ > a1_max_ || am_list_.empty())) {
+    value = a1_list_.front();
+    a1_list_.pop_front();
+  } else if (!am_list_.empty()) {
+    value = am_list_.front();
+    am_list_.pop_front();
+  } else {
+    return false;
+  }
+  Forget(value);
+  return true;
+}
+
+/*
+ * Make value non-evictable (it got pinned), its queue membership is kept
+ */
+template <typename T> bool TwoQueueReplacer<T>::Erase(const T &value) {
+  std::lock_guard<std::mutex> guard(latch_);
+  auto it = entries_.find(value);
+  if (it == entries_.end() || !it->second.evictable_)
+    return false;
+  (it->second.in_am_ ? am_list_ : a1_list_).erase(it->second.pos_);
+  it->second.evictable_ = false;
+  return true;
+}
+
+template <typename T> size_t TwoQueueReplacer<T>::Size() {
+  std::lock_guard<std::mutex> guard(latch_);
+  return a1_list_.size() + am_list_.size();
+}
+
+/*
+ * The new share only affects which queue later victims come from, values
+ * already in A1 stay there
+ */
+template <typename T> void TwoQueueReplacer<T>::SetA1Max(size_t a1_max) {
+  std::lock_guard<std::mutex> guard(latch_);
+  a1_max_ = a1_max == 0 ? 1 : a1_max;
+}
+
+/*
+ * helper function to drop all knowledge about an evicted value
+ */
+template <typename T> void TwoQueueReplacer<T>::Forget(const T &value) {
+  auto it = entries_.find(value);
+  if (!it->second.in_am_)
+    a1_count_--;
+  entries_.erase(it);
+  if (has_last_ && last_ == value)
+    has_last_ = false;
+}
+
+template class TwoQueueReplacer<Page *>;
+// test only
+template class TwoQueueReplacer<int>;
+
+} // namespace cmudb
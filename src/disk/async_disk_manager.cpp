@@ -0,0 +1,507 @@
+/**
+ * async_disk_manager.cpp
+ */
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <sys/uio.h>
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define CMUDB_HAVE_IO_URING
+#endif
+#endif
+
+#ifdef CMUDB_HAVE_IO_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "common/logger.h"
+#include "disk/async_disk_manager.h"
+
+namespace cmudb {
+
+constexpr size_t AsyncDiskManager::MAX_MERGED_PAGES;
+
+// one queued page transfer
+struct AsyncRequest {
+  bool is_write_;
+  page_id_t page_id_;
+  size_t num_pages_ = 1;
+  // read target, or the private copy of the data to write
+  char *data_;
+  std::unique_ptr<char[]> write_buffer_;
+  // data_, followed by the data of the merged writes
+  std::vector<struct iovec> iovs_;
+  std::promise<bool> promise_;
+  // earlier writes of the same pages that have not completed yet
+  int blockers_ = 0;
+  // Submit() has seen the request, dispatch it once blockers_ drops to zero
+  bool submitted_ = false;
+  // requests waiting for this one to complete
+  std::vector<AsyncRequest *> followers_;
+  // writes of the pages right after this one's, done by the same transfer
+  std::vector<AsyncRequest *> merged_;
+};
+
+namespace {
+// bytes moved by the transfer of request, including merged writes
+size_t TransferLength(const AsyncRequest *request) {
+  size_t length = 0;
+  for (auto &iov : request->iovs_)
+    length += iov.iov_len;
+  return length;
+}
+} // namespace
+
+#ifdef CMUDB_HAVE_IO_URING
+namespace {
+int IoUringSetup(unsigned entries, struct io_uring_params *params) {
+  return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+int IoUringEnter(int ring_fd, unsigned to_submit, unsigned min_complete,
+                 unsigned flags) {
+  return static_cast<int>(syscall(__NR_io_uring_enter, ring_fd, to_submit,
+                                  min_complete, flags, nullptr, 0));
+}
+
+unsigned *RingField(void *ring, unsigned offset) {
+  return reinterpret_cast<unsigned *>(static_cast<char *>(ring) + offset);
+}
+} // namespace
+#endif
+
+/**
+ * Constructor: try to set up an io_uring with queue_depth submission entries,
+ * otherwise start num_threads blocking I/O workers
+ */
+AsyncDiskManager::AsyncDiskManager(DiskManager *disk_manager,
+                                   unsigned queue_depth, size_t num_threads)
+    : disk_manager_(disk_manager) {
+  if (SetupRing(queue_depth)) {
+    reaper_ = std::thread(&AsyncDiskManager::ReapCompletions, this);
+    return;
+  }
+  LOG_DEBUG("io_uring unavailable, using %zu I/O threads", num_threads);
+  if (num_threads == 0)
+    num_threads = 1;
+  for (size_t i = 0; i < num_threads; ++i)
+    workers_.push_back(std::thread(&AsyncDiskManager::WorkerLoop, this));
+}
+
+/**
+ * Destructor: submit whatever is still queued and wait for all of it
+ */
+AsyncDiskManager::~AsyncDiskManager() {
+  Submit();
+  {
+    std::unique_lock<std::mutex> lock(latch_);
+    shutdown_ = true;
+#ifdef CMUDB_HAVE_IO_URING
+    if (ring_fd_ >= 0) {
+      ring_space_.wait(
+          lock, [this] { return in_flight_ == 0 && ring_queue_.empty(); });
+      // a nop without request wakes the reaper up for the last time
+      unsigned tail = *sq_tail_;
+      unsigned index = tail & *sq_mask_;
+      auto sqe = static_cast<struct io_uring_sqe *>(sqes_ptr_) + index;
+      memset(sqe, 0, sizeof(*sqe));
+      sqe->opcode = IORING_OP_NOP;
+      sqe->user_data = 0;
+      sq_array_[index] = index;
+      __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+      IoUringEnter(ring_fd_, 1, 0, 0);
+    }
+#endif
+  }
+  ready_cv_.notify_all();
+  if (reaper_.joinable())
+    reaper_.join();
+  for (auto &worker : workers_)
+    worker.join();
+  TeardownRing();
+}
+
+/**
+ * Queue a read of page_id into page_data. Pages beyond the end of the file
+ * complete immediately as zeroed pages, unless a write of them is queued.
+ */
+std::future<bool> AsyncDiskManager::ReadPageAsync(page_id_t page_id,
+                                                  char *page_data) {
+  AsyncRequest *request = new AsyncRequest();
+  request->is_write_ = false;
+  request->page_id_ = page_id;
+  request->data_ = page_data;
+  bool beyond_end = false;
+  if (static_cast<int64_t>(page_id) * PAGE_SIZE >=
+      disk_manager_->GetFileSize()) {
+    std::lock_guard<std::mutex> guard(latch_);
+    beyond_end = last_writes_.find(page_id) == last_writes_.end();
+  }
+  if (beyond_end) {
+    memset(page_data, 0, PAGE_SIZE);
+    std::future<bool> future = request->promise_.get_future();
+    request->promise_.set_value(true);
+    delete request;
+    return future;
+  }
+  return Enqueue(request);
+}
+
+/**
+ * Queue a write of a private copy of page_data to page_id. The header page is
+ * written synchronously, the disk manager keeps its trailer up to date.
+ */
+std::future<bool> AsyncDiskManager::WritePageAsync(page_id_t page_id,
+                                                   const char *page_data) {
+  AsyncRequest *request = new AsyncRequest();
+  request->is_write_ = true;
+  request->page_id_ = page_id;
+  if (page_id == HEADER_PAGE_ID) {
+    disk_manager_->WritePage(page_id, page_data);
+    std::future<bool> future = request->promise_.get_future();
+    request->promise_.set_value(true);
+    delete request;
+    return future;
+  }
+  request->write_buffer_.reset(new char[PAGE_SIZE]);
+  memcpy(request->write_buffer_.get(), page_data, PAGE_SIZE);
+  request->data_ = request->write_buffer_.get();
+  return Enqueue(request);
+}
+
+/**
+ * Hand every request queued so far to the backend. With io_uring the whole
+ * batch costs a single io_uring_enter call (more if it exceeds the ring).
+ * Writes still waiting for an earlier write of the same page are dispatched
+ * by the completion of that write instead.
+ */
+void AsyncDiskManager::Submit() {
+  std::lock_guard<std::mutex> guard(latch_);
+  if (pending_.empty())
+    return;
+  std::vector<AsyncRequest *> batch;
+  for (auto request : pending_) {
+    request->submitted_ = true;
+    if (request->blockers_ == 0)
+      batch.push_back(request);
+  }
+  pending_.clear();
+  Dispatch(batch);
+}
+
+/**
+ * Queue a single write covering pages.size() pages from page_id on. A run
+ * starting at the header page is written synchronously like WritePageAsync.
+ */
+std::future<bool>
+AsyncDiskManager::WritePagesAsync(page_id_t page_id,
+                                  const std::vector<const char *> &pages) {
+  AsyncRequest *request = new AsyncRequest();
+  request->is_write_ = true;
+  request->page_id_ = page_id;
+  request->num_pages_ = pages.size();
+  request->write_buffer_.reset(new char[pages.size() * PAGE_SIZE]);
+  for (size_t i = 0; i < pages.size(); ++i)
+    memcpy(request->write_buffer_.get() + i * PAGE_SIZE, pages[i], PAGE_SIZE);
+  request->data_ = request->write_buffer_.get();
+  if (page_id == HEADER_PAGE_ID || pages.empty()) {
+    disk_manager_->WritePages(page_id, request->data_, request->num_pages_);
+    std::future<bool> future = request->promise_.get_future();
+    request->promise_.set_value(true);
+    delete request;
+    return future;
+  }
+  return Enqueue(request);
+}
+
+/*
+ * Private helper function queueing request until the next Submit(). A request
+ * touching a page with an incomplete earlier write is chained behind that
+ * write, so writes of one page reach the disk in the order they were queued
+ * and a read sees the last of them.
+ */
+std::future<bool> AsyncDiskManager::Enqueue(AsyncRequest *request) {
+  request->iovs_.push_back({request->data_, request->num_pages_ * PAGE_SIZE});
+  std::future<bool> future = request->promise_.get_future();
+  std::lock_guard<std::mutex> guard(latch_);
+  for (size_t i = 0; i < request->num_pages_; ++i) {
+    page_id_t page_id = request->page_id_ + static_cast<page_id_t>(i);
+    auto last_write = last_writes_.find(page_id);
+    if (last_write != last_writes_.end()) {
+      AsyncRequest *blocker = last_write->second;
+      // a write of several pages blocks only once
+      if (blocker->followers_.empty() ||
+          blocker->followers_.back() != request) {
+        blocker->followers_.push_back(request);
+        request->blockers_++;
+      }
+    }
+    if (request->is_write_)
+      last_writes_[page_id] = request;
+  }
+  pending_.push_back(request);
+  return future;
+}
+
+/*
+ * Private helper function merging writes of consecutive pages in batch into
+ * single transfers of at most MAX_MERGED_PAGES pages and handing the batch to
+ * the backend. Two writes of one page are never ready at the same time.
+ * NOTE: caller must hold latch_
+ */
+void AsyncDiskManager::Dispatch(std::vector<AsyncRequest *> &batch) {
+  std::vector<AsyncRequest *> transfers;
+  std::vector<AsyncRequest *> writes;
+  for (auto request : batch)
+    (request->is_write_ ? writes : transfers).push_back(request);
+  std::sort(writes.begin(), writes.end(),
+            [](const AsyncRequest *a, const AsyncRequest *b) {
+              return a->page_id_ < b->page_id_;
+            });
+  AsyncRequest *run = nullptr;
+  size_t run_pages = 0;
+  for (auto write : writes) {
+    if (run != nullptr &&
+        write->page_id_ ==
+            run->page_id_ + static_cast<page_id_t>(run_pages) &&
+        run_pages + write->num_pages_ <= MAX_MERGED_PAGES) {
+      run->merged_.push_back(write);
+      run->iovs_.push_back(write->iovs_.front());
+      run_pages += write->num_pages_;
+      continue;
+    }
+    transfers.push_back(write);
+    run = write;
+    run_pages = write->num_pages_;
+  }
+
+  if (ring_fd_ >= 0) {
+    ring_queue_.insert(ring_queue_.end(), transfers.begin(), transfers.end());
+    FillRing();
+    return;
+  }
+  ready_queue_.insert(ready_queue_.end(), transfers.begin(), transfers.end());
+  ready_cv_.notify_all();
+}
+
+/**
+ * Finish a request given the byte count (or negative errno) of its transfer.
+ * Partial transfers are redone synchronously, they only happen at the end of
+ * the file or on I/O errors. Requests chained behind the finished writes are
+ * dispatched before the futures become ready.
+ */
+void AsyncDiskManager::Complete(AsyncRequest *request, int result) {
+  std::vector<AsyncRequest *> parts(1, request);
+  parts.insert(parts.end(), request->merged_.begin(), request->merged_.end());
+  size_t length = TransferLength(request);
+  if (request->is_write_) {
+    if (result == static_cast<int>(length))
+      disk_manager_->ExtendFileSize(
+          static_cast<int64_t>(request->page_id_) * PAGE_SIZE + length);
+    else
+      for (auto part : parts)
+        disk_manager_->WritePages(part->page_id_, part->data_,
+                                  part->num_pages_);
+  } else if (result != PAGE_SIZE) {
+    disk_manager_->ReadPage(request->page_id_, request->data_);
+  }
+
+  {
+    std::lock_guard<std::mutex> guard(latch_);
+    std::vector<AsyncRequest *> released;
+    for (auto part : parts) {
+      for (size_t i = 0; part->is_write_ && i < part->num_pages_; ++i) {
+        auto last_write =
+            last_writes_.find(part->page_id_ + static_cast<page_id_t>(i));
+        if (last_write != last_writes_.end() && last_write->second == part)
+          last_writes_.erase(last_write);
+      }
+      for (auto follower : part->followers_) {
+        if (--follower->blockers_ == 0 && follower->submitted_)
+          released.push_back(follower);
+      }
+    }
+    if (!released.empty())
+      Dispatch(released);
+  }
+  for (auto part : parts) {
+    part->promise_.set_value(true);
+    delete part;
+  }
+}
+
+/*****************************************************************************
+ * IO_URING BACKEND
+ *****************************************************************************/
+bool AsyncDiskManager::SetupRing(unsigned queue_depth) {
+#ifdef CMUDB_HAVE_IO_URING
+  struct io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  int ring_fd = IoUringSetup(queue_depth == 0 ? 1 : queue_depth, &params);
+  if (ring_fd < 0)
+    return false;
+
+  sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  cq_ring_size_ =
+      params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+  bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+  if (single_mmap)
+    sq_ring_size_ = cq_ring_size_ =
+        std::max(sq_ring_size_, cq_ring_size_);
+  sq_ring_ptr_ = mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQ_RING);
+  if (sq_ring_ptr_ == MAP_FAILED) {
+    close(ring_fd);
+    return false;
+  }
+  cq_ring_ptr_ = single_mmap
+                     ? sq_ring_ptr_
+                     : mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE,
+                            MAP_SHARED | MAP_POPULATE, ring_fd,
+                            IORING_OFF_CQ_RING);
+  sqes_size_ = params.sq_entries * sizeof(struct io_uring_sqe);
+  sqes_ptr_ = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQES);
+  if (cq_ring_ptr_ == MAP_FAILED || sqes_ptr_ == MAP_FAILED) {
+    ring_fd_ = ring_fd;
+    TeardownRing();
+    return false;
+  }
+
+  sq_entries_ = params.sq_entries;
+  sq_tail_ = RingField(sq_ring_ptr_, params.sq_off.tail);
+  sq_mask_ = RingField(sq_ring_ptr_, params.sq_off.ring_mask);
+  sq_array_ = RingField(sq_ring_ptr_, params.sq_off.array);
+  cq_head_ = RingField(cq_ring_ptr_, params.cq_off.head);
+  cq_tail_ = RingField(cq_ring_ptr_, params.cq_off.tail);
+  cq_mask_ = RingField(cq_ring_ptr_, params.cq_off.ring_mask);
+  cqes_ = static_cast<char *>(cq_ring_ptr_) + params.cq_off.cqes;
+  ring_fd_ = ring_fd;
+  return true;
+#else
+  return false;
+#endif
+}
+
+void AsyncDiskManager::TeardownRing() {
+#ifdef CMUDB_HAVE_IO_URING
+  if (ring_fd_ < 0)
+    return;
+  if (sqes_ptr_ != nullptr && sqes_ptr_ != MAP_FAILED)
+    munmap(sqes_ptr_, sqes_size_);
+  if (cq_ring_ptr_ != nullptr && cq_ring_ptr_ != MAP_FAILED &&
+      cq_ring_ptr_ != sq_ring_ptr_)
+    munmap(cq_ring_ptr_, cq_ring_size_);
+  munmap(sq_ring_ptr_, sq_ring_size_);
+  close(ring_fd_);
+  ring_fd_ = -1;
+#endif
+}
+
+/*
+ * Move as many queued transfers into the submission queue as there is room
+ * for in the ring and enter the kernel once. The reaper calls this again
+ * whenever completions make room.
+ * NOTE: caller must hold latch_
+ */
+void AsyncDiskManager::FillRing() {
+#ifdef CMUDB_HAVE_IO_URING
+  unsigned tail = *sq_tail_;
+  unsigned count = 0;
+  while (!ring_queue_.empty() && in_flight_ + count < sq_entries_) {
+    AsyncRequest *request = ring_queue_.front();
+    ring_queue_.pop_front();
+    unsigned index = (tail + count) & *sq_mask_;
+    auto sqe = static_cast<struct io_uring_sqe *>(sqes_ptr_) + index;
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = request->is_write_ ? IORING_OP_WRITEV : IORING_OP_READV;
+    sqe->fd = disk_manager_->db_fd_;
+    sqe->addr = reinterpret_cast<uint64_t>(request->iovs_.data());
+    sqe->len = static_cast<unsigned>(request->iovs_.size());
+    sqe->off = static_cast<uint64_t>(request->page_id_) * PAGE_SIZE;
+    sqe->user_data = reinterpret_cast<uint64_t>(request);
+    sq_array_[index] = index;
+    count++;
+  }
+  if (count == 0)
+    return;
+  __atomic_store_n(sq_tail_, tail + count, __ATOMIC_RELEASE);
+  in_flight_ += count;
+  int submitted = IoUringEnter(ring_fd_, count, 0, 0);
+  if (submitted != static_cast<int>(count)) {
+    LOG_DEBUG("io_uring_enter submitted %d of %u requests", submitted, count);
+  }
+#endif
+}
+
+/*
+ * Reaper thread: wait for completions and finish their requests until the
+ * shutdown nop arrives
+ */
+void AsyncDiskManager::ReapCompletions() {
+#ifdef CMUDB_HAVE_IO_URING
+  auto cqes = static_cast<struct io_uring_cqe *>(cqes_);
+  while (true) {
+    IoUringEnter(ring_fd_, 0, 1, IORING_ENTER_GETEVENTS);
+    unsigned head = *cq_head_;
+    unsigned completed = 0;
+    bool stop = false;
+    while (head != __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE)) {
+      struct io_uring_cqe *cqe = &cqes[head & *cq_mask_];
+      auto request = reinterpret_cast<AsyncRequest *>(cqe->user_data);
+      int result = cqe->res;
+      head++;
+      __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+      if (request == nullptr) {
+        stop = true;
+        continue;
+      }
+      Complete(request, result);
+      completed++;
+    }
+    if (completed > 0) {
+      std::lock_guard<std::mutex> guard(latch_);
+      in_flight_ -= completed;
+      FillRing();
+      ring_space_.notify_all();
+    }
+    if (stop)
+      return;
+  }
+#endif
+}
+
+/*****************************************************************************
+ * THREAD POOL BACKEND
+ *****************************************************************************/
+void AsyncDiskManager::WorkerLoop() {
+  while (true) {
+    AsyncRequest *request;
+    {
+      std::unique_lock<std::mutex> lock(latch_);
+      ready_cv_.wait(lock,
+                     [this] { return shutdown_ || !ready_queue_.empty(); });
+      if (ready_queue_.empty())
+        return;
+      request = ready_queue_.front();
+      ready_queue_.pop_front();
+    }
+    if (request->is_write_) {
+      disk_manager_->WritePages(request->page_id_, request->data_,
+                                request->num_pages_);
+      for (auto part : request->merged_)
+        disk_manager_->WritePages(part->page_id_, part->data_,
+                                  part->num_pages_);
+    } else {
+      disk_manager_->ReadPage(request->page_id_, request->data_);
+    }
+    Complete(request, static_cast<int>(TransferLength(request)));
+  }
+}
+
+} // namespace cmudb
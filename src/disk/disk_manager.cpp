@@ -1,96 +1,368 @@
 /**
  * disk_manager.cpp
  */
+#include <algorithm>
+#include <cerrno>
 #include <cstring>
+#include <fcntl.h>
 #include <iostream>
 #include <sys/stat.h>
+#include <unistd.h>
 
+#include "common/exception.h"
 #include "common/logger.h"
 #include "disk/disk_manager.h"
 
 namespace cmudb {
 
+// marks a header page trailer that carries a bitmap anchor ("BMAP")
+static const uint32_t BITMAP_MAGIC = 0x424d4150;
+static const int BITMAP_HEADER_SIZE = 8;
+
+constexpr int DiskManager::BITMAP_PAGE_BITS;
+
 /**
  * Constructor: open/create a single database file
  * @input db_file: database file name
  */
 DiskManager::DiskManager(const std::string &db_file)
-    : file_name_(db_file), next_page_id_(0) {
-  db_io_.open(db_file, std::ios::binary | std::ios::in | std::ios::out);
-  // directory or file does not exist
-  if (!db_io_.is_open()) {
-    db_io_.clear();
-    // create a new file
-    db_io_.open(db_file, std::ios::binary | std::ios::trunc | std::ios::out);
-    db_io_.close();
-    // reopen with original mode
-    db_io_.open(db_file, std::ios::binary | std::ios::in | std::ios::out);
-  }
+    : file_name_(db_file), next_page_id_(0), file_size_(0), free_hint_(0),
+      first_bitmap_page_id_(INVALID_PAGE_ID) {
+  // create the file if it does not exist yet
+  db_fd_ = open(db_file.c_str(), O_RDWR | O_CREAT, 0644);
+  if (db_fd_ < 0)
+    throw Exception("can't open db file " + db_file + ": " + strerror(errno));
+  struct stat stat_buf;
+  if (fstat(db_fd_, &stat_buf) == 0)
+    file_size_ = stat_buf.st_size;
+
+  // continue allocating after the last page of an existing file, the bitmaps
+  // also know about pages that were allocated but never written
+  next_page_id_ = static_cast<page_id_t>(
+      (file_size_.load() + PAGE_SIZE - 1) / PAGE_SIZE);
+  std::lock_guard<std::mutex> guard(bitmap_latch_);
+  LoadBitmaps();
 }
 
-DiskManager::~DiskManager() { db_io_.close(); }
+DiskManager::~DiskManager() { close(db_fd_); }
 
 /**
  * Write the contents of the specified page into disk file
  */
 void DiskManager::WritePage(page_id_t page_id, const char *page_data) {
-  size_t offset = page_id * PAGE_SIZE;
-  // set write cursor to offset
-  db_io_.seekp(offset);
-  db_io_.write(page_data, PAGE_SIZE);
-  // check for I/O error
-  if (db_io_.bad()) {
-    LOG_DEBUG("I/O error while writing");
+  if (page_id == HEADER_PAGE_ID) {
+    // the trailer of the header page always carries the bitmap anchor
+    char header[PAGE_SIZE];
+    memcpy(header, page_data, PAGE_SIZE);
+    std::lock_guard<std::mutex> guard(bitmap_latch_);
+    StampHeaderTrailer(header);
+    WritePageData(page_id, header);
     return;
   }
-  // needs to flush to keep disk file in sync
-  db_io_.flush();
+  WritePageData(page_id, page_data);
+}
+
+/**
+ * Write num_pages consecutive pages starting at page_id with a single I/O,
+ * page_data holds the contents of all of them back to back
+ */
+void DiskManager::WritePages(page_id_t page_id, const char *page_data,
+                             size_t num_pages) {
+  if (num_pages == 0)
+    return;
+  // the header page needs its trailer
+  if (page_id == HEADER_PAGE_ID) {
+    WritePage(page_id, page_data);
+    page_id++;
+    page_data += PAGE_SIZE;
+    num_pages--;
+  }
+  WritePageData(page_id, page_data, num_pages);
+}
+
+/*
+ * Private helper function doing the positional write of num_pages pages
+ */
+void DiskManager::WritePageData(page_id_t page_id, const char *page_data,
+                                size_t num_pages) {
+  off_t offset = static_cast<off_t>(page_id) * PAGE_SIZE;
+  size_t length = num_pages * PAGE_SIZE;
+  size_t written = 0;
+  while (written < length) {
+    ssize_t rc = pwrite(db_fd_, page_data + written, length - written,
+                        offset + written);
+    if (rc < 0 && errno == EINTR)
+      continue;
+    // check for I/O error
+    if (rc <= 0) {
+      LOG_DEBUG("I/O error while writing");
+      return;
+    }
+    written += rc;
+  }
+  ExtendFileSize(offset + length);
 }
 
 /**
  * Read the contents of the specified page into the given memory area
  */
 void DiskManager::ReadPage(page_id_t page_id, char *page_data) {
-  int offset = page_id * PAGE_SIZE;
+  off_t offset = static_cast<off_t>(page_id) * PAGE_SIZE;
   // check if read beyond file length
-  if (offset >= GetFileSize()) {
+  if (offset >= file_size_.load()) {
     LOG_DEBUG("I/O error while reading");
-    // std::cerr << "I/O error while reading" << std::endl;
-  } else {
-    // set read cursor to offset
-    db_io_.seekp(offset);
-    db_io_.read(page_data, PAGE_SIZE);
-    // if file ends before reading PAGE_SIZE
-    int read_count = db_io_.gcount();
-    if (read_count < PAGE_SIZE) {
-      LOG_DEBUG("Read less than a page");
-      // std::cerr << "Read less than a page" << std::endl;
-      memset(page_data + read_count, 0, PAGE_SIZE - read_count);
+    // never hand back the previous content of a recycled frame
+    memset(page_data, 0, PAGE_SIZE);
+    return;
+  }
+  size_t read_count = 0;
+  while (read_count < PAGE_SIZE) {
+    ssize_t rc = pread(db_fd_, page_data + read_count, PAGE_SIZE - read_count,
+                       offset + read_count);
+    if (rc < 0 && errno == EINTR)
+      continue;
+    if (rc <= 0) {
+      if (rc < 0) {
+        LOG_DEBUG("I/O error while reading");
+      }
+      break;
     }
+    read_count += rc;
+  }
+  // if file ends before reading PAGE_SIZE
+  if (read_count < PAGE_SIZE) {
+    LOG_DEBUG("Read less than a page");
+    memset(page_data + read_count, 0, PAGE_SIZE - read_count);
   }
 }
 
 /**
  * Allocate new page (operations like create index/table)
- * For now just keep an increasing counter
+ * Hands out the lowest free page id, only grows the file when no deallocated
+ * page is left to reuse
  */
-page_id_t DiskManager::AllocatePage() { return next_page_id_++; }
+page_id_t DiskManager::AllocatePage() {
+  std::lock_guard<std::mutex> guard(bitmap_latch_);
+  // nothing was ever deallocated, every page below the counter is in use
+  if (bitmaps_.empty())
+    return next_page_id_++;
+
+  page_id_t page_id = FindFreePage(free_hint_);
+  if (page_id == INVALID_PAGE_ID)
+    page_id = next_page_id_++;
+  SetAllocated(page_id, true);
+  free_hint_ = page_id + 1;
+  return page_id;
+}
 
 /**
  * Deallocate page (operations like drop index/table)
- * Need bitmap in header page for tracking pages
+ * Clears the page's bit in the free space bitmap, the bitmaps are created on
+ * the first call. The header page and the bitmap pages are never freed.
  */
-void DiskManager::DeallocatePage(__attribute__((unused)) page_id_t page_id) {
-  return;
+void DiskManager::DeallocatePage(page_id_t page_id) {
+  if (page_id <= HEADER_PAGE_ID || page_id >= next_page_id_.load())
+    return;
+  std::lock_guard<std::mutex> guard(bitmap_latch_);
+  if (bitmaps_.empty())
+    InitBitmaps();
+  for (auto &bitmap : bitmaps_) {
+    if (bitmap.page_id_ == page_id)
+      return;
+  }
+  if (!IsAllocated(page_id))
+    return;
+  SetAllocated(page_id, false);
+  if (page_id < free_hint_)
+    free_hint_ = page_id;
 }
 
 /**
- * Private helper function to get disk file size
+ * Private helper function to grow the cached file length after a write that
+ * ended at byte offset end, concurrent writers race to the maximum
  */
-int DiskManager::GetFileSize() {
-  struct stat stat_buf;
-  int rc = stat(file_name_.c_str(), &stat_buf);
-  return rc == 0 ? stat_buf.st_size : -1;
+void DiskManager::ExtendFileSize(int64_t end) {
+  int64_t size = file_size_.load();
+  while (size < end && !file_size_.compare_exchange_weak(size, end)) {
+  }
+}
+
+/*
+ * Private helper function to overwrite the trailer of a header page image
+ * with the bitmap anchor, if there is one
+ * NOTE: caller must hold bitmap_latch_
+ */
+void DiskManager::StampHeaderTrailer(char *page_data) {
+  page_id_t first = first_bitmap_page_id_.load();
+  if (first == INVALID_PAGE_ID)
+    return;
+  char *trailer = page_data + PAGE_SIZE - HEADER_PAGE_RESERVED;
+  memcpy(trailer, &BITMAP_MAGIC, 4);
+  memcpy(trailer + 4, &first, 4);
+}
+
+/*
+ * Private helper function to record the head of the bitmap chain in the
+ * header page on disk. Later writes of the header page keep it through
+ * StampHeaderTrailer.
+ */
+void DiskManager::WriteAnchor(page_id_t first_bitmap_page_id) {
+  first_bitmap_page_id_ = first_bitmap_page_id;
+  char header[PAGE_SIZE];
+  ReadPage(HEADER_PAGE_ID, header);
+  StampHeaderTrailer(header);
+  WritePageData(HEADER_PAGE_ID, header);
+}
+
+/*
+ * Private helper function to read the bitmap chain of an existing file, it
+ * is ignored as a whole if any link points outside of the file
+ */
+void DiskManager::LoadBitmaps() {
+  page_id_t num_pages = next_page_id_.load();
+  if (num_pages == 0)
+    return;
+  char header[PAGE_SIZE];
+  ReadPage(HEADER_PAGE_ID, header);
+  const char *trailer = header + PAGE_SIZE - HEADER_PAGE_RESERVED;
+  uint32_t magic;
+  page_id_t bitmap_page_id;
+  memcpy(&magic, trailer, 4);
+  memcpy(&bitmap_page_id, trailer + 4, 4);
+  if (magic != BITMAP_MAGIC)
+    return;
+
+  std::vector<BitmapPage> bitmaps;
+  while (bitmap_page_id != INVALID_PAGE_ID) {
+    if (bitmap_page_id <= HEADER_PAGE_ID || bitmap_page_id >= num_pages ||
+        bitmaps.size() > static_cast<size_t>(num_pages)) {
+      LOG_DEBUG("corrupted free space bitmap chain, ignored");
+      return;
+    }
+    BitmapPage bitmap;
+    bitmap.page_id_ = bitmap_page_id;
+    bitmap.data_.reset(new char[PAGE_SIZE]);
+    ReadPage(bitmap_page_id, bitmap.data_.get());
+    memcpy(&bitmap_page_id, bitmap.data_.get(), 4);
+    bitmaps.push_back(std::move(bitmap));
+  }
+  bitmaps_ = std::move(bitmaps);
+  first_bitmap_page_id_ = bitmaps_.front().page_id_;
+
+  // pages may have been allocated beyond the end of the file
+  for (size_t i = bitmaps_.size(); i-- > 0;) {
+    const uint64_t *words = reinterpret_cast<const uint64_t *>(
+        bitmaps_[i].data_.get() + BITMAP_HEADER_SIZE);
+    int word = BITMAP_PAGE_BITS / 64;
+    while (word-- > 0 && words[word] == 0) {
+    }
+    if (word >= 0) {
+      page_id_t last = static_cast<page_id_t>(i) * BITMAP_PAGE_BITS +
+                       word * 64 + 63 - __builtin_clzll(words[word]);
+      if (last >= next_page_id_)
+        next_page_id_ = last + 1;
+      break;
+    }
+  }
+}
+
+/*
+ * Private helper function to start tracking free space, every page allocated
+ * so far is in use
+ */
+void DiskManager::InitBitmaps() {
+  page_id_t end = next_page_id_.load();
+  while (static_cast<int64_t>(bitmaps_.size()) * BITMAP_PAGE_BITS < end)
+    AppendBitmap();
+  for (size_t i = 0; i < bitmaps_.size(); ++i) {
+    char *bits = bitmaps_[i].data_.get() + BITMAP_HEADER_SIZE;
+    int64_t first = static_cast<int64_t>(i) * BITMAP_PAGE_BITS;
+    int64_t count = std::min<int64_t>(end - first, BITMAP_PAGE_BITS);
+    if (count <= 0)
+      continue;
+    memset(bits, 0xff, count / 8);
+    for (int64_t bit = count / 8 * 8; bit < count; ++bit)
+      bits[bit / 8] |= 1 << (bit % 8);
+    WritePageData(bitmaps_[i].page_id_, bitmaps_[i].data_.get());
+  }
+  free_hint_ = end;
+}
+
+/*
+ * Private helper function to add a bitmap page covering the next range of
+ * page ids. The bitmap page itself is taken from the end of the file.
+ */
+void DiskManager::AppendBitmap() {
+  BitmapPage bitmap;
+  bitmap.page_id_ = next_page_id_++;
+  bitmap.data_.reset(new char[PAGE_SIZE]);
+  memset(bitmap.data_.get(), 0, PAGE_SIZE);
+  page_id_t next = INVALID_PAGE_ID;
+  memcpy(bitmap.data_.get(), &next, 4);
+  WritePageData(bitmap.page_id_, bitmap.data_.get());
+
+  // link the new page into the chain
+  if (bitmaps_.empty()) {
+    WriteAnchor(bitmap.page_id_);
+  } else {
+    BitmapPage &last = bitmaps_.back();
+    memcpy(last.data_.get(), &bitmap.page_id_, 4);
+    WritePageData(last.page_id_, last.data_.get());
+  }
+  page_id_t page_id = bitmap.page_id_;
+  bitmaps_.push_back(std::move(bitmap));
+  SetAllocated(page_id, true);
+}
+
+/*
+ * Private helper function to update and write through the bit of page_id,
+ * appending bitmap pages until page_id is covered
+ */
+void DiskManager::SetAllocated(page_id_t page_id, bool allocated) {
+  while (static_cast<int64_t>(bitmaps_.size()) * BITMAP_PAGE_BITS <= page_id)
+    AppendBitmap();
+  BitmapPage &bitmap = bitmaps_[page_id / BITMAP_PAGE_BITS];
+  int bit = page_id % BITMAP_PAGE_BITS;
+  char &byte = bitmap.data_[BITMAP_HEADER_SIZE + bit / 8];
+  if (allocated)
+    byte |= 1 << (bit % 8);
+  else
+    byte &= ~(1 << (bit % 8));
+  WritePageData(bitmap.page_id_, bitmap.data_.get());
+}
+
+bool DiskManager::IsAllocated(page_id_t page_id) {
+  if (static_cast<int64_t>(bitmaps_.size()) * BITMAP_PAGE_BITS <= page_id)
+    return false;
+  const BitmapPage &bitmap = bitmaps_[page_id / BITMAP_PAGE_BITS];
+  int bit = page_id % BITMAP_PAGE_BITS;
+  return bitmap.data_[BITMAP_HEADER_SIZE + bit / 8] & (1 << (bit % 8));
+}
+
+/*
+ * Private helper function to find the lowest free page id at or after from
+ * and below the allocation counter, 64 bits at a time
+ * return INVALID_PAGE_ID if every page below the counter is in use
+ */
+page_id_t DiskManager::FindFreePage(page_id_t from) {
+  page_id_t end = next_page_id_.load();
+  for (size_t i = from / BITMAP_PAGE_BITS; i < bitmaps_.size(); ++i) {
+    const uint64_t *words = reinterpret_cast<const uint64_t *>(
+        bitmaps_[i].data_.get() + BITMAP_HEADER_SIZE);
+    page_id_t base = static_cast<page_id_t>(i) * BITMAP_PAGE_BITS;
+    int start = from > base ? from - base : 0;
+    for (int word = start / 64; word < BITMAP_PAGE_BITS / 64; ++word) {
+      uint64_t free_bits = ~words[word];
+      // ignore the bits below the start position in the first word
+      if (word == start / 64)
+        free_bits &= ~static_cast<uint64_t>(0) << (start % 64);
+      if (free_bits == 0)
+        continue;
+      page_id_t page_id = base + word * 64 + __builtin_ctzll(free_bits);
+      return page_id < end ? page_id : INVALID_PAGE_ID;
+    }
+  }
+  return INVALID_PAGE_ID;
 }
 
 } // namespace cmudb
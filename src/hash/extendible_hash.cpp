@@ -1,4 +1,10 @@
+#include <algorithm>
+#include <cstdint>
+#include <functional>
 #include <list>
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
 
 #include "hash/extendible_hash.h"
 #include "page/page.h"
@@ -10,14 +16,18 @@ namespace cmudb {
  * array_size: fixed array size for each bucket
  */
 template <typename K, typename V>
-ExtendibleHash<K, V>::ExtendibleHash(size_t size) {}
+ExtendibleHash<K, V>::ExtendibleHash(size_t size)
+    : global_depth_(0), bucket_size_(size == 0 ? 1 : size), directory_(1) {
+  buckets_.emplace_back(new Bucket(0));
+  directory_[0].store(buckets_.back().get(), std::memory_order_relaxed);
+}
 
 /*
  * helper function to calculate the hashing address of input key
  */
 template <typename K, typename V>
 size_t ExtendibleHash<K, V>::HashKey(const K &key) {
-  return 0;
+  return std::hash<K>()(key);
 }
 
 /*
@@ -26,7 +36,10 @@ size_t ExtendibleHash<K, V>::HashKey(const K &key) {
  */
 template <typename K, typename V>
 int ExtendibleHash<K, V>::GetGlobalDepth() const {
-  return 0;
+  directory_latch_.RLock();
+  int global_depth = global_depth_;
+  directory_latch_.RUnlock();
+  return global_depth;
 }
 
 /*
@@ -35,7 +48,15 @@ int ExtendibleHash<K, V>::GetGlobalDepth() const {
  */
 template <typename K, typename V>
 int ExtendibleHash<K, V>::GetLocalDepth(int bucket_id) const {
-  return 0;
+  int local_depth = -1;
+  directory_latch_.RLock();
+  if (bucket_id >= 0 && bucket_id < static_cast<int>(directory_.size())) {
+    Bucket *bucket = directory_[bucket_id].load(std::memory_order_acquire);
+    std::lock_guard<std::mutex> guard(bucket->latch_);
+    local_depth = bucket->local_depth_;
+  }
+  directory_latch_.RUnlock();
+  return local_depth;
 }
 
 /*
@@ -43,7 +64,8 @@ int ExtendibleHash<K, V>::GetLocalDepth(int bucket_id) const {
  */
 template <typename K, typename V>
 int ExtendibleHash<K, V>::GetNumBuckets() const {
-  return 0;
+  std::lock_guard<std::mutex> guard(buckets_latch_);
+  return static_cast<int>(buckets_.size());
 }
 
 /*
@@ -51,16 +73,45 @@ int ExtendibleHash<K, V>::GetNumBuckets() const {
  */
 template <typename K, typename V>
 bool ExtendibleHash<K, V>::Find(const K &key, V &value) {
-  return false;
+  bool found = false;
+  directory_latch_.RLock();
+  Bucket *bucket = LockBucket(key);
+  int index = FindItem(bucket, key, Fingerprint(HashKey(key)));
+  if (index != -1) {
+    value = bucket->items_[index].second;
+    found = true;
+  }
+  bucket->latch_.unlock();
+  directory_latch_.RUnlock();
+  return found;
 }
 
 /*
  * delete <key,value> entry in hash table
- * Shrink & Combination is not required for this project
+ * A bucket that empties out is merged with its buddy and the directory is
+ * halved once no bucket needs its full depth any more
  */
 template <typename K, typename V>
 bool ExtendibleHash<K, V>::Remove(const K &key) {
-  return false;
+  bool removed = false;
+  directory_latch_.RLock();
+  Bucket *bucket = LockBucket(key);
+  int index = FindItem(bucket, key, Fingerprint(HashKey(key)));
+  if (index != -1) {
+    RemoveItem(bucket, index);
+    removed = true;
+  }
+  bool merge = bucket->items_.empty() && bucket->local_depth_ > 0;
+  bucket->latch_.unlock();
+  directory_latch_.RUnlock();
+
+  if (merge) {
+    directory_latch_.WLock();
+    MergeBucket(key);
+    ShrinkDirectory();
+    directory_latch_.WUnlock();
+  }
+  return removed;
 }
 
 /*
@@ -69,7 +120,257 @@ bool ExtendibleHash<K, V>::Remove(const K &key) {
  * global depth
  */
 template <typename K, typename V>
-void ExtendibleHash<K, V>::Insert(const K &key, const V &value) {}
+void ExtendibleHash<K, V>::Insert(const K &key, const V &value) {
+  uint8_t fingerprint = Fingerprint(HashKey(key));
+  while (true) {
+    directory_latch_.RLock();
+    Bucket *bucket = LockBucket(key);
+    bool done = true;
+    bool grow = false;
+    // overwrite if key already exists
+    int index = FindItem(bucket, key, fingerprint);
+    if (index != -1) {
+      bucket->items_[index].second = value;
+    } else if (bucket->items_.size() < bucket_size_) {
+      bucket->items_.emplace_back(key, value);
+      bucket->fingerprints_.push_back(fingerprint);
+    } else if (bucket->local_depth_ < global_depth_) {
+      // all keys of an overflowing bucket may land on the same side of a
+      // split, look at the target bucket again
+      SplitBucket(bucket);
+      done = false;
+    } else {
+      done = false;
+      grow = true;
+    }
+    bucket->latch_.unlock();
+    directory_latch_.RUnlock();
+    if (done)
+      return;
+    if (!grow)
+      continue;
+
+    // the bucket is at global depth, double the directory unless another
+    // thread got there first
+    directory_latch_.WLock();
+    bucket = directory_[BucketIndex(key)].load(std::memory_order_relaxed);
+    if (bucket->items_.size() >= bucket_size_ &&
+        bucket->local_depth_ == global_depth_)
+      GrowDirectory();
+    directory_latch_.WUnlock();
+  }
+}
+
+/*
+ * helper function to map a key onto its directory slot, i.e. the lowest
+ * global_depth_ bits of its hash value
+ */
+template <typename K, typename V>
+size_t ExtendibleHash<K, V>::BucketIndex(const K &key) {
+  return HashKey(key) & ((static_cast<size_t>(1) << global_depth_) - 1);
+}
+
+/*
+ * helper function to latch the bucket of key. A split may redirect the
+ * directory slot between reading it and latching the bucket, the slot is
+ * checked again once the latch is held.
+ * NOTE: caller must hold the directory latch
+ */
+template <typename K, typename V>
+typename ExtendibleHash<K, V>::Bucket *
+ExtendibleHash<K, V>::LockBucket(const K &key) {
+  auto &slot = directory_[BucketIndex(key)];
+  while (true) {
+    Bucket *bucket = slot.load(std::memory_order_acquire);
+    bucket->latch_.lock();
+    if (slot.load(std::memory_order_relaxed) == bucket)
+      return bucket;
+    bucket->latch_.unlock();
+  }
+}
+
+/*
+ * helper function to derive the fingerprint of a hash value. The directory
+ * uses the low bits, so the high bits of a multiplicative hash are taken.
+ */
+template <typename K, typename V>
+uint8_t ExtendibleHash<K, V>::Fingerprint(size_t hash) {
+  return static_cast<uint8_t>(
+      (static_cast<uint64_t>(hash) * UINT64_C(0x9E3779B97F4A7C15)) >> 56);
+}
+
+/*
+ * helper function to find the entry of key in bucket, return -1 if there is
+ * none. The fingerprints are matched 32 or 16 at a time and keys are only
+ * compared where a fingerprint matches.
+ * NOTE: caller must hold the bucket latch
+ */
+template <typename K, typename V>
+int ExtendibleHash<K, V>::FindItem(const Bucket *bucket, const K &key,
+                                   uint8_t fingerprint) {
+  const uint8_t *fingerprints = bucket->fingerprints_.data();
+  size_t size = bucket->fingerprints_.size();
+  size_t i = 0;
+#if defined(__AVX2__)
+  const __m256i needle256 = _mm256_set1_epi8(static_cast<char>(fingerprint));
+  for (; i + 32 <= size; i += 32) {
+    __m256i chunk = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i *>(fingerprints + i));
+    uint32_t mask = static_cast<uint32_t>(
+        _mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, needle256)));
+    for (; mask != 0; mask &= mask - 1) {
+      size_t index = i + __builtin_ctz(mask);
+      if (bucket->items_[index].first == key)
+        return static_cast<int>(index);
+    }
+  }
+#endif
+#if defined(__SSE2__)
+  const __m128i needle128 = _mm_set1_epi8(static_cast<char>(fingerprint));
+  for (; i + 16 <= size; i += 16) {
+    __m128i chunk =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(fingerprints + i));
+    uint32_t mask = static_cast<uint32_t>(
+        _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, needle128)));
+    for (; mask != 0; mask &= mask - 1) {
+      size_t index = i + __builtin_ctz(mask);
+      if (bucket->items_[index].first == key)
+        return static_cast<int>(index);
+    }
+  }
+#endif
+  for (; i < size; i++) {
+    if (fingerprints[i] == fingerprint && bucket->items_[i].first == key)
+      return static_cast<int>(i);
+  }
+  return -1;
+}
+
+/*
+ * helper function to remove the entry at index, the last entry fills the gap
+ * NOTE: caller must hold the bucket latch
+ */
+template <typename K, typename V>
+void ExtendibleHash<K, V>::RemoveItem(Bucket *bucket, size_t index) {
+  bucket->items_[index] = std::move(bucket->items_.back());
+  bucket->items_.pop_back();
+  bucket->fingerprints_[index] = bucket->fingerprints_.back();
+  bucket->fingerprints_.pop_back();
+}
+
+/*
+ * helper function to split a bucket below global depth. Its entries whose new
+ * distinguishing bit is set move to a new bucket before the directory slots
+ * are redirected, so the new bucket is complete once it becomes reachable.
+ * NOTE: caller must hold the directory latch and the bucket latch
+ */
+template <typename K, typename V>
+void ExtendibleHash<K, V>::SplitBucket(Bucket *bucket) {
+  int depth = ++bucket->local_depth_;
+  Bucket *new_bucket = new Bucket(depth);
+  {
+    std::lock_guard<std::mutex> guard(buckets_latch_);
+    buckets_.emplace_back(new_bucket);
+  }
+  size_t high_bit = static_cast<size_t>(1) << (depth - 1);
+
+  // backwards, removing moves the last entry into the gap
+  for (size_t i = bucket->items_.size(); i-- > 0;) {
+    if (HashKey(bucket->items_[i].first) & high_bit) {
+      new_bucket->items_.push_back(bucket->items_[i]);
+      new_bucket->fingerprints_.push_back(bucket->fingerprints_[i]);
+      RemoveItem(bucket, i);
+    }
+  }
+  // redirect the directory slots that now belong to the new bucket
+  for (size_t i = 0; i < directory_.size(); i++) {
+    if ((i & high_bit) &&
+        directory_[i].load(std::memory_order_relaxed) == bucket)
+      directory_[i].store(new_bucket, std::memory_order_release);
+  }
+}
+
+/*
+ * helper function to merge the bucket of key with its buddy, the bucket that
+ * differs only in the highest local depth bit, for as long as both share a
+ * local depth and their entries fit into half a bucket. The slack keeps a
+ * bucket at the boundary from being split and merged over and over.
+ * NOTE: caller must hold the directory latch exclusively
+ */
+template <typename K, typename V>
+void ExtendibleHash<K, V>::MergeBucket(const K &key) {
+  size_t bucket_id = BucketIndex(key);
+  Bucket *bucket = directory_[bucket_id].load(std::memory_order_relaxed);
+  while (bucket->local_depth_ > 0) {
+    size_t high_bit = static_cast<size_t>(1) << (bucket->local_depth_ - 1);
+    Bucket *buddy =
+        directory_[bucket_id ^ high_bit].load(std::memory_order_relaxed);
+    if (buddy->local_depth_ != bucket->local_depth_ ||
+        bucket->items_.size() + buddy->items_.size() > bucket_size_ / 2)
+      break;
+
+    // keep the buddy with the lower slots, the other one is freed
+    Bucket *keep = (bucket_id & high_bit) ? buddy : bucket;
+    Bucket *drop = keep == bucket ? buddy : bucket;
+    keep->items_.insert(keep->items_.end(), drop->items_.begin(),
+                        drop->items_.end());
+    keep->fingerprints_.insert(keep->fingerprints_.end(),
+                               drop->fingerprints_.begin(),
+                               drop->fingerprints_.end());
+    keep->local_depth_--;
+    for (size_t i = 0; i < directory_.size(); i++) {
+      if (directory_[i].load(std::memory_order_relaxed) == drop)
+        directory_[i].store(keep, std::memory_order_relaxed);
+    }
+    std::lock_guard<std::mutex> guard(buckets_latch_);
+    for (auto it = buckets_.begin(); it != buckets_.end(); ++it) {
+      if (it->get() == drop) {
+        buckets_.erase(it);
+        break;
+      }
+    }
+    bucket = keep;
+  }
+}
+
+/*
+ * helper function to halve the directory as long as every local depth is
+ * below the global depth, both halves then point to the same buckets
+ * NOTE: caller must hold the directory latch exclusively
+ */
+template <typename K, typename V>
+void ExtendibleHash<K, V>::ShrinkDirectory() {
+  int max_depth = 0;
+  for (auto &bucket : buckets_)
+    max_depth = std::max(max_depth, bucket->local_depth_);
+  if (max_depth == global_depth_)
+    return;
+
+  size_t size = static_cast<size_t>(1) << max_depth;
+  std::vector<std::atomic<Bucket *>> directory(size);
+  for (size_t i = 0; i < size; i++)
+    directory[i].store(directory_[i].load(std::memory_order_relaxed),
+                       std::memory_order_relaxed);
+  directory_.swap(directory);
+  global_depth_ = max_depth;
+}
+
+/*
+ * helper function to double the directory, the upper half mirrors the lower
+ * NOTE: caller must hold the directory latch exclusively
+ */
+template <typename K, typename V>
+void ExtendibleHash<K, V>::GrowDirectory() {
+  size_t size = directory_.size();
+  std::vector<std::atomic<Bucket *>> directory(size * 2);
+  for (size_t i = 0; i < size; i++) {
+    Bucket *bucket = directory_[i].load(std::memory_order_relaxed);
+    directory[i].store(bucket, std::memory_order_relaxed);
+    directory[i + size].store(bucket, std::memory_order_relaxed);
+  }
+  directory_.swap(directory);
+  global_depth_++;
+}
 
 template class ExtendibleHash<page_id_t, Page *>;
 template class ExtendibleHash<Page *, std::list<Page *>::iterator>;
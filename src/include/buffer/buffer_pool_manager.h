@@ -4,25 +4,88 @@
  * Functionality: The simplified Buffer Manager interface allows a client to
  * new/delete pages on disk, to read a disk page into the buffer pool and pin
  * it, also to unpin a page in the buffer pool.
+ *
+ * The pool can be partitioned into several shards. Every shard owns a disjoint
+ * range of frames together with its own page table, replacer, free list and
+ * latch, and a page is always cached by the shard selected by hashing its
+ * page id. Operations on pages of different shards never contend.
+ *
+ * The page table of a shard can be read without the latch. FetchPage of a
+ * resident page pins it with a compare-and-swap on its pin count and takes
+ * no lock at all. Frames that are free or about to be recycled have a
+ * negative pin count, so eviction first claims an unpinned frame and a
+ * lock-free pin can never race with it.
+ *
+ * The replacement policy (LRU, LRU-K, 2Q or CLOCK) is picked at construction.
+ *
+ * Frame contents come from a FrameArena, a single region backed by huge pages
+ * where possible, while the cache-line padded Page objects form a separate
+ * metadata array.
+ *
+ * The pool can be resized while in use. Growing hands new frames to the free
+ * lists of the shards. Shrinking releases free and evictable frames right
+ * away; a shard that still owns too many frames afterwards releases further
+ * frames as soon as pages are unpinned or deleted there.
+ *
+ * Hits, misses, evictions, write-backs and pin waits are counted in per-thread
+ * slots, and every frame counts the fetches of the page it caches.
+ *
+ * Dirty victims are written back asynchronously: the write-back of the evicted
+ * page and the read of the requested page are submitted together and only the
+ * read is waited for. A later access to the evicted page waits for its write.
+ *
+ * Prefetch starts reads of pages nobody asked for yet. The frames are cached
+ * unpinned while their read is in flight and the first FetchPage of such a
+ * page waits for the read to complete.
+ *
+ * Callers usually hold pages through page guards (see page_guard.h) instead of
+ * pairing FetchPage and UnpinPage by hand.
+ *
+ * Bulk operations can pass a BufferRing to FetchPage and Prefetch, misses are
+ * then served from the ring's private frames instead of the replacer.
+ *
+ * A background flusher keeps the number of dirty frames low so that victims
+ * are nearly always clean. Once more than the high watermark fraction of the
+ * frames is dirty it is woken up right away, otherwise it runs every
+ * FLUSH_INTERVAL. Either way it writes dirty unpinned pages until at most the
+ * low watermark fraction is dirty. It latches one shard at a time and takes
+ * the lowest page ids from the dirty list of the shard, the async disk
+ * manager then merges runs of consecutive page ids into a single write.
  */
 
 #pragma once
+#include <atomic>
 #include <list>
+#include <future>
+#include <map>
+#include <memory>
 #include <mutex>
+#include <unordered_map>
+#include <vector>
 
-#include "buffer/lru_replacer.h"
+#include "buffer/buffer_pool_stats.h"
+#include "buffer/buffer_ring.h"
+#include "buffer/page_guard.h"
+#include "buffer/frame_arena.h"
+#include "buffer/replacer.h"
+#include "disk/async_disk_manager.h"
 #include "disk/disk_manager.h"
 #include "hash/extendible_hash.h"
 #include "page/page.h"
 
 namespace cmudb {
 class BufferPoolManager {
+  friend class BufferRing;
+
 public:
-  BufferPoolManager(size_t pool_size, const std::string &db_file);
+  BufferPoolManager(size_t pool_size, const std::string &db_file,
+                    size_t num_shards = 1,
+                    ReplacerPolicy policy = ReplacerPolicy::LRU,
+                    size_t lru_k = LRU_K);
 
   ~BufferPoolManager();
 
-  Page *FetchPage(page_id_t page_id);
+  Page *FetchPage(page_id_t page_id, BufferRing *ring = nullptr);
 
   bool UnpinPage(page_id_t page_id, bool is_dirty);
 
@@ -34,19 +97,141 @@ public:
 
   bool DeletePage(page_id_t page_id);
 
+  // FetchPage/NewPage with the page latched and unpinned by the guard, the
+  // guard is empty if the page could not be fetched
+  ReadPageGuard FetchPageRead(page_id_t page_id, BufferRing *ring = nullptr);
+
+  WritePageGuard FetchPageWrite(page_id_t page_id);
+
+  OptimisticPageGuard FetchPageOptimistic(page_id_t page_id);
+
+  WritePageGuard NewPageGuarded(page_id_t &page_id);
+
+  void Prefetch(page_id_t page_id, size_t count = 1,
+                BufferRing *ring = nullptr);
+
+  // change the number of frames, at least one frame per shard is kept
+  // throws std::bad_alloc and keeps the current size if the frames cannot be
+  // mapped
+  void Resize(size_t pool_size);
+
+  // number of frames the pool is sized to
+  inline size_t GetPoolSize() const { return pool_size_; }
+
+  // number of frames currently held, above the pool size while a shrink
+  // waits for pinned frames
+  size_t GetNumFrames();
+
+  inline size_t GetNumShards() const { return shards_.size(); }
+
+  inline ReplacerPolicy GetReplacerPolicy() const { return policy_; }
+
+  // whether the oldest frames are backed by huge pages
+  bool IsUsingHugePages();
+
+  // fractions of dirty frames the flusher cleans down to and wakes up at,
+  // 0 <= low <= high <= 1
+  void SetDirtyWatermarks(double low, double high);
+
+  inline double GetLowWatermark() const { return low_watermark_; }
+
+  inline double GetHighWatermark() const { return high_watermark_; }
+
+  inline size_t GetDirtyPageCount() const { return dirty_count_.load(); }
+
+  inline const BufferPoolStats &GetStats() const { return stats_; }
+
+  // cached pages and how often each was fetched since it was read into the
+  // pool
+  std::vector<std::pair<page_id_t, uint64_t>> GetPageAccessCounts();
+
+  // default dirty watermarks and period of the background flusher
+  static constexpr double LOW_WATERMARK = 0.05;
+  static constexpr double HIGH_WATERMARK = 0.2;
+  static constexpr std::chrono::milliseconds FLUSH_INTERVAL{50};
+  // default number of accesses the LRU-K replacer ranks pages by
+  static constexpr size_t LRU_K = 2;
+  // upper bound on the pages merged into one write
+  static constexpr size_t MAX_COALESCED_PAGES =
+      AsyncDiskManager::MAX_MERGED_PAGES;
+
 private:
-  size_t pool_size_;
-  // array of pages
-  Page *pages_;
+  // pin count of a frame that is free or being recycled, it cannot be pinned
+  // without the shard latch
+  static constexpr int FRAME_CLAIMED = -1;
+
+  // one independent partition of the buffer pool
+  struct BufferPoolShard {
+    BufferPoolShard(const std::vector<Page *> &frames, ReplacerPolicy policy,
+                    size_t lru_k);
+    ~BufferPoolShard();
+    void SetTargetSize(size_t target_size);
+    // frames owned by this shard and how many it should own
+    std::vector<Page *> frames_;
+    size_t target_size_;
+    ReplacerPolicy policy_;
+    // to keep track of page id and its memory location, Find needs no latch
+    HashTable<page_id_t, Page *> *page_table_;
+    // to collect unpinned pages for replacement
+    Replacer<Page *> *replacer_;
+    // to collect free pages for replacement
+    std::list<Page *> *free_list_;
+    // prefetched pages whose read may still be in flight
+    std::unordered_map<page_id_t, std::future<bool>> pending_reads_;
+    // dirty frames by page id, the flusher cleans the lowest ids first
+    std::map<page_id_t, Page *> dirty_pages_;
+    // to protect the shard's page table, replacer, free list, dirty list and
+    // the metadata of its frames
+    std::mutex latch_;
+  };
+
+  size_t GetShardIndex(page_id_t page_id);
+  size_t GetShardTargetSize(size_t shard_index, size_t pool_size);
+  BufferPoolShard *GetShard(page_id_t page_id);
+  Page *PinResidentPage(BufferPoolShard *shard, page_id_t page_id);
+  void UnpinStrayPage(Page *page);
+  bool ClaimFrame(Page *page);
+  Page *GetVictimPage(BufferPoolShard *shard);
+  Page *NewPageInShard(BufferPoolShard *shard, page_id_t page_id);
+  Page *GetRingVictimPage(page_id_t page_id, BufferRing *ring);
+  void EvictPage(BufferPoolShard *shard, Page *page);
+  void ReleaseBufferRing(BufferRing *ring);
+  void WriteBackAsync(Page *page);
+  void TrackWriteBack(page_id_t page_id, std::shared_future<bool> write);
+  bool WaitForWriteBack(page_id_t page_id);
+  void SetDirty(Page *page, bool is_dirty);
+  void FlusherLoop();
+  size_t CleanDirtyPages(size_t max_pages);
+  bool WaitForRead(BufferPoolShard *shard, page_id_t page_id);
+  std::vector<Page *> AcquireFrames(size_t count);
+  void ReleaseFrames(const std::vector<Page *> &frames);
+  void ReleaseExcessFrames(BufferPoolShard *shard);
+
+  std::atomic<size_t> pool_size_;
+  ReplacerPolicy policy_;
+  // frame contents and metadata, one arena per growth of the pool
+  std::mutex arena_latch_;
+  std::vector<std::unique_ptr<FrameArena>> arenas_;
+  // arenas whose frames were all released, their Page objects stay valid
+  std::vector<std::unique_ptr<FrameArena>> retired_arenas_;
+  // serializes resizes
+  std::mutex resize_latch_;
   DiskManager disk_manager_;
-  // to keep track of page id and its memory location
-  HashTable<page_id_t, Page *> *page_table_;
-  // to collect unpinned pages for replacement
-  Replacer<Page *> *replacer_;
-  // to collect free pages for replacement
-  std::list<Page *> *free_list_;
-  // to protect shared data structure, you may need it for synchronization
-  // between replacer and page table
-  std::mutex latch_;
+  AsyncDiskManager async_disk_manager_;
+  // write-backs of evicted pages that may still be in flight
+  std::mutex write_back_latch_;
+  std::unordered_map<page_id_t, std::shared_future<bool>> write_backs_;
+  std::vector<BufferPoolShard *> shards_;
+  BufferPoolStats stats_;
+
+  // background flusher
+  std::atomic<size_t> dirty_count_;
+  std::atomic<double> low_watermark_;
+  std::atomic<double> high_watermark_;
+  std::mutex flusher_latch_;
+  std::condition_variable flusher_cv_;
+  bool flush_requested_ = false;
+  bool stop_flusher_ = false;
+  std::thread flusher_;
 };
 } // namespace cmudb
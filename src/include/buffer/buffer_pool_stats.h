@@ -0,0 +1,62 @@
+/**
+ * buffer_pool_stats.h
+ *
+ * Event counters of a buffer pool: hits, misses, evictions, dirty write-backs
+ * and pin waits. Every thread increments its own cache-line sized slot with
+ * relaxed atomics, so counting never contends on a shared cache line. Reading
+ * a counter sums up all slots and is meant for monitoring only.
+ * The slots live in their own allocation, the object embedding the counters
+ * keeps its ordinary alignment.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "common/config.h"
+
+namespace cmudb {
+
+class BufferPoolStats {
+public:
+  enum Counter {
+    HITS,        // fetches served from the pool
+    MISSES,      // fetches that had to read the page
+    EVICTIONS,   // pages dropped to make room for another one
+    WRITE_BACKS, // dirty pages written to disk
+    PIN_WAITS,   // fetches that waited for an in-flight read or write
+    NUM_COUNTERS
+  };
+
+  BufferPoolStats();
+  BufferPoolStats(const BufferPoolStats &) = delete;
+  BufferPoolStats &operator=(const BufferPoolStats &) = delete;
+
+  inline void Add(Counter counter, uint64_t count = 1) {
+    slots_[GetSlotIndex()].counters_[counter].fetch_add(
+        count, std::memory_order_relaxed);
+  }
+
+  uint64_t Get(Counter counter) const;
+
+  static const char *GetName(Counter counter);
+
+  // number of per-thread slots, threads beyond it share slots
+  static constexpr size_t NUM_SLOTS = 64;
+
+private:
+  struct alignas(CACHE_LINE_SIZE) Slot {
+    std::atomic<uint64_t> counters_[NUM_COUNTERS] = {};
+  };
+
+  static size_t GetSlotIndex();
+
+  // NUM_SLOTS slots aligned to cache lines within memory_
+  std::unique_ptr<char[]> memory_;
+  Slot *slots_;
+};
+
+} // namespace cmudb
@@ -0,0 +1,46 @@
+/**
+ * buffer_ring.h
+ *
+ * A buffer ring is a small private set of frames used by one bulk operation,
+ * e.g. a full table scan. Pages fetched through the ring are read into the
+ * ring's own frames, which are recycled round robin as soon as they are
+ * unpinned instead of being handed to the replacer. A large scan therefore
+ * occupies at most the ring's frames and never evicts the working set of
+ * other users. The frames go back to the pool when the ring is destroyed.
+ *
+ * The frames are grabbed lazily from the pool on first use and are split
+ * evenly over the shards of the buffer pool.
+ */
+
+#pragma once
+
+#include <vector>
+
+#include "page/page.h"
+
+namespace cmudb {
+
+class BufferPoolManager;
+
+class BufferRing {
+  friend class BufferPoolManager;
+
+public:
+  BufferRing(BufferPoolManager *buffer_pool_manager, size_t size);
+  ~BufferRing();
+
+  BufferRing(const BufferRing &) = delete;
+  BufferRing &operator=(const BufferRing &) = delete;
+
+  inline size_t GetSize() const { return size_; }
+
+private:
+  BufferPoolManager *buffer_pool_manager_;
+  size_t size_;
+  // per shard: at most how many frames, the frames and the recycle position
+  size_t shard_capacity_;
+  std::vector<std::vector<Page *>> frames_;
+  std::vector<size_t> next_victim_;
+};
+
+} // namespace cmudb
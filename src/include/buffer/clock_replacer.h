@@ -0,0 +1,53 @@
+/**
+ * clock_replacer.h
+ *
+ * Functionality: CLOCK (second chance) replacement. Values sit on a circular
+ * buffer with a reference bit that is set whenever they are inserted. The
+ * clock hand sweeps over the evictable values, clearing set reference bits and
+ * evicting the first value whose bit is already clear. Approximates LRU
+ * without reordering a list on every unpin.
+ */
+
+#pragma once
+
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "buffer/replacer.h"
+
+namespace cmudb {
+
+template <typename T> class ClockReplacer : public Replacer<T> {
+public:
+  ClockReplacer();
+
+  ~ClockReplacer();
+
+  void Insert(const T &value);
+
+  bool Victim(T &value);
+
+  bool Erase(const T &value);
+
+  size_t Size();
+
+private:
+  struct Slot {
+    T value_;
+    bool in_use_;
+    bool evictable_;
+    bool referenced_;
+  };
+
+  std::vector<Slot> ring_;
+  // slot of every value on the ring
+  std::unordered_map<T, size_t> slots_;
+  // slots released by evicted values
+  std::vector<size_t> free_slots_;
+  size_t hand_ = 0;
+  size_t evictable_count_ = 0;
+  std::mutex latch_;
+};
+
+} // namespace cmudb
@@ -0,0 +1,71 @@
+/**
+ * frame_arena.h
+ *
+ * Memory behind the frames of a buffer pool. The page contents of all frames
+ * live in one region backed by 2 MiB huge pages, so even a large pool is
+ * covered by a handful of TLB entries. Where no huge pages are reserved the
+ * region is mapped with ordinary pages, aligned to the huge page size and
+ * offered to transparent huge pages instead.
+ *
+ * The Page objects carrying the frame metadata (page id, pin count, dirty
+ * flag, latch) sit in a separate array. Every Page is padded to whole cache
+ * lines, updating the pin count of one frame therefore never invalidates a
+ * cache line of another frame or of any page content.
+ *
+ * A shrinking buffer pool releases single frames to their arena. The memory
+ * of their contents goes back to the operating system and the frames are
+ * reclaimed first when the pool grows again.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "page/page.h"
+
+namespace cmudb {
+
+class FrameArena {
+public:
+  explicit FrameArena(size_t num_frames);
+  ~FrameArena();
+
+  FrameArena(const FrameArena &) = delete;
+  FrameArena &operator=(const FrameArena &) = delete;
+
+  // the num_frames pages, each already pointing at its zeroed content
+  inline Page *GetPages() { return pages_; }
+
+  inline size_t GetNumFrames() const { return num_frames_; }
+
+  // whether the page contents are backed by explicitly reserved huge pages
+  inline bool IsUsingHugePages() const { return huge_pages_; }
+
+  inline bool Contains(const Page *page) const {
+    return page >= pages_ && page < pages_ + num_frames_;
+  }
+
+  // hand back an unused frame of this arena, its content becomes zero
+  void ReleaseFrame(Page *page);
+  // take a released frame again, nullptr if there is none
+  Page *ReclaimFrame();
+
+  inline size_t GetNumReleased() const { return released_.size(); }
+
+  // unmap the contents of all frames, the Page objects stay valid
+  void ReleaseContents();
+
+private:
+  static void *MapRegion(size_t size, bool huge_pages);
+
+  size_t num_frames_;
+  char *data_ = nullptr;
+  size_t data_size_ = 0;
+  Page *pages_ = nullptr;
+  size_t pages_size_ = 0;
+  bool huge_pages_ = false;
+  std::vector<Page *> released_;
+};
+
+} // namespace cmudb
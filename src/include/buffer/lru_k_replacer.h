@@ -0,0 +1,66 @@
+/**
+ * lru_k_replacer.h
+ *
+ * Functionality: LRU-K replacement. Every value remembers the timestamps of
+ * its last K references (a reference being an Insert, i.e. the page became
+ * unpinned after use). The victim is the evictable value whose K-th most
+ * recent reference lies furthest in the past. Values referenced fewer than K
+ * times have an infinite backward K-distance and are evicted first, oldest
+ * first reference first, so pages touched once by a sequential scan leave the
+ * pool before pages that are used repeatedly.
+ *
+ * References that follow the previous reference of the same value within
+ * correlated_period ticks are correlated (e.g. a scan unpinning the same page
+ * once per tuple) and only refresh the latest timestamp.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <set>
+#include <unordered_map>
+#include <utility>
+
+#include "buffer/replacer.h"
+
+namespace cmudb {
+
+template <typename T> class LRUKReplacer : public Replacer<T> {
+public:
+  explicit LRUKReplacer(size_t k = 2, uint64_t correlated_period = 1);
+
+  ~LRUKReplacer();
+
+  void Insert(const T &value);
+
+  bool Victim(T &value);
+
+  bool Erase(const T &value);
+
+  size_t Size();
+
+private:
+  struct History {
+    // most recent reference at the back, at most k_ entries
+    std::deque<uint64_t> timestamps_;
+    bool evictable_ = false;
+  };
+  // ordering key of an evictable value within its queue
+  std::pair<uint64_t, T> QueueKey(const T &value, const History &history);
+  void Enqueue(const T &value, const History &history);
+  void Dequeue(const T &value, const History &history);
+
+  size_t k_;
+  uint64_t correlated_period_;
+  uint64_t current_timestamp_ = 0;
+  std::unordered_map<T, History> history_;
+  // evictable values with fewer than k_ references, by first reference
+  std::set<std::pair<uint64_t, T>> cold_queue_;
+  // evictable values with k_ references, by k-th most recent reference
+  std::set<std::pair<uint64_t, T>> hot_queue_;
+  std::mutex latch_;
+};
+
+} // namespace cmudb
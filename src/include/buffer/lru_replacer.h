@@ -9,6 +9,9 @@
 
 #pragma once
 
+#include <list>
+#include <mutex>
+
 #include "buffer/replacer.h"
 #include "hash/extendible_hash.h"
 
@@ -30,7 +33,11 @@ public:
   size_t Size();
 
 private:
-  // add your member variables here
+  // least recently used value at the front, most recently used at the back
+  std::list<T> lru_list_;
+  // to locate a value's position in lru_list_ in constant time
+  ExtendibleHash<T, typename std::list<T>::iterator> lru_map_;
+  std::mutex latch_;
 };
 
 } // namespace cmudb
@@ -0,0 +1,114 @@
+/**
+ * page_guard.h
+ *
+ * Move-only handles of a pinned page returned by the buffer pool. A guard
+ * unlatches and unpins its page when it goes out of scope or is released, so
+ * callers no longer pair FetchPage/RLatch/RUnlatch/UnpinPage by hand.
+ *
+ * ReadPageGuard: the page is read latched.
+ * WritePageGuard: the page is write latched, it is unpinned dirty unless the
+ * holder says otherwise.
+ * OptimisticPageGuard: the page is only pinned. Reads of its content are
+ * validated against the page version afterwards and have to be retried when
+ * a writer got in between. Nothing is written to the page's cache lines, so
+ * short reads of hot pages do not bounce them between cores.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+#include "page/page.h"
+
+namespace cmudb {
+
+class BufferPoolManager;
+
+// shared bookkeeping of the guards, the page is pinned by the guard
+class PageGuard {
+public:
+  PageGuard(const PageGuard &) = delete;
+  PageGuard &operator=(const PageGuard &) = delete;
+
+  // whether the guard holds a page, fetching may have failed
+  inline explicit operator bool() const { return page_ != nullptr; }
+
+  inline Page *GetPage() const { return page_; }
+
+  inline page_id_t GetPageId() const { return page_->GetPageId(); }
+
+  inline char *GetData() const { return page_->GetData(); }
+
+  // the page as one of its subclasses, e.g. TablePage
+  template <typename T> inline T *As() const { return static_cast<T *>(page_); }
+
+protected:
+  PageGuard() = default;
+  PageGuard(BufferPoolManager *buffer_pool_manager, Page *page)
+      : buffer_pool_manager_(buffer_pool_manager), page_(page) {}
+  ~PageGuard() = default;
+
+  // take over other's page, the caller released its own one
+  void MoveFrom(PageGuard &other);
+
+  BufferPoolManager *buffer_pool_manager_ = nullptr;
+  Page *page_ = nullptr;
+};
+
+class ReadPageGuard : public PageGuard {
+public:
+  ReadPageGuard() = default;
+  // page: pinned and read latched by the caller
+  ReadPageGuard(BufferPoolManager *buffer_pool_manager, Page *page)
+      : PageGuard(buffer_pool_manager, page) {}
+  ReadPageGuard(ReadPageGuard &&other) { MoveFrom(other); }
+  ReadPageGuard &operator=(ReadPageGuard &&other);
+  ~ReadPageGuard() { Release(); }
+
+  // unlatch and unpin the page early
+  void Release();
+};
+
+class WritePageGuard : public PageGuard {
+public:
+  WritePageGuard() = default;
+  // page: pinned and write latched by the caller
+  WritePageGuard(BufferPoolManager *buffer_pool_manager, Page *page)
+      : PageGuard(buffer_pool_manager, page) {}
+  WritePageGuard(WritePageGuard &&other);
+  WritePageGuard &operator=(WritePageGuard &&other);
+  ~WritePageGuard() { Release(); }
+
+  // whether the page is unpinned dirty, true by default
+  inline void SetDirty(bool is_dirty) { is_dirty_ = is_dirty; }
+
+  // unlatch and unpin the page early
+  void Release();
+
+private:
+  bool is_dirty_ = true;
+};
+
+class OptimisticPageGuard : public PageGuard {
+public:
+  OptimisticPageGuard() = default;
+  // page: pinned by the caller
+  OptimisticPageGuard(BufferPoolManager *buffer_pool_manager, Page *page);
+  OptimisticPageGuard(OptimisticPageGuard &&other);
+  OptimisticPageGuard &operator=(OptimisticPageGuard &&other);
+  ~OptimisticPageGuard() { Release(); }
+
+  // whether the content read since the last restart is consistent
+  inline bool Validate() const { return page_->ValidateVersion(version_); }
+
+  // start reading again, waits for a writer currently holding the page
+  void Restart();
+
+  // unpin the page early
+  void Release();
+
+private:
+  uint64_t version_ = 0;
+};
+
+} // namespace cmudb
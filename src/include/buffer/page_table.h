@@ -0,0 +1,70 @@
+/**
+ * page_table.h
+ *
+ * Maps the page ids cached by a buffer pool shard to their frames. An open
+ * addressing table with linear probing whose slots are atomic, so that Find
+ * takes no lock and writes nothing.
+ *
+ * Insert and Remove must be serialized by the caller (the shard latch), but
+ * may run concurrently with any number of Find calls. Removal shifts later
+ * entries of the probe sequence back instead of leaving tombstones. A Find
+ * racing with a writer may therefore miss an entry that is present, or
+ * return the frame of an entry that is being removed; callers have to
+ * validate the frame and fall back to a latched lookup. Outgrown slot arrays
+ * are retired but only freed with the table, since a concurrent Find may
+ * still be probing them.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "hash/hash_table.h"
+#include "page/page.h"
+
+namespace cmudb {
+
+class PageTable : public HashTable<page_id_t, Page *> {
+public:
+  // capacity: number of entries expected, the table grows beyond it
+  explicit PageTable(size_t capacity);
+
+  bool Find(const page_id_t &page_id, Page *&page) override;
+  bool Remove(const page_id_t &page_id) override;
+  void Insert(const page_id_t &page_id, Page *const &page) override;
+
+  inline size_t GetSize() const { return size_; }
+
+  inline size_t GetCapacity() const {
+    return slots_.load(std::memory_order_relaxed)->capacity_;
+  }
+
+private:
+  struct Slot {
+    std::atomic<page_id_t> page_id_{INVALID_PAGE_ID};
+    std::atomic<Page *> page_{nullptr};
+  };
+
+  struct Slots {
+    explicit Slots(size_t capacity)
+        : capacity_(capacity), slots_(new Slot[capacity]) {}
+    size_t capacity_;
+    std::unique_ptr<Slot[]> slots_;
+  };
+
+  // id of a slot whose entry is being replaced, probing goes on past it
+  static constexpr page_id_t MOVING_PAGE_ID = -2;
+
+  static size_t HashIndex(page_id_t page_id, size_t capacity);
+  void Grow();
+
+  // current slot array, capacity is a power of two
+  std::atomic<Slots *> slots_;
+  // all slot arrays ever used, the last one is current
+  std::vector<std::unique_ptr<Slots>> arrays_;
+  size_t size_ = 0;
+};
+
+} // namespace cmudb
@@ -9,6 +9,9 @@
 
 namespace cmudb {
 
+// replacement policies the buffer pool manager can be configured with
+enum class ReplacerPolicy { LRU = 0, LRU_K, TWO_QUEUE, CLOCK };
+
 template <typename T> class Replacer {
 public:
   Replacer() {}
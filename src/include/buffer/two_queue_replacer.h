@@ -0,0 +1,66 @@
+/**
+ * two_queue_replacer.h
+ *
+ * Functionality: 2Q replacement. A value seen for the first time enters the
+ * A1 FIFO queue and is only promoted to the Am LRU queue once it is referenced
+ * again while still resident. Victims come from A1 as long as it holds more
+ * than a1_max values, so a sequential scan recycles its own A1 frames instead
+ * of flushing the frequently used pages kept in Am.
+ *
+ * The replacer only sees resident values (buffer frames), so there is no A1out
+ * ghost queue of evicted page ids: promotion requires the second reference to
+ * arrive while the page is still cached. Back-to-back references of the same
+ * value with no other reference in between are correlated (e.g. a scan
+ * unpinning the same page once per tuple) and do not promote it.
+ */
+
+#pragma once
+
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+#include "buffer/replacer.h"
+
+namespace cmudb {
+
+template <typename T> class TwoQueueReplacer : public Replacer<T> {
+public:
+  explicit TwoQueueReplacer(size_t a1_max);
+
+  ~TwoQueueReplacer();
+
+  void Insert(const T &value);
+
+  bool Victim(T &value);
+
+  bool Erase(const T &value);
+
+  size_t Size();
+
+  // change how many values A1 may hold before it is preferred for eviction
+  void SetA1Max(size_t a1_max);
+
+private:
+  struct Entry {
+    bool in_am_ = false;
+    bool evictable_ = false;
+    // position in a1_list_ or am_list_, only valid while evictable
+    typename std::list<T>::iterator pos_;
+  };
+  void Forget(const T &value);
+
+  size_t a1_max_;
+  // number of resident values (pinned or not) currently classified as A1
+  size_t a1_count_ = 0;
+  // evictable values, oldest at the front
+  std::list<T> a1_list_;
+  std::list<T> am_list_;
+  std::unordered_map<T, Entry> entries_;
+  // most recently inserted value, to detect correlated references
+  bool has_last_ = false;
+  T last_;
+  std::mutex latch_;
+};
+
+} // namespace cmudb
@@ -13,6 +13,17 @@ namespace cmudb {
 #define HEADER_PAGE_ID 0   // the header page id
 #define PAGE_SIZE 4096     // size of a data page in byte
 #define BUCKET_SIZE 50     // size of extendible hash bucket
+#define HEADER_PAGE_RESERVED 8 // trailing bytes of the header page kept by
+                               // the disk manager
+#define READAHEAD_PAGES 16 // default readahead window of table scans
+#define BUFFER_RING_SIZE 32 // frames used by a bulk read table scan
+#define BUFFER_POOL_SIZE 100 // initial frames of the extension's buffer pool
+#define MAX_BUFFER_POOL_SIZE (1 << 18) // frames the buffer pool may grow to
+#define CACHE_LINE_SIZE 64  // size of a cpu cache line in byte
+#define HUGE_PAGE_SIZE (2 * 1024 * 1024) // size of a huge page in byte
+#define SORT_RUN_SIZE 65536 // pairs an external sort keeps in memory
+#define BULK_LOAD_FILL_FACTOR 0.9 // share of a page filled by a bulk load
+#define KEY_SEARCH_WINDOW 32 // keys a leaf search compares at once
 
 typedef int32_t page_id_t; // page id type
 typedef int32_t txn_id_t;  // transaction id type
@@ -0,0 +1,115 @@
+/**
+ * async_disk_manager.h
+ *
+ * Asynchronous page I/O on top of a DiskManager. Reads and writes are queued
+ * with ReadPageAsync/WritePageAsync, handed to the kernel in one batch by
+ * Submit(), and report their completion through the returned future.
+ *
+ * Requests are submitted through an io_uring instance driven by raw system
+ * calls, a reaper thread collects completions. Where io_uring is not
+ * available (old kernel, seccomp, non-Linux build) the same interface is
+ * served by a small pool of threads issuing blocking pread/pwrite.
+ *
+ * Writes of the same page complete in the order they were queued: a request
+ * touching a page with an incomplete earlier write is held back until that
+ * write completes, so callers never have to wait for a write before queueing
+ * the next one. Writes of consecutive pages dispatched together are merged
+ * into one vectored transfer.
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "disk/disk_manager.h"
+
+namespace cmudb {
+
+struct AsyncRequest;
+
+class AsyncDiskManager {
+public:
+  explicit AsyncDiskManager(DiskManager *disk_manager,
+                            unsigned queue_depth = 64, size_t num_threads = 4);
+  ~AsyncDiskManager();
+
+  AsyncDiskManager(const AsyncDiskManager &) = delete;
+  AsyncDiskManager &operator=(const AsyncDiskManager &) = delete;
+
+  // page_data must stay valid until the returned future is ready
+  std::future<bool> ReadPageAsync(page_id_t page_id, char *page_data);
+  // page_data is copied, the caller may reuse it as soon as this returns
+  std::future<bool> WritePageAsync(page_id_t page_id, const char *page_data);
+  // one write of consecutive pages starting at page_id, pages[i] is the
+  // content of page_id + i and is copied as well
+  std::future<bool> WritePagesAsync(page_id_t page_id,
+                                    const std::vector<const char *> &pages);
+
+  // hand all queued requests to the backend in one batch
+  void Submit();
+
+  inline bool IsUsingIoUring() const { return ring_fd_ >= 0; }
+
+  // upper bound on the pages merged into one transfer
+  static constexpr size_t MAX_MERGED_PAGES = 32;
+
+private:
+  std::future<bool> Enqueue(AsyncRequest *request);
+  void Dispatch(std::vector<AsyncRequest *> &batch);
+  void Complete(AsyncRequest *request, int result);
+
+  // io_uring backend
+  bool SetupRing(unsigned queue_depth);
+  void TeardownRing();
+  void FillRing();
+  void ReapCompletions();
+
+  // thread pool backend
+  void WorkerLoop();
+
+  DiskManager *disk_manager_;
+  // protects pending_, last_writes_, the request chains, the submission
+  // queue and the worker queue
+  std::mutex latch_;
+  // requests queued since the last Submit()
+  std::vector<AsyncRequest *> pending_;
+  // page id -> last queued write of that page that has not completed yet
+  std::unordered_map<page_id_t, AsyncRequest *> last_writes_;
+  bool shutdown_ = false;
+
+  // io_uring state, ring memory is shared with the kernel
+  int ring_fd_ = -1;
+  unsigned sq_entries_ = 0;
+  unsigned in_flight_ = 0;
+  // dispatched transfers waiting for room in the ring
+  std::deque<AsyncRequest *> ring_queue_;
+  // signalled whenever completions leave the ring
+  std::condition_variable ring_space_;
+  void *sq_ring_ptr_ = nullptr;
+  void *cq_ring_ptr_ = nullptr;
+  void *sqes_ptr_ = nullptr;
+  size_t sq_ring_size_ = 0;
+  size_t cq_ring_size_ = 0;
+  size_t sqes_size_ = 0;
+  unsigned *sq_tail_ = nullptr;
+  unsigned *sq_mask_ = nullptr;
+  unsigned *sq_array_ = nullptr;
+  unsigned *cq_head_ = nullptr;
+  unsigned *cq_tail_ = nullptr;
+  unsigned *cq_mask_ = nullptr;
+  void *cqes_ = nullptr;
+  std::thread reaper_;
+
+  // thread pool state
+  std::deque<AsyncRequest *> ready_queue_;
+  std::condition_variable ready_cv_;
+  std::vector<std::thread> workers_;
+};
+
+} // namespace cmudb
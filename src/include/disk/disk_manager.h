@@ -5,33 +5,93 @@
  * database. It also performs read and write of pages to and from disk, and
  * provides a logical file layer within the context of a database management
  * system.
+ *
+ * Pages are transferred with positional pread/pwrite on a plain file
+ * descriptor, so concurrent readers and writers never share a file cursor or
+ * a lock. The file length is tracked in memory instead of being queried from
+ * the file system on every read.
+ *
+ * Once the first page is deallocated, allocation is tracked in free space
+ * bitmap pages. Each bitmap page covers a fixed range of BITMAP_PAGE_BITS page
+ * ids, the bitmap pages form a chain whose head is recorded in the trailer of
+ * the header page, and AllocatePage hands out the lowest free page id so that
+ * freed pages are reused before the file grows. Bitmap pages are written
+ * through on every change and are never cached by the buffer pool.
+ *
+ * Bitmap page format (size in byte):
+ *  -----------------------------------------------------------
+ * | Next bitmap page_id (4) | Reserved (4) | Bits (4088) |
+ *  -----------------------------------------------------------
  */
 
 #pragma once
 #include <atomic>
-#include <fstream>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <vector>
 
 #include "common/config.h"
 
 namespace cmudb {
 
 class DiskManager {
+  friend class AsyncDiskManager;
+
 public:
   DiskManager(const std::string &db_file);
   ~DiskManager();
 
   void WritePage(page_id_t page_id, const char *page_data);
+  void WritePages(page_id_t page_id, const char *page_data, size_t num_pages);
   void ReadPage(page_id_t page_id, char *page_data);
 
   page_id_t AllocatePage();
   void DeallocatePage(page_id_t page_id);
 
+  inline int64_t GetFileSize() const { return file_size_.load(); }
+
+  // one past the highest page id ever allocated
+  inline page_id_t GetNextPageId() const { return next_page_id_.load(); }
+
+  // page ids covered by one bitmap page
+  static constexpr int BITMAP_PAGE_BITS = (PAGE_SIZE - 8) * 8;
+
 private:
-  int GetFileSize();
-  std::fstream db_io_;
+  // in-memory image of one bitmap page
+  struct BitmapPage {
+    page_id_t page_id_;
+    std::unique_ptr<char[]> data_;
+  };
+
+  void ExtendFileSize(int64_t end);
+  void WritePageData(page_id_t page_id, const char *page_data,
+                     size_t num_pages = 1);
+  void StampHeaderTrailer(char *page_data);
+
+  // free space bitmap helpers, caller must hold bitmap_latch_
+  void LoadBitmaps();
+  void InitBitmaps();
+  void AppendBitmap();
+  void SetAllocated(page_id_t page_id, bool allocated);
+  bool IsAllocated(page_id_t page_id);
+  page_id_t FindFreePage(page_id_t from);
+  void WriteAnchor(page_id_t first_bitmap_page_id);
+
+  int db_fd_;
   std::string file_name_;
   std::atomic<page_id_t> next_page_id_;
+  // length of the database file in bytes, only ever grows
+  std::atomic<int64_t> file_size_;
+
+  // protects the bitmaps and serializes writes of the header page
+  std::mutex bitmap_latch_;
+  // empty until the first page is deallocated
+  std::vector<BitmapPage> bitmaps_;
+  // no page id below this one is free
+  page_id_t free_hint_;
+  // head of the bitmap chain recorded in the header page trailer
+  std::atomic<page_id_t> first_bitmap_page_id_;
 };
 
 } // namespace cmudb
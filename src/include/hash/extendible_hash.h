@@ -9,16 +9,43 @@
 
 #pragma once
 
+#include <atomic>
+#include <cstdint>
 #include <cstdlib>
-#include <vector>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <utility>
+#include <vector>
 
+#include "common/rwmutex.h"
 #include "hash/hash_table.h"
 
 namespace cmudb {
 
+/*
+ * Concurrency: the directory is guarded by a reader-writer latch and every
+ * bucket by its own latch. Lookups and modifications take the directory
+ * latch shared and then latch only their bucket, so operations on different
+ * buckets run in parallel. A full bucket below global depth is split under
+ * its own latch; the directory latch is taken exclusively only to double the
+ * directory, or to merge a bucket that a removal emptied and shrink the
+ * directory after it.
+ */
 template <typename K, typename V>
 class ExtendibleHash : public HashTable<K, V> {
+  // a bucket holds at most bucket_size_ entries that share the lowest
+  // local_depth_ bits of their hash value. fingerprints_[i] holds 8 high bits
+  // of the hash of items_[i], a lookup scans them with SIMD compares before
+  // comparing any key.
+  struct Bucket {
+    explicit Bucket(int depth) : local_depth_(depth) {}
+    int local_depth_;
+    std::vector<std::pair<K, V>> items_;
+    std::vector<uint8_t> fingerprints_;
+    std::mutex latch_;
+  };
+
 public:
   // constructor
   ExtendibleHash(size_t size);
@@ -34,6 +61,26 @@ public:
   void Insert(const K &key, const V &value) override;
 
 private:
-  // add your own member variables here
+  size_t BucketIndex(const K &key);
+  Bucket *LockBucket(const K &key);
+  static uint8_t Fingerprint(size_t hash);
+  int FindItem(const Bucket *bucket, const K &key, uint8_t fingerprint);
+  void RemoveItem(Bucket *bucket, size_t index);
+  void SplitBucket(Bucket *bucket);
+  void GrowDirectory();
+  void MergeBucket(const K &key);
+  void ShrinkDirectory();
+
+  // only changed while the directory latch is held exclusively
+  int global_depth_;
+  size_t bucket_size_;
+  // directory entry i points to the bucket of hash values whose lowest
+  // global_depth_ bits equal i. Entries are redirected by splits that only
+  // hold the directory latch shared, hence atomic.
+  std::vector<std::atomic<Bucket *>> directory_;
+  mutable RWMutex directory_latch_;
+  // owns all live buckets, guarded by buckets_latch_
+  std::vector<std::unique_ptr<Bucket>> buckets_;
+  mutable std::mutex buckets_latch_;
 };
 } // namespace cmudb
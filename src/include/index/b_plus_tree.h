@@ -7,12 +7,41 @@
  * (2) support insert & remove
  * (3) The structure should shrink and grow dynamically
  * (4) Implement index iterator for range scan
+ *
+ * Latching: this is a B-link tree, every page has a high key and a link to
+ * its right sibling on the same level. Lookups and inserts descend holding
+ * one latch at a time, a page that split after its parent was read is left
+ * through its right link. A split links the new page in first and then
+ * inserts the separator into the parent remembered on the way down, moving
+ * right from there as well, so an insert holds at most the split page, its
+ * new sibling and their parent. Latches are only taken bottom-up or left to
+ * right.
+ * Right links cannot follow keys that move left or pages that go away, so a
+ * removal that underflows its leaf takes the structure latch exclusively and
+ * merges with write latches on the path as in a plain B+ tree. Everything
+ * else holds it shared. Iterators couple leaf latches from left to right,
+ * merges latch the left sibling first.
+ *
+ * Bulk loading builds an empty tree bottom-up from sorted pairs: leaves are
+ * packed left to right, every page is linked into its parent once the page
+ * right of it is complete. The last two pages of a level are balanced at the
+ * end, so no page ends up below its min size.
+ *
+ * Internal pages keep variable-length keys (see b_plus_tree_internal_page.h).
+ * They split before an insert that does not fit, and merge or redistribute
+ * only where the keys fit. A page that can do neither stays below its min
+ * size, the min size of internal pages is a soft one.
  */
 #pragma once
 
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <mutex>
 #include <queue>
 #include <vector>
 
+#include "common/rwmutex.h"
 #include "concurrency/transaction.h"
 #include "index/index_iterator.h"
 #include "page/b_plus_tree_internal_page.h"
@@ -21,6 +50,8 @@
 namespace cmudb {
 
 #define BPLUSTREE_TYPE BPlusTree<KeyType, ValueType, KeyComparator>
+#define BPLUSTREE_INTERNAL_PAGE_TYPE                                           \
+  BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator>
 // Main class providing the API for the Interactive B+ Tree.
 INDEX_TEMPLATE_ARGUMENTS
 class BPlusTree {
@@ -28,7 +59,9 @@ public:
   explicit BPlusTree(const std::string &name,
                            BufferPoolManager *buffer_pool_manager,
                            const KeyComparator &comparator,
-                           page_id_t root_page_id = INVALID_PAGE_ID);
+                           page_id_t root_page_id = INVALID_PAGE_ID,
+                           int leaf_max_size = LEAF_PAGE_SIZE,
+                           int internal_max_size = INTERNAL_PAGE_SIZE);
 
   // Returns true if this B+ tree has no keys and values.
   bool IsEmpty() const;
@@ -44,9 +77,19 @@ public:
   bool GetValue(const KeyType &key, std::vector<ValueType> &result,
                 Transaction *transaction = nullptr);
 
+  // pulls the next pair to bulk load, false once the input is exhausted
+  using PairSource = std::function<bool(KeyType &key, ValueType &value)>;
+
+  // Build this empty B+ tree from key-value pairs in ascending key order.
+  bool BulkLoad(const PairSource &source,
+                double fill_factor = BULK_LOAD_FILL_FACTOR,
+                Transaction *transaction = nullptr);
+
   // index iterator
   INDEXITERATOR_TYPE Begin();
   INDEXITERATOR_TYPE Begin(const KeyType &key);
+  // iterate over the keys from key up to but not including end_key
+  INDEXITERATOR_TYPE Begin(const KeyType &key, const KeyType &end_key);
 
   // Print this B+ tree to stdout using a simple command-line
   std::string ToString(bool verbose = false);
@@ -63,37 +106,88 @@ public:
                                            bool leftMost = false);
 
 private:
+  ReadPageGuard FetchRootRead();
+  WritePageGuard FetchRootWrite();
+
+  ReadPageGuard Descend(const KeyType &key, int level, bool leftMost,
+                        std::vector<page_id_t> *path);
+  ReadPageGuard FetchLeafRead(const KeyType &key, bool leftMost = false);
+  WritePageGuard FetchLeafWrite(const KeyType &key,
+                                std::vector<page_id_t> *path);
+  void FetchPathWrite(const KeyType &key, std::deque<WritePageGuard> &path);
+
+  page_id_t RightLink(BPlusTreePage *node, const KeyType &key) const;
+  void MoveRight(const KeyType &key, ReadPageGuard &guard);
+  void MoveRight(const KeyType &key, WritePageGuard &guard);
+
+  Page *FetchPinnedPage(page_id_t page_id);
+
+  int GetLevel(BPlusTreePage *node) const;
+
+  bool IsSafe(BPlusTreePage *node) const;
+
   void StartNewTree(const KeyType &key, const ValueType &value);
 
   bool InsertIntoLeaf(const KeyType &key, const ValueType &value,
                       Transaction *transaction = nullptr);
 
-  void InsertIntoParent(BPlusTreePage *old_node, const KeyType &key,
-                        BPlusTreePage *new_node,
-                        Transaction *transaction = nullptr);
+  KeyType ShortSeparator(const KeyType &left, const KeyType &right) const;
+
+  void InsertIntoParent(WritePageGuard &old_guard, const KeyType &key,
+                        WritePageGuard &new_guard,
+                        std::vector<page_id_t> &path);
 
-  template <typename N> N *Split(N *node);
+  template <typename N> WritePageGuard Split(N *node);
 
   template <typename N>
-  bool CoalesceOrRedistribute(N *node, Transaction *transaction = nullptr);
+  bool CoalesceOrRedistribute(N *node, std::deque<WritePageGuard> &path);
 
   template <typename N>
-  bool Coalesce(
-      N *&neighbor_node, N *&node,
-      BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator> *&parent,
-      int index, Transaction *transaction = nullptr);
+  bool Coalesce(N *&neighbor_node, N *&node,
+                BPLUSTREE_INTERNAL_PAGE_TYPE *&parent, int index);
+
+  template <typename N>
+  bool CanRedistribute(N *neighbor_node, N *node,
+                       BPLUSTREE_INTERNAL_PAGE_TYPE *parent, int index) const;
 
   template <typename N> void Redistribute(N *neighbor_node, N *node, int index);
 
   bool AdjustRoot(BPlusTreePage *node);
 
+  // the pages of a level a bulk load may still change, the right one is
+  // filled, the left one waits to be linked into its parent
+  struct BulkLoadLevel {
+    WritePageGuard left;
+    WritePageGuard right;
+  };
+
+  int BulkLoadFillSize(size_t level, double fill_factor) const;
+
+  template <typename N, typename V>
+  N *BulkLoadAppend(std::vector<BulkLoadLevel> &levels, size_t level,
+                    const KeyType &key, const V &value, double fill_factor);
+
+  void BulkLoadLink(std::vector<BulkLoadLevel> &levels, size_t level,
+                    double fill_factor);
+
+  template <typename N> void BulkLoadBalance(BulkLoadLevel &pages);
+
+  page_id_t BulkLoadFinish(std::vector<BulkLoadLevel> &levels,
+                           double fill_factor);
+
   void UpdateRootPageId(int insert_record = false);
 
   // member variable
   std::string index_name_;
-  page_id_t root_page_id_;
+  std::atomic<page_id_t> root_page_id_;
   BufferPoolManager *buffer_pool_manager_;
   KeyComparator comparator_;
+  int leaf_max_size_;
+  int internal_max_size_;
+  // serializes starting a new tree when the tree is empty
+  std::mutex root_latch_;
+  // exclusive for removals that merge pages, shared for everything else
+  RWMutex structure_latch_;
 };
 
 } // namespace cmudb
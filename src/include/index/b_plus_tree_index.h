@@ -34,7 +34,13 @@ public:
   void ScanKey(const Tuple &key, std::vector<RID> &result,
                Transaction *transaction = nullptr) override;
 
+  void ScanRange(const ScanBound &low, const ScanBound &high,
+                 std::vector<RID> &result,
+                 Transaction *transaction = nullptr) override;
+
 protected:
+  static bool SetToSuccessor(KeyType &key, size_t size);
+
   // comparator for key
   KeyComparator comparator_;
   // container
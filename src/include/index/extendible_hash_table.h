@@ -0,0 +1,86 @@
+/**
+ * extendible_hash_table.h
+ *
+ * Disk resident extendible hash table whose directory and bucket pages live
+ * in the buffer pool. An equality probe reads the directory and one bucket.
+ * (1) We only support unique key
+ * (2) support insert & remove
+ * (3) Buckets split and merge, the directory doubles and halves up to
+ *     DIRECTORY_MAX_DEPTH. A full bucket at that depth is extended by a chain
+ *     of overflow pages.
+ *
+ * Latching: every operation latches the directory before its bucket. Lookups
+ * and modifications that fit into their bucket hold the directory read
+ * latched, splits and merges write latched.
+ */
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "concurrency/transaction.h"
+#include "page/hash_table_bucket_page.h"
+#include "page/hash_table_directory_page.h"
+
+namespace cmudb {
+
+#define EXTENDIBLE_HASH_TABLE_TYPE                                             \
+  ExtendibleHashTable<KeyType, ValueType, KeyComparator>
+
+INDEX_TEMPLATE_ARGUMENTS
+class ExtendibleHashTable {
+public:
+  explicit ExtendibleHashTable(const std::string &name,
+                               BufferPoolManager *buffer_pool_manager,
+                               const KeyComparator &comparator,
+                               page_id_t directory_page_id = INVALID_PAGE_ID);
+
+  // Returns true if this hash table has no keys and values.
+  bool IsEmpty() const;
+
+  // Insert a key-value pair, false if the key exists or the buffer pool is
+  // out of frames
+  bool Insert(const KeyType &key, const ValueType &value,
+              Transaction *transaction = nullptr);
+
+  // Remove a key and its value from this hash table.
+  void Remove(const KeyType &key, Transaction *transaction = nullptr);
+
+  // return the value associated with a given key
+  bool GetValue(const KeyType &key, std::vector<ValueType> &result,
+                Transaction *transaction = nullptr);
+
+  // expose for test purpose
+  page_id_t GetDirectoryPageId() const;
+  uint32_t GetGlobalDepth();
+
+private:
+  uint32_t Hash(const KeyType &key) const;
+
+  bool StartNewTable();
+
+  bool SplitInsert(const KeyType &key, const ValueType &value);
+
+  void Merge(const KeyType &key);
+
+  bool ChainLookup(const HASH_TABLE_BUCKET_PAGE_TYPE *bucket,
+                   const KeyType &key, ValueType &value);
+
+  bool ChainInsert(HASH_TABLE_BUCKET_PAGE_TYPE *bucket, const KeyType &key,
+                   const ValueType &value);
+
+  bool ChainRemove(HASH_TABLE_BUCKET_PAGE_TYPE *bucket, const KeyType &key);
+
+  // member variable
+  std::string index_name_;
+  std::atomic<page_id_t> directory_page_id_;
+  BufferPoolManager *buffer_pool_manager_;
+  KeyComparator comparator_;
+  // serializes creating the directory of an empty table
+  std::mutex latch_;
+};
+
+} // namespace cmudb
@@ -0,0 +1,52 @@
+/**
+ * external_sorter.h
+ *
+ * Sort key & value pairs that do not fit in memory, e.g. to bulk load a b+
+ * tree from unsorted input.
+ * Pairs are collected into runs of run_size pairs, every full run is sorted
+ * and spilled to a temporary file. Reading the pairs back merges the runs,
+ * each run is read sequentially.
+ */
+#pragma once
+
+#include <cstdio>
+#include <vector>
+
+#include "page/b_plus_tree_page.h"
+
+namespace cmudb {
+
+#define EXTERNAL_SORTER_TYPE ExternalSorter<KeyType, ValueType, KeyComparator>
+
+INDEX_TEMPLATE_ARGUMENTS
+class ExternalSorter {
+public:
+  explicit ExternalSorter(const KeyComparator &comparator,
+                          size_t run_size = SORT_RUN_SIZE);
+  ~ExternalSorter();
+
+  // add a pair, not after the first call to Next()
+  void Add(const KeyType &key, const ValueType &value);
+
+  // the next pair in ascending key order, false once all pairs were read
+  bool Next(KeyType &key, ValueType &value);
+
+private:
+  void SortRun();
+  void SpillRun();
+  void StartMerge();
+  bool ReadPair(size_t run, MappingType &pair);
+
+  KeyComparator comparator_;
+  size_t run_size_;
+  // the run that is collected, or the only one if nothing was spilled
+  std::vector<MappingType> run_;
+  size_t run_position_;
+  // spilled runs
+  std::vector<std::FILE *> run_files_;
+  // the next pair of every run that is not exhausted, a heap on the key
+  std::vector<std::pair<MappingType, size_t>> heads_;
+  bool reading_;
+};
+
+} // namespace cmudb
@@ -6,10 +6,27 @@
  * This key type uses an fixed length array to hold data for indexing
  * purposes, the actual size of which is specified and instantiated
  * with a template argument.
+ *
+ * Keys are either a copy of the key tuple, compared column by column through
+ * Value, or normalized: the key columns one after another in an encoding
+ * whose byte order is the value order, compared with memcmp.
+ *  - integers: big-endian with the sign bit flipped
+ *  - decimals: big-endian, the sign bit flipped or, if negative, all bits
+ *    inverted
+ *  - timestamps: big-endian
+ *  - varchars: a 0x01 marker (0x00 for null), the bytes with 0x00 escaped as
+ *    0x00 0xFF, then 0x00 0x00
+ * The rest of the key is zero. A normalized key longer than KeySize is cut
+ * off, such keys only compare by their prefix.
+ * The encoding of the first columns is a prefix of the encoding of all
+ * columns, so keys can be bounded by some columns only (see
+ * Index::ScanRange).
  */
 #pragma once
 
+#include <cstdint>
 #include <cstring>
+#include <string>
 
 #include "table/tuple.h"
 #include "type/value.h"
@@ -23,13 +40,82 @@ public:
     memcpy(data, tuple.GetData(), tuple.GetLength());
   }
 
+  // normalized encoding of the key tuple, or of its first column_count
+  // columns, see above
+  // @return: the length of the encoding, bytes past KeySize are cut off
+  inline size_t SetFromKey(const Tuple &tuple, Schema *key_schema,
+                           int column_count = -1) {
+    memset(data, 0, KeySize);
+    size_t offset = 0;
+    if (column_count < 0 || column_count > key_schema->GetColumnCount())
+      column_count = key_schema->GetColumnCount();
+    for (int i = 0; i < column_count; i++) {
+      Value value = tuple.GetValue(key_schema, i);
+      switch (key_schema->GetType(i)) {
+      case TypeId::BOOLEAN:
+      case TypeId::TINYINT:
+        PutBigEndian(static_cast<uint8_t>(value.GetAs<int8_t>()) ^ 0x80u, 1,
+                     offset);
+        break;
+      case TypeId::SMALLINT:
+        PutBigEndian(static_cast<uint16_t>(value.GetAs<int16_t>()) ^ 0x8000u,
+                     2, offset);
+        break;
+      case TypeId::INTEGER:
+        PutBigEndian(static_cast<uint32_t>(value.GetAs<int32_t>()) ^
+                         0x80000000u,
+                     4, offset);
+        break;
+      case TypeId::BIGINT:
+        PutBigEndian(static_cast<uint64_t>(value.GetAs<int64_t>()) ^
+                         (UINT64_C(1) << 63),
+                     8, offset);
+        break;
+      case TypeId::DECIMAL: {
+        double d = value.GetAs<double>();
+        uint64_t bits;
+        memcpy(&bits, &d, sizeof(bits));
+        bits = (bits >> 63) ? ~bits : bits ^ (UINT64_C(1) << 63);
+        PutBigEndian(bits, 8, offset);
+        break;
+      }
+      case TypeId::TIMESTAMP:
+        PutBigEndian(value.GetAs<uint64_t>(), 8, offset);
+        break;
+      case TypeId::VARCHAR: {
+        if (value.IsNull()) {
+          PutBigEndian(0, 1, offset);
+          break;
+        }
+        PutBigEndian(1, 1, offset);
+        // the length counts the terminating zero
+        const char *str = value.GetData();
+        uint32_t len = value.GetLength() - 1;
+        for (uint32_t j = 0; j < len; j++) {
+          PutBigEndian(static_cast<uint8_t>(str[j]), 1, offset);
+          if (str[j] == 0)
+            PutBigEndian(0xFF, 1, offset);
+        }
+        PutBigEndian(0, 2, offset);
+        break;
+      }
+      default:
+        break;
+      }
+    }
+    return offset;
+  }
+
   // NOTE: for test purpose only
   inline void SetFromInteger(int64_t key) {
     memset(data, 0, KeySize);
     memcpy(data, &key, sizeof(int64_t));
   }
 
-  inline Value ToValue(Schema *schema, int column_id) const {
+  inline Value ToValue(Schema *schema, int column_id,
+                       bool normalized = false) const {
+    if (normalized)
+      return ToNormalizedValue(schema, column_id);
     const char *data_ptr;
     const TypeId column_type = schema->GetType(column_id);
     const bool is_inlined = schema->IsInlined(column_id);
@@ -58,6 +144,84 @@ public:
 
   // actual location of data, extends past the end.
   char data[KeySize];
+
+private:
+  // helper function to append the lowest width bytes of value most
+  // significant first, bytes past the end of the key are dropped
+  inline void PutBigEndian(uint64_t value, size_t width, size_t &offset) {
+    for (size_t i = width; i-- > 0; offset++) {
+      if (offset < KeySize)
+        data[offset] = static_cast<char>((value >> (i * 8)) & 0xFF);
+    }
+  }
+
+  inline uint64_t GetBigEndian(size_t width, size_t &offset) const {
+    uint64_t value = 0;
+    for (size_t i = 0; i < width; i++, offset++) {
+      uint8_t byte = offset < KeySize ? static_cast<uint8_t>(data[offset]) : 0;
+      value = (value << 8) | byte;
+    }
+    return value;
+  }
+
+  // helper function to decode column column_id of a normalized key, the
+  // columns before it are skipped since varchars vary in length
+  inline Value ToNormalizedValue(Schema *schema, int column_id) const {
+    size_t offset = 0;
+    for (int i = 0;; i++) {
+      const TypeId type = schema->GetType(i);
+      Value value(type);
+      switch (type) {
+      case TypeId::BOOLEAN:
+      case TypeId::TINYINT:
+        value = Value(type, static_cast<int8_t>(GetBigEndian(1, offset) ^
+                                                0x80u));
+        break;
+      case TypeId::SMALLINT:
+        value = Value(type, static_cast<int16_t>(GetBigEndian(2, offset) ^
+                                                 0x8000u));
+        break;
+      case TypeId::INTEGER:
+        value = Value(type, static_cast<int32_t>(GetBigEndian(4, offset) ^
+                                                 0x80000000u));
+        break;
+      case TypeId::BIGINT:
+        value = Value(type, static_cast<int64_t>(GetBigEndian(8, offset) ^
+                                                 (UINT64_C(1) << 63)));
+        break;
+      case TypeId::DECIMAL: {
+        uint64_t bits = GetBigEndian(8, offset);
+        bits = (bits >> 63) ? bits ^ (UINT64_C(1) << 63) : ~bits;
+        double d;
+        memcpy(&d, &bits, sizeof(d));
+        value = Value(type, d);
+        break;
+      }
+      case TypeId::TIMESTAMP:
+        value = Value(type, GetBigEndian(8, offset));
+        break;
+      case TypeId::VARCHAR: {
+        if (GetBigEndian(1, offset) == 0) {
+          value = Value(type, nullptr, 0, false);
+          break;
+        }
+        std::string str;
+        while (offset < KeySize) {
+          char c = static_cast<char>(GetBigEndian(1, offset));
+          if (c == 0 && GetBigEndian(1, offset) == 0)
+            break;
+          str.push_back(c);
+        }
+        value = Value(type, str);
+        break;
+      }
+      default:
+        break;
+      }
+      if (i == column_id)
+        return value;
+    }
+  }
 };
 
 /**
@@ -67,6 +231,10 @@ template <size_t KeySize> class GenericComparator {
 public:
   inline int operator()(const GenericKey<KeySize> &lhs,
                         const GenericKey<KeySize> &rhs) const {
+    if (normalized_) {
+      int cmp = memcmp(lhs.data, rhs.data, KeySize);
+      return (cmp > 0) - (cmp < 0);
+    }
     int column_count = key_schema_->GetColumnCount();
 
     for (int i = 0; i < column_count; i++) {
@@ -85,13 +253,20 @@ public:
 
   GenericComparator(const GenericComparator &other) {
     this->key_schema_ = other.key_schema_;
+    this->normalized_ = other.normalized_;
   }
 
   // constructor
-  GenericComparator(Schema *key_schema) : key_schema_(key_schema) {}
+  // normalized: keys are set with SetFromKey(tuple, key_schema)
+  GenericComparator(Schema *key_schema, bool normalized = false)
+      : key_schema_(key_schema), normalized_(normalized) {}
+
+  // keys compare bytewise
+  inline bool IsNormalized() const { return normalized_; }
 
 private:
   Schema *key_schema_;
+  bool normalized_;
 };
 
 } // namespace cmudb
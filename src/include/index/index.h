@@ -14,6 +14,9 @@
 
 namespace cmudb {
 
+// the structure behind an index, see ConstructIndex
+enum class IndexType { BPlusTreeIndex = 0, HashTableIndex };
+
 /**
  * class IndexMetadata - Holds metadata of an index object
  *
@@ -28,8 +31,10 @@ class IndexMetadata {
 
 public:
   IndexMetadata(std::string index_name, std::string table_name,
-                const Schema *tuple_schema, const std::vector<int> &key_attrs)
-      : name_(index_name), table_name_(table_name), key_attrs_(key_attrs) {
+                const Schema *tuple_schema, const std::vector<int> &key_attrs,
+                IndexType index_type = IndexType::BPlusTreeIndex)
+      : name_(index_name), table_name_(table_name), key_attrs_(key_attrs),
+        index_type_(index_type) {
     key_schema_ = Schema::CopySchema(tuple_schema, key_attrs_);
   }
 
@@ -39,6 +44,8 @@ public:
 
   inline const std::string &GetTableName() { return table_name_; }
 
+  inline IndexType GetIndexType() const { return index_type_; }
+
   // Returns a schema object pointer that represents the indexed key
   inline Schema *GetKeySchema() const { return key_schema_; }
 
@@ -57,7 +64,9 @@ public:
 
     os << "IndexMetadata["
        << "Name = " << name_ << ", "
-       << "Type = B+Tree, "
+       << "Type = "
+       << (index_type_ == IndexType::HashTableIndex ? "Hash" : "B+Tree")
+       << ", "
        << "Table name = " << table_name_ << "] :: ";
     os << key_schema_->ToString();
 
@@ -69,10 +78,27 @@ private:
   std::string table_name_;
   // The mapping relation between key schema and tuple schema
   const std::vector<int> key_attrs_;
+  IndexType index_type_;
   // schema of the indexed key
   Schema *key_schema_;
 };
 
+/**
+ * One end of a range scan, see Index::ScanRange: the first column_count
+ * columns of the key tuple key. Keys that equal it in these columns are in
+ * the range if the bound is inclusive. A bound without key leaves its end of
+ * the range open.
+ */
+struct ScanBound {
+  ScanBound() : key(nullptr), column_count(0), inclusive(true) {}
+  ScanBound(const Tuple *key, int column_count, bool inclusive = true)
+      : key(key), column_count(column_count), inclusive(inclusive) {}
+
+  const Tuple *key;
+  int column_count;
+  bool inclusive;
+};
+
 /////////////////////////////////////////////////////////////////////
 // Index class definition
 /////////////////////////////////////////////////////////////////////
@@ -133,6 +159,12 @@ public:
   virtual void ScanKey(const Tuple &key, std::vector<RID> &result,
                        Transaction *transaction = nullptr) = 0;
 
+  // the entries between low and high in key order, only ordered indexes
+  // support range scans
+  virtual void ScanRange(const ScanBound &low, const ScanBound &high,
+                         std::vector<RID> &result,
+                         Transaction *transaction = nullptr) = 0;
+
 private:
   //===--------------------------------------------------------------------===//
   //  Data members
@@ -1,8 +1,18 @@
 /**
  * index_iterator.h
  * For range scan of b+ tree
+ *
+ * The iterator read latches the leaf it is positioned on and moves to the
+ * next leaf before it unlatches the current one. Leaves are always latched
+ * from left to right, writers merging a page into its left sibling latch the
+ * sibling first.
+ * Only while it moves on the iterator holds two leaves, the read of the next
+ * one is started through Prefetch() as soon as the iterator gets to a leaf.
+ * An iterator with an end key stops in front of it and lets go of its leaf,
+ * the leaf after the one the range ends in is not prefetched.
  */
 #pragma once
+#include "buffer/page_guard.h"
 #include "page/b_plus_tree_leaf_page.h"
 
 namespace cmudb {
@@ -13,8 +23,12 @@ namespace cmudb {
 INDEX_TEMPLATE_ARGUMENTS
 class IndexIterator {
 public:
-  // you may define your own constructor based on your member variables
-  IndexIterator();
+  // leaf: read latched leaf to start at, empty at the end of the tree
+  // end_key: the first key past the range, null for the end of the tree
+  IndexIterator(BufferPoolManager *buffer_pool_manager, ReadPageGuard leaf,
+                int index, const KeyComparator &comparator,
+                const KeyType *end_key = nullptr);
+  IndexIterator(IndexIterator &&other) = default;
   ~IndexIterator();
 
   bool isEnd();
@@ -24,7 +38,18 @@ public:
   IndexIterator &operator++();
 
 private:
-  // add your own private member variables here
+  void SkipExhaustedLeaves();
+  void PrefetchNextLeaf();
+
+  BufferPoolManager *buffer_pool_manager_;
+  ReadPageGuard leaf_guard_;
+  B_PLUS_TREE_LEAF_PAGE_TYPE *leaf_;
+  int index_;
+  // leaves keep keys and values apart, the pair is put together here
+  MappingType item_;
+  KeyComparator comparator_;
+  bool bounded_;
+  KeyType end_key_;
 };
 
 } // namespace cmudb
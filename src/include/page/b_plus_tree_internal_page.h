@@ -8,15 +8,39 @@
  * the first key always remains invalid. That is to say, any search/lookup
  * should ignore the first key.
  *
+ * Like a leaf, every internal page links to its right sibling on the same
+ * level (B-link tree). Keys not less than the high key belong to the right
+ * sibling, the rightmost page of a level has no high key.
+ *
+ * Keys are kept in variable-length slots: the bytes all keys of the page
+ * start with are stored once, every key keeps the rest without its trailing
+ * zero bytes. Separators of leaves are cut short where the key order allows
+ * (see BPlusTree::InsertIntoLeaf), so most of them take a few bytes. A page
+ * is split beyond its max size or when the next key does not fit, so adding
+ * or changing a key has to be checked for room first.
+ * The first key is the separator of the page in its parent, or any key for
+ * the leftmost page of a level.
+ * Every slot also keeps the first 4 key bytes after the prefix as a
+ * big-endian integer. With normalized keys a lookup compares these heads and
+ * only reads the key bytes where they are equal.
+ *
  * Internal page format (keys are stored in increasing order):
- *  --------------------------------------------------------------------------
- * | HEADER | KEY(1)+PAGE_ID(1) | KEY(2)+PAGE_ID(2) | ... | KEY(n)+PAGE_ID(n) |
- *  --------------------------------------------------------------------------
+ *  ---------------------------------------------------------------------
+ * | HEADER | LEVEL | NEXT_PAGE_ID | HIGH_KEY | PREFIX_SIZE | KEY_OFFSET |
+ *  ---------------------------------------------------------------------
+ *  ----------------------------------------------------------------------
+ * | SLOT(0) | SLOT(1) | ... free space ... | KEY(1) | KEY(0) | PREFIX |
+ *  ----------------------------------------------------------------------
+ *  SLOT: PAGE_ID (4) | KEY_HEAD (4) | KEY_OFFSET (2) | KEY_SIZE (2),
+ *  KEY_OFFSET points at the first key byte after the prefix. Keys end at the
+ *  end of the page.
  */
 
 #pragma once
 
+#include <cstdint>
 #include <queue>
+#include <vector>
 
 #include "page/b_plus_tree_page.h"
 
@@ -24,18 +48,34 @@ namespace cmudb {
 
 #define B_PLUS_TREE_INTERNAL_PAGE_TYPE                                         \
   BPlusTreeInternalPage<KeyType, ValueType, KeyComparator>
+// default max size, as many children as fit with empty keys
+#define INTERNAL_PAGE_SIZE                                                     \
+  ((PAGE_SIZE - sizeof(BPlusTreeInternalPage<KeyType, page_id_t,               \
+                                             KeyComparator>)) /                \
+   (sizeof(page_id_t) + sizeof(uint32_t) + 2 * sizeof(uint16_t)))
 
 INDEX_TEMPLATE_ARGUMENTS
 class BPlusTreeInternalPage : public BPlusTreePage {
 public:
   // must call initialize method after "create" a new node
-  void Init(page_id_t page_id, page_id_t parent_id = INVALID_PAGE_ID);
+  void Init(page_id_t page_id, page_id_t parent_id = INVALID_PAGE_ID,
+            int max_size = INTERNAL_PAGE_SIZE);
 
   KeyType KeyAt(int index) const;
   void SetKeyAt(int index, const KeyType &key);
   int ValueIndex(const ValueType &value) const;
   ValueType ValueAt(int index) const;
 
+  // leaves are at level 0, their parents at level 1
+  int GetLevel() const;
+  void SetLevel(int level);
+  page_id_t GetNextPageId() const;
+  void SetNextPageId(page_id_t next_page_id);
+  KeyType GetHighKey() const;
+  void SetHighKey(const KeyType &key);
+  bool IsBeyondHighKey(const KeyType &key,
+                       const KeyComparator &comparator) const;
+
   ValueType Lookup(const KeyType &key, const KeyComparator &comparator) const;
   void PopulateNewRoot(const ValueType &old_value, const KeyType &new_key,
                        const ValueType &new_value);
@@ -44,6 +84,12 @@ public:
   void Remove(int index);
   ValueType RemoveAndReturnOnlyChild();
 
+  // space checks, see above
+  bool HasRoomFor(const KeyType &key) const;
+  bool CanSetKeyAt(int index, const KeyType &key) const;
+  bool CanMoveFrom(const BPlusTreeInternalPage *sibling, int size) const;
+  bool IsUnderfull() const;
+
   void MoveHalfTo(BPlusTreeInternalPage *recipient,
                   BufferPoolManager *buffer_pool_manager);
   void MoveAllTo(BPlusTreeInternalPage *recipient, int index_in_parent,
@@ -53,20 +99,46 @@ public:
   void MoveLastToFrontOf(BPlusTreeInternalPage *recipient,
                          int parent_index,
                          BufferPoolManager *buffer_pool_manager);
+  // Bulk load utility methods
+  void Append(const KeyType &key, const ValueType &value);
+  void MoveTailTo(BPlusTreeInternalPage *recipient, int size);
+  void MoveHeadTo(BPlusTreeInternalPage *recipient, int size);
   // DEUBG and PRINT
   std::string ToString(bool verbose) const;
   void QueueUpChildren(std::queue<BPlusTreePage *> *queue,
                        BufferPoolManager *buffer_pool_manager);
 
 private:
-  void CopyHalfFrom(MappingType *items, int size,
-                    BufferPoolManager *buffer_pool_manager);
-  void CopyAllFrom(MappingType *items, int size,
-                   BufferPoolManager *buffer_pool_manager);
+  // a child and where the rest of its key is kept
+  struct Slot {
+    ValueType value;
+    uint32_t key_head;
+    uint16_t key_offset;
+    uint16_t key_size;
+  };
+
+  void AdoptChild(page_id_t child_page_id,
+                  BufferPoolManager *buffer_pool_manager);
+  std::vector<MappingType> GetItems() const;
+  void SetItems(const std::vector<MappingType> &items);
+  void InsertAt(int index, const KeyType &key, const ValueType &value);
+  bool SharesPrefix(const KeyType &key) const;
+  int GetUsedSize() const;
+  int GetCapacity() const;
+  static int ItemsSize(const std::vector<MappingType> &items);
+  static int PrefixSize(const KeyType &left, const KeyType &right);
+  static int StoredKeySize(const KeyType &key, int prefix_size);
+  static uint32_t KeyHead(const char *data, int size);
+  ValueType NormalizedLookup(const KeyType &key) const;
   void CopyLastFrom(const MappingType &pair,
                     BufferPoolManager *buffer_pool_manager);
   void CopyFirstFrom(const MappingType &pair, int parent_index,
                      BufferPoolManager *buffer_pool_manager);
-  MappingType array[0];
+  int level_;
+  page_id_t next_page_id_;
+  KeyType high_key_;
+  uint16_t prefix_size_;
+  uint16_t key_offset_;
+  Slot slots_[0];
 };
 } // namespace cmudb
@@ -4,19 +4,28 @@
  * Store indexed key and record id(record id = page id combined with slot id,
  * see include/common/rid.h for detailed implementation) together within leaf
  * page. Only support unique key.
+ * Keys not less than the high key belong to the right sibling, the rightmost
+ * leaf has no high key.
+
+ * Keys and record ids are kept in two arrays, so a search only touches the
+ * cache lines of keys. Both arrays have room for max size + 1 entries, the
+ * record ids start behind the last key slot.
+ * Normalized keys of 4 or 8 bytes compare as big-endian integers, a search
+ * narrows them down to a window of KEY_SEARCH_WINDOW keys and compares the
+ * window at once (with AVX2 where available).
 
  * Leaf page format (keys are stored in order):
  *  ----------------------------------------------------------------------
- * | HEADER | KEY(1) + RID(1) | KEY(2) + RID(2) | ... | KEY(n) + RID(n)
+ * | HEADER | KEY(1) | ... | KEY(n) | ... | RID(1) | ... | RID(n) | ...
  *  ----------------------------------------------------------------------
  *
- *  Header format (size in byte, 24 bytes in total):
+ *  Header format (size in byte, 24 bytes plus the high key):
  *  ---------------------------------------------------------------------
  * | PageType (4) | CurrentSize (4) | MaxSize (4) | ParentPageId (4) |
  *  ---------------------------------------------------------------------
- *  ------------------------------
- * | PageId (4) | NextPageId (4)
- *  ------------------------------
+ *  ------------------------------------------------
+ * | PageId (4) | NextPageId (4) | HighKey (KeySize)
+ *  ------------------------------------------------
  */
 #pragma once
 #include <utility>
@@ -27,6 +36,12 @@
 namespace cmudb {
 #define B_PLUS_TREE_LEAF_PAGE_TYPE                                             \
   BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>
+// default max size, one slot stays free for the entry that overflows a page
+// before it is split
+#define LEAF_PAGE_SIZE                                                         \
+  ((PAGE_SIZE - sizeof(B_PLUS_TREE_LEAF_PAGE_TYPE)) /                          \
+       (sizeof(KeyType) + sizeof(ValueType)) -                                 \
+   1)
 
 INDEX_TEMPLATE_ARGUMENTS
 class BPlusTreeLeafPage : public BPlusTreePage {
@@ -34,13 +49,18 @@ class BPlusTreeLeafPage : public BPlusTreePage {
 public:
   // After creating a new leaf page from buffer pool, must call initialize
   // method to set default values
-  void Init(page_id_t page_id, page_id_t parent_id = INVALID_PAGE_ID);
+  void Init(page_id_t page_id, page_id_t parent_id = INVALID_PAGE_ID,
+            int max_size = LEAF_PAGE_SIZE);
   // helper methods
   page_id_t GetNextPageId() const;
   void SetNextPageId(page_id_t next_page_id);
+  KeyType GetHighKey() const;
+  void SetHighKey(const KeyType &key);
+  bool IsBeyondHighKey(const KeyType &key,
+                       const KeyComparator &comparator) const;
   KeyType KeyAt(int index) const;
   int KeyIndex(const KeyType &key, const KeyComparator &comparator) const;
-  const MappingType &GetItem(int index);
+  MappingType GetItem(int index) const;
 
   // insert and delete methods
   int Insert(const KeyType &key, const ValueType &value,
@@ -49,6 +69,10 @@ public:
               const KeyComparator &comparator) const;
   int RemoveAndDeleteRecord(const KeyType &key,
                             const KeyComparator &comparator);
+  // space checks, the same as for internal pages
+  bool HasRoomFor(const KeyType &key) const;
+  bool CanMoveFrom(const BPlusTreeLeafPage *sibling, int size) const;
+  bool IsUnderfull() const;
   // Split and Merge utility methods
   void MoveHalfTo(BPlusTreeLeafPage *recipient,
                   BufferPoolManager *buffer_pool_manager /* Unused */);
@@ -58,16 +82,26 @@ public:
                         BufferPoolManager *buffer_pool_manager);
   void MoveLastToFrontOf(BPlusTreeLeafPage *recipient, int parentIndex,
                          BufferPoolManager *buffer_pool_manager);
+  // Bulk load utility methods
+  void Append(const KeyType &key, const ValueType &value);
+  void MoveTailTo(BPlusTreeLeafPage *recipient, int size);
+  void MoveHeadTo(BPlusTreeLeafPage *recipient, int size);
   // Debug
   std::string ToString(bool verbose = false) const;
 
 private:
-  void CopyHalfFrom(MappingType *items, int size);
-  void CopyAllFrom(MappingType *items, int size);
+  int NormalizedKeyIndex(const KeyType &key) const;
+  ValueType *Values();
+  const ValueType *Values() const;
+  void InsertAt(int index, const KeyType &key, const ValueType &value);
+  void RemoveAt(int index);
+  void CopyHalfFrom(const BPlusTreeLeafPage *sibling, int index, int size);
+  void CopyAllFrom(const BPlusTreeLeafPage *sibling, int size);
   void CopyLastFrom(const MappingType &item);
   void CopyFirstFrom(const MappingType &item, int parentIndex,
                      BufferPoolManager *buffer_pool_manager);
   page_id_t next_page_id_;
-  MappingType array[0];
+  KeyType high_key_;
+  KeyType keys_[0];
 };
 } // namespace cmudb
@@ -0,0 +1,63 @@
+/**
+ * hash_table_bucket_page.h
+ *
+ * Bucket of a disk resident extendible hash table. Entries are unordered and
+ * keys are unique; a removal moves the last entry into the gap. A bucket that
+ * cannot split any further links to overflow pages of the same format.
+ *
+ * Bucket page format (size in byte):
+ *  ----------------------------------------------------------------------
+ * | CurrentSize (4) | NextPageId (4) | KEY(1) + RID(1) | ... | KEY(n) + RID(n)
+ *  ----------------------------------------------------------------------
+ */
+
+#pragma once
+
+#include <utility>
+#include <vector>
+
+#include "page/b_plus_tree_page.h"
+
+namespace cmudb {
+
+#define HASH_TABLE_BUCKET_PAGE_TYPE                                            \
+  HashTableBucketPage<KeyType, ValueType, KeyComparator>
+
+INDEX_TEMPLATE_ARGUMENTS
+class HashTableBucketPage {
+public:
+  // After creating a new bucket page from buffer pool, must call initialize
+  // method to set default values
+  void Init();
+
+  int GetSize() const;
+  bool IsFull() const;
+  bool IsEmpty() const;
+  static int GetMaxSize();
+
+  // the next overflow page, INVALID_PAGE_ID at the end of the chain
+  page_id_t GetNextPageId() const;
+  void SetNextPageId(page_id_t next_page_id);
+
+  KeyType KeyAt(int index) const;
+  ValueType ValueAt(int index) const;
+
+  // the value of key, if any
+  bool Lookup(const KeyType &key, ValueType &value,
+              const KeyComparator &comparator) const;
+  // false if key exists or the bucket is full
+  bool Insert(const KeyType &key, const ValueType &value,
+              const KeyComparator &comparator);
+  bool Remove(const KeyType &key, const KeyComparator &comparator);
+  void RemoveAt(int index);
+
+private:
+  int KeyIndex(const KeyType &key, const KeyComparator &comparator) const;
+
+  int size_;
+  page_id_t next_page_id_;
+  // Flexible array member for page data.
+  MappingType array_[0];
+};
+
+} // namespace cmudb
@@ -0,0 +1,66 @@
+/**
+ * hash_table_directory_page.h
+ *
+ * Directory of a disk resident extendible hash table. Slot i holds the page id
+ * of the bucket for hash values whose lowest global depth bits equal i, along
+ * with that bucket's local depth.
+ *
+ * Directory page format (size in byte):
+ *  ----------------------------------------------------------------------------
+ * | PageId (4) | GlobalDepth (4) | LocalDepths (512) | BucketPageIds (4 * 512)
+ *  ----------------------------------------------------------------------------
+ */
+
+#pragma once
+
+#include <cstdint>
+
+#include "common/config.h"
+
+namespace cmudb {
+
+#define DIRECTORY_ARRAY_SIZE 512
+#define DIRECTORY_MAX_DEPTH 9
+
+class HashTableDirectoryPage {
+public:
+  // After creating a new directory page from buffer pool, must call
+  // initialize method to set default values
+  void Init(page_id_t page_id, page_id_t bucket_page_id);
+
+  page_id_t GetPageId() const;
+
+  uint32_t GetGlobalDepth() const;
+  // number of slots in use, 2^global depth
+  uint32_t GetSize() const;
+  // the slot of a hash value
+  uint32_t GetSlot(uint32_t hash) const;
+
+  page_id_t GetBucketPageId(uint32_t slot) const;
+  void SetBucketPageId(uint32_t slot, page_id_t bucket_page_id);
+
+  uint32_t GetLocalDepth(uint32_t slot) const;
+  void SetLocalDepth(uint32_t slot, uint32_t local_depth);
+
+  // the slot of the bucket a split of slot's bucket creates, or that it
+  // merges with
+  uint32_t GetSplitImageSlot(uint32_t slot) const;
+
+  // double the directory, the upper half mirrors the lower one
+  void IncrGlobalDepth();
+  // halve the directory, only if CanShrink
+  void DecrGlobalDepth();
+  // whether every local depth is below the global depth
+  bool CanShrink() const;
+
+private:
+  page_id_t page_id_;
+  uint32_t global_depth_;
+  uint8_t local_depths_[DIRECTORY_ARRAY_SIZE];
+  page_id_t bucket_page_ids_[DIRECTORY_ARRAY_SIZE];
+};
+
+static_assert(sizeof(HashTableDirectoryPage) <= PAGE_SIZE,
+              "hash table directory does not fit into a page");
+
+} // namespace cmudb
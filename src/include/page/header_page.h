@@ -9,6 +9,13 @@
  *  -----------------------------------------------------------------
  * | RecordCount (4) | Entry_1 name (32) | Entry_1 root_id (4) | ... |
  *  -----------------------------------------------------------------
+ *
+ * The last HEADER_PAGE_RESERVED bytes belong to the disk manager, which keeps
+ * the anchor of its free space bitmap there, so records never extend into
+ * them:
+ *  ---------------------------------------------------------
+ * | ... | BitmapMagic (4) | First bitmap page_id (4) |
+ *  ---------------------------------------------------------
  */
 
 #pragma once
@@ -4,10 +4,21 @@
  * Wrapper around actual data page in main memory and also contains bookkeeping
  * information used by buffer pool manager like pin_count/dirty_flag/page_id.
  * Use page as a basic unit within the database system
+ *
+ * The content itself lives in the frame arena of the buffer pool, a Page only
+ * points to it. Pages are padded to whole cache lines so that the bookkeeping
+ * of neighbouring frames never shares a cache line.
+ *
+ * Besides the reader-writer latch every page carries a version that is odd
+ * while the page is write latched and advances with every write latch. An
+ * optimistic reader takes no latch, it remembers the version before reading
+ * and validates afterwards that it did not change. Only writers holding the
+ * write latch are detected this way.
  */
 
 #pragma once
 
+#include <atomic>
 #include <cstring>
 #include <iostream>
 
@@ -16,33 +27,64 @@
 
 namespace cmudb {
 
-class Page {
+class BufferRing;
+
+class alignas(CACHE_LINE_SIZE) Page {
   friend class BufferPoolManager;
 
 public:
-  Page() { ResetMemory(); }
+  explicit Page(char *data) : data_(data) {}
   ~Page(){};
   // get actual data page content
   inline char *GetData() { return data_; }
   // get page id
   inline page_id_t GetPageId() { return page_id_; }
   // get page pin count
-  inline int GetPinCount() { return pin_count_; }
+  inline int GetPinCount() { return pin_count_.load(); }
   // method use to latch/unlatch page content
-  inline void WUnlatch() { rwlatch_.WUnlock(); }
-  inline void WLatch() { rwlatch_.WLock(); }
+  inline void WUnlatch() {
+    version_.store(version_.load(std::memory_order_relaxed) + 1,
+                   std::memory_order_release);
+    rwlatch_.WUnlock();
+  }
+  inline void WLatch() {
+    rwlatch_.WLock();
+    version_.store(version_.load(std::memory_order_relaxed) + 1,
+                   std::memory_order_relaxed);
+    // the odd version becomes visible before any write to the content
+    std::atomic_thread_fence(std::memory_order_release);
+  }
   inline void RUnlatch() { rwlatch_.RUnlock(); }
   inline void RLatch() { rwlatch_.RLock(); }
+  // version to validate an optimistic read against, odd while write latched
+  inline uint64_t GetVersion() {
+    return version_.load(std::memory_order_acquire);
+  }
+  // whether no write latch was taken since version was read
+  inline bool ValidateVersion(uint64_t version) {
+    // the reads of the content complete before the version is read again
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return (version & 1) == 0 &&
+           version_.load(std::memory_order_relaxed) == version;
+  }
 
 private:
   // method used by buffer pool manager
   inline void ResetMemory() { memset(data_, 0, PAGE_SIZE); }
   // members
-  char data_[PAGE_SIZE]; // actual data
-  page_id_t page_id_ = INVALID_PAGE_ID;
-  int pin_count_ = 0;
+  char *data_; // actual data, PAGE_SIZE bytes
+  // page id and pin count are read by lock-free lookups of the buffer pool
+  std::atomic<page_id_t> page_id_{INVALID_PAGE_ID};
+  std::atomic<int> pin_count_{0};
   bool is_dirty_ = false;
+  // the content is still being read from disk
+  std::atomic<bool> read_pending_{false};
+  // fetches of the page since it was read into this frame
+  std::atomic<uint64_t> access_count_{0};
+  // ring owning this frame, it is then never handed to the replacer
+  BufferRing *ring_ = nullptr;
   RWMutex rwlatch_;
+  std::atomic<uint64_t> version_{0};
 };
 
 } // namespace cmudb
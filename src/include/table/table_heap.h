@@ -2,6 +2,13 @@
  * table_heap.h
  *
  * doubly-linked list of heap pages
+ *
+ * Scans prefetch ahead along the page chain. As long as every page links to
+ * the page with the next id, the following readahead window of pages is read
+ * from disk as one batch while the scan is still busy with the current page.
+ *
+ * A scan opened in bulk read mode reads through a private BufferRing, so a
+ * full scan of a large table does not push other pages out of the pool.
  */
 
 #pragma once
@@ -40,23 +47,33 @@ public:
                    Transaction *txn); // when commit delete or rollback insert
   void RollbackDelete(const RID &rid, Transaction *txn); // when rollback delete
 
-  bool GetTuple(const RID &rid, Tuple &tuple, Transaction *txn);
+  bool GetTuple(const RID &rid, Tuple &tuple, Transaction *txn,
+                BufferRing *ring = nullptr);
 
   bool DeleteTableHeap();
 
-  TableIterator begin(Transaction *txn);
+  // bulk_read: read through a private ring of BUFFER_RING_SIZE frames
+  TableIterator begin(Transaction *txn, bool bulk_read = false);
 
   TableIterator end();
 
   inline page_id_t GetFirstPageId() const { return first_page_id_; }
 
+  // number of pages a scan reads ahead, 0 disables readahead
+  inline void SetReadaheadPages(size_t pages) { readahead_pages_ = pages; }
+
+  inline size_t GetReadaheadPages() const { return readahead_pages_; }
+
 private:
+  void Readahead(TablePage *page, page_id_t &readahead_end, BufferRing *ring);
+
   /**
    * Members
    */
   BufferPoolManager *buffer_pool_manager_;
   LockManager *lock_manager_;
   page_id_t first_page_id_;
+  size_t readahead_pages_ = READAHEAD_PAGES;
 };
 
 } // namespace cmudb
@@ -7,7 +7,9 @@
 #pragma once
 
 #include <cassert>
+#include <memory>
 
+#include "buffer/buffer_ring.h"
 #include "common/rid.h"
 #include "table/tuple.h"
 
@@ -19,7 +21,8 @@ class TableIterator {
   friend class Cursor;
 
 public:
-  TableIterator(TableHeap *table_heap, RID rid, Transaction *txn);
+  TableIterator(TableHeap *table_heap, RID rid, Transaction *txn,
+                std::shared_ptr<BufferRing> ring = nullptr);
 
   ~TableIterator() { delete tuple_; }
 
@@ -43,6 +46,10 @@ private:
   TableHeap *table_heap_;
   Tuple *tuple_;
   Transaction *txn_;
+  // end of the page range prefetched for this scan so far
+  page_id_t readahead_end_;
+  // private frames of a bulk read scan, shared by copies of the iterator
+  std::shared_ptr<BufferRing> ring_;
 };
 
 } // namespace cmudb
\ No newline at end of file
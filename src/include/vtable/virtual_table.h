@@ -8,6 +8,7 @@
 #include "catalog/schema.h"
 #include "concurrency/transaction_manager.h"
 #include "index/b_plus_tree_index.h"
+#include "index/hash_table_index.h"
 #include "sqlite/sqlite3ext.h"
 #include "table/table_heap.h"
 #include "table/tuple.h"
@@ -21,13 +22,32 @@ IndexMetadata *ParseIndexStatement(std::string &sql,
                                    const std::string &table_name,
                                    Schema *schema);
 
-Tuple ConstructTuple(Schema *schema, sqlite3_value **argv);
+// column_count: only the first column_count columns are read from argv, the
+// others are left zero, e.g. for a key prefix
+Tuple ConstructTuple(Schema *schema, sqlite3_value **argv,
+                     int column_count = -1);
+
+bool IsExactValue(TypeId type, sqlite3_value *value);
 
 Index *ConstructIndex(IndexMetadata *metadata,
                       BufferPoolManager *buffer_pool_manager,
                       page_id_t root_id = INVALID_PAGE_ID);
 Transaction *GetTransaction();
 
+/*
+ * Plan of an index scan in idxNum: the number of leading key columns with an
+ * equality constraint, and the bounds on the key column after them. Their
+ * values are passed in this order, equalities in key column order. An
+ * idxNum of 0 is a sequential scan.
+ */
+enum IndexScanPlan {
+  SCAN_EQUAL_COLUMNS = 0xFF,
+  SCAN_LOW = 0x100,
+  SCAN_LOW_INCLUSIVE = 0x200,
+  SCAN_HIGH = 0x400,
+  SCAN_HIGH_INCLUSIVE = 0x800
+};
+
 /* API declaration */
 int VtabCreate(sqlite3 *db, void *pAux, int argc, const char *const *argv,
                sqlite3_vtab **ppVtab, char **pzErr);
@@ -58,6 +78,34 @@ int VtabCommit(sqlite3_vtab *pVTab);
 
 int VtabBegin(sqlite3_vtab *pVTab);
 
+/* Buffer pool statistics, an eponymous read-only table */
+int BpmStatsConnect(sqlite3 *db, void *pAux, int argc, const char *const *argv,
+                    sqlite3_vtab **ppVtab, char **pzErr);
+
+int BpmStatsBestIndex(sqlite3_vtab *tab, sqlite3_index_info *pIdxInfo);
+
+int BpmStatsDisconnect(sqlite3_vtab *pVtab);
+
+int BpmStatsOpen(sqlite3_vtab *pVtab, sqlite3_vtab_cursor **ppCursor);
+
+int BpmStatsClose(sqlite3_vtab_cursor *cur);
+
+int BpmStatsFilter(sqlite3_vtab_cursor *pVtabCursor, int idxNum,
+                   const char *idxStr, int argc, sqlite3_value **argv);
+
+int BpmStatsNext(sqlite3_vtab_cursor *cur);
+
+int BpmStatsEof(sqlite3_vtab_cursor *cur);
+
+int BpmStatsColumn(sqlite3_vtab_cursor *cur, sqlite3_context *ctx, int i);
+
+int BpmStatsRowid(sqlite3_vtab_cursor *cur, sqlite3_int64 *pRowid);
+
+/* SQL functions */
+// bpm_pool_size([size]): resize the buffer pool if a size is given, return
+// the pool size
+void BpmPoolSizeFunction(sqlite3_context *ctx, int argc, sqlite3_value **argv);
+
 // global parameters
 struct GlobalParameters {
   BufferPoolManager *buffer_pool_manager_;
@@ -132,7 +180,10 @@ public:
     return table_heap_->UpdateTuple(tuple, rid, GetTransaction());
   }
 
-  inline TableIterator begin() { return table_heap_->begin(GetTransaction()); }
+  // bulk_read: scan through a private buffer ring
+  inline TableIterator begin(bool bulk_read = false) {
+    return table_heap_->begin(GetTransaction(), bulk_read);
+  }
 
   inline TableIterator end() { return table_heap_->end(); }
 
@@ -156,9 +207,10 @@ private:
 
 class Cursor {
 public:
+  // full scans must not flush the pool, they read through a buffer ring
   Cursor(VirtualTable *virtual_table)
-      : table_iterator_(virtual_table->begin()), virtual_table_(virtual_table) {
-  }
+      : table_iterator_(virtual_table->begin(true)),
+        virtual_table_(virtual_table) {}
 
   inline void SetScanFlag(bool is_index_scan) {
     is_index_scan_ = is_index_scan;
@@ -209,10 +261,23 @@ public:
 
   // wrapper around poit scan methods
   inline void ScanKey(const Tuple &key) {
+    Rewind();
     virtual_table_->index_->ScanKey(key, results);
   }
 
+  // wrapper around range scan methods, b+ tree indexes only
+  inline void ScanRange(const ScanBound &low, const ScanBound &high) {
+    Rewind();
+    virtual_table_->index_->ScanRange(low, high, results);
+  }
+
 private:
+  // a cursor is filtered again e.g. for every row of an outer join loop
+  inline void Rewind() {
+    results.clear();
+    offset_ = 0;
+  }
+
   sqlite3_vtab_cursor base_; /* Base class - must be first */
   // for index scan
   std::vector<RID> results;
@@ -224,4 +289,54 @@ private:
   VirtualTable *virtual_table_;
 }; // namespace cmudb
 
+/*
+ * Cursor over vtable_bpm_stats(name, page_id, value): one row per buffer pool
+ * counter with a NULL page_id, followed by one "accesses" row per cached page.
+ * The rows are a snapshot taken when the scan starts.
+ */
+class BpmStatsCursor {
+public:
+  struct Row {
+    std::string name_;
+    page_id_t page_id_;
+    int64_t value_;
+  };
+
+  // take a new snapshot and rewind
+  void Snapshot(BufferPoolManager *buffer_pool_manager) {
+    rows_.clear();
+    offset_ = 0;
+    const BufferPoolStats &stats = buffer_pool_manager->GetStats();
+    for (int i = 0; i < BufferPoolStats::NUM_COUNTERS; ++i) {
+      auto counter = static_cast<BufferPoolStats::Counter>(i);
+      rows_.push_back({BufferPoolStats::GetName(counter), INVALID_PAGE_ID,
+                       static_cast<int64_t>(stats.Get(counter))});
+    }
+    rows_.push_back({"pool_size", INVALID_PAGE_ID,
+                     static_cast<int64_t>(buffer_pool_manager->GetPoolSize())});
+    rows_.push_back(
+        {"dirty_pages", INVALID_PAGE_ID,
+         static_cast<int64_t>(buffer_pool_manager->GetDirtyPageCount())});
+    for (auto &entry : buffer_pool_manager->GetPageAccessCounts())
+      rows_.push_back(
+          {"accesses", entry.first, static_cast<int64_t>(entry.second)});
+  }
+
+  inline const Row &GetCurrentRow() { return rows_[offset_]; }
+
+  inline int64_t GetCurrentRowid() { return static_cast<int64_t>(offset_); }
+
+  BpmStatsCursor &operator++() {
+    ++offset_;
+    return *this;
+  }
+
+  inline bool isEof() { return offset_ >= rows_.size(); }
+
+private:
+  sqlite3_vtab_cursor base_; /* Base class - must be first */
+  std::vector<Row> rows_;
+  size_t offset_ = 0;
+};
+
 } // namespace cmudb
@@ -1,7 +1,11 @@
 /**
  * b_plus_tree.cpp
  */
+#include <algorithm>
+#include <cstring>
+#include <fstream>
 #include <iostream>
+#include <sstream>
 #include <string>
 
 #include "common/exception.h"
@@ -16,15 +20,19 @@ INDEX_TEMPLATE_ARGUMENTS
 BPLUSTREE_TYPE::BPlusTree(const std::string &name,
                                 BufferPoolManager *buffer_pool_manager,
                                 const KeyComparator &comparator,
-                                page_id_t root_page_id)
+                                page_id_t root_page_id, int leaf_max_size,
+                                int internal_max_size)
     : index_name_(name), root_page_id_(root_page_id),
-      buffer_pool_manager_(buffer_pool_manager), comparator_(comparator) {}
+      buffer_pool_manager_(buffer_pool_manager), comparator_(comparator),
+      leaf_max_size_(leaf_max_size), internal_max_size_(internal_max_size) {}
 
 /*
  * Helper function to decide whether current b+tree is empty
  */
 INDEX_TEMPLATE_ARGUMENTS
-bool BPLUSTREE_TYPE::IsEmpty() const { return true; }
+bool BPLUSTREE_TYPE::IsEmpty() const {
+  return root_page_id_ == INVALID_PAGE_ID;
+}
 /*****************************************************************************
  * SEARCH
  *****************************************************************************/
@@ -37,7 +45,17 @@ INDEX_TEMPLATE_ARGUMENTS
 bool BPLUSTREE_TYPE::GetValue(const KeyType &key,
                               std::vector<ValueType> &result,
                               Transaction *transaction) {
-  return false;
+  structure_latch_.RLock();
+  ReadPageGuard guard = FetchLeafRead(key);
+  ValueType value;
+  bool found = guard.GetPage() != nullptr &&
+               reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(guard.GetData())
+                   ->Lookup(key, value, comparator_);
+  guard.Release();
+  structure_latch_.RUnlock();
+  if (found)
+    result.push_back(value);
+  return found;
 }
 
 /*****************************************************************************
@@ -53,16 +71,39 @@ bool BPLUSTREE_TYPE::GetValue(const KeyType &key,
 INDEX_TEMPLATE_ARGUMENTS
 bool BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value,
                             Transaction *transaction) {
-  return false;
+  // the tree is not emptied while the structure latch is held shared
+  structure_latch_.RLock();
+  bool started = false;
+  if (IsEmpty()) {
+    std::lock_guard<std::mutex> lock(root_latch_);
+    if (IsEmpty()) {
+      StartNewTree(key, value);
+      started = true;
+    }
+  }
+  bool inserted = started || InsertIntoLeaf(key, value, transaction);
+  structure_latch_.RUnlock();
+  return inserted;
 }
 /*
  * Insert constant key & value pair into an empty tree
  * User needs to first ask for new page from buffer pool manager(NOTICE: throw
  * an "out of memory" exception if returned value is nullptr), then update b+
  * tree's root page id and insert entry directly into leaf page.
+ * NOTE: caller must hold root_latch_
  */
 INDEX_TEMPLATE_ARGUMENTS
-void BPLUSTREE_TYPE::StartNewTree(const KeyType &key, const ValueType &value) {}
+void BPLUSTREE_TYPE::StartNewTree(const KeyType &key, const ValueType &value) {
+  page_id_t page_id;
+  WritePageGuard guard = buffer_pool_manager_->NewPageGuarded(page_id);
+  if (guard.GetPage() == nullptr)
+    throw Exception(EXCEPTION_TYPE_INDEX, "out of memory");
+  auto *root = reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(guard.GetData());
+  root->Init(page_id, INVALID_PAGE_ID, leaf_max_size_);
+  root->Insert(key, value, comparator_);
+  root_page_id_ = page_id;
+  UpdateRootPageId(true);
+}
 
 /*
  * Insert constant key & value pair into leaf page
@@ -71,11 +112,51 @@ void BPLUSTREE_TYPE::StartNewTree(const KeyType &key, const ValueType &value) {}
  * immdiately, otherwise insert entry. Remember to deal with split if necessary.
  * @return: since we only support unique key, if user try to insert duplicate
  * keys return false, otherwise return true.
+ * NOTE: caller must hold the structure latch shared and the tree is not empty
  */
 INDEX_TEMPLATE_ARGUMENTS
 bool BPLUSTREE_TYPE::InsertIntoLeaf(const KeyType &key, const ValueType &value,
                                     Transaction *transaction) {
-  return false;
+  // the internal pages passed on the way down, their separators may go up
+  std::vector<page_id_t> path;
+  WritePageGuard guard = FetchLeafWrite(key, &path);
+  auto *leaf = reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(guard.GetData());
+  ValueType existing;
+  if (leaf->Lookup(key, existing, comparator_)) {
+    guard.SetDirty(false);
+    return false;
+  }
+  if (leaf->Insert(key, value, comparator_) > leaf->GetMaxSize()) {
+    WritePageGuard new_guard = Split(leaf);
+    auto *new_leaf =
+        reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(new_guard.GetData());
+    KeyType separator =
+        ShortSeparator(leaf->KeyAt(leaf->GetSize() - 1), new_leaf->KeyAt(0));
+    leaf->SetHighKey(separator);
+    InsertIntoParent(guard, separator, new_guard, path);
+  }
+  return true;
+}
+
+/*
+ * Helper function to get the shortest key that separates two leaves, the
+ * last key of the left one and the first key of the right one. Normalized
+ * keys compare bytewise, the right key cut after the first byte that differs
+ * from the left one still does then.
+ * @return: right if keys are not normalized
+ */
+INDEX_TEMPLATE_ARGUMENTS
+KeyType BPLUSTREE_TYPE::ShortSeparator(const KeyType &left,
+                                       const KeyType &right) const {
+  if (!comparator_.IsNormalized())
+    return right;
+  size_t size = 0;
+  while (size < sizeof(right.data) && left.data[size] == right.data[size])
+    size++;
+  KeyType separator;
+  memset(separator.data, 0, sizeof(separator.data));
+  memcpy(separator.data, right.data, std::min(size + 1, sizeof(right.data)));
+  return separator;
 }
 
 /*
@@ -84,24 +165,98 @@ bool BPLUSTREE_TYPE::InsertIntoLeaf(const KeyType &key, const ValueType &value,
  * User needs to first ask for new page from buffer pool manager(NOTICE: throw
  * an "out of memory" exception if returned value is nullptr), then move half
  * of key & value pairs from input page to newly created page
+ * @return: the write latched new page
  */
 INDEX_TEMPLATE_ARGUMENTS
-template <typename N> N *BPLUSTREE_TYPE::Split(N *node) { return nullptr; }
+template <typename N> WritePageGuard BPLUSTREE_TYPE::Split(N *node) {
+  page_id_t page_id;
+  WritePageGuard guard = buffer_pool_manager_->NewPageGuarded(page_id);
+  if (guard.GetPage() == nullptr)
+    throw Exception(EXCEPTION_TYPE_INDEX, "out of memory");
+  N *new_node = reinterpret_cast<N *>(guard.GetData());
+  new_node->Init(page_id, node->GetParentPageId(), node->GetMaxSize());
+  node->MoveHalfTo(new_node, buffer_pool_manager_);
+  return guard;
+}
 
 /*
  * Insert key & value pair into internal page after split
- * @param   old_node      input page from split() method
- * @param   key
- * @param   new_node      returned page from split() method
+ * @param   old_guard     the page that split, unlatched on return
+ * @param   key           the high key of the old page now
+ * @param   new_guard     the new right sibling, unlatched on return
+ * @param   path          the internal pages above the old page as found on the
+ *                        way down, the root first
  * User needs to first find the parent page of old_node, parent node must be
  * adjusted to take info of new_node into account. Remember to deal with split
  * recursively if necessary.
+ * The new page is only reachable through the right link of the old one until
+ * then, the old page stays latched until the parent is.
  */
 INDEX_TEMPLATE_ARGUMENTS
-void BPLUSTREE_TYPE::InsertIntoParent(BPlusTreePage *old_node,
+void BPLUSTREE_TYPE::InsertIntoParent(WritePageGuard &old_guard,
                                       const KeyType &key,
-                                      BPlusTreePage *new_node,
-                                      Transaction *transaction) {}
+                                      WritePageGuard &new_guard,
+                                      std::vector<page_id_t> &path) {
+  auto *old_node = reinterpret_cast<BPlusTreePage *>(old_guard.GetData());
+  auto *new_node = reinterpret_cast<BPlusTreePage *>(new_guard.GetData());
+  if (old_node->IsRootPage()) {
+    page_id_t page_id;
+    WritePageGuard guard = buffer_pool_manager_->NewPageGuarded(page_id);
+    if (guard.GetPage() == nullptr)
+      throw Exception(EXCEPTION_TYPE_INDEX, "out of memory");
+    auto *root = reinterpret_cast<BPLUSTREE_INTERNAL_PAGE_TYPE *>(
+        guard.GetData());
+    root->Init(page_id, INVALID_PAGE_ID, internal_max_size_);
+    root->SetLevel(GetLevel(old_node) + 1);
+    root->PopulateNewRoot(old_node->GetPageId(), key, new_node->GetPageId());
+    old_node->SetParentPageId(page_id);
+    new_node->SetParentPageId(page_id);
+    root_page_id_ = page_id;
+    UpdateRootPageId(false);
+    return;
+  }
+
+  if (path.empty()) {
+    // the old page was the root on the way down, the tree grew above it since
+    ReadPageGuard guard = Descend(key, GetLevel(old_node) + 1, false, &path);
+    path.push_back(guard.GetPageId());
+  }
+  WritePageGuard parent_guard =
+      buffer_pool_manager_->FetchPageWrite(path.back());
+  path.pop_back();
+  if (parent_guard.GetPage() == nullptr)
+    throw Exception(EXCEPTION_TYPE_INDEX, "out of memory");
+  // the parent may have split since, the separator still goes next to the
+  // entry of the old page
+  MoveRight(key, parent_guard);
+  auto *parent = reinterpret_cast<BPLUSTREE_INTERNAL_PAGE_TYPE *>(
+      parent_guard.GetData());
+  auto *target = parent;
+  WritePageGuard new_parent_guard;
+  if (!parent->HasRoomFor(key)) {
+    // the key does not fit, split first and insert into the half that holds
+    // the entry of the old page
+    new_parent_guard = Split(parent);
+    auto *new_parent = reinterpret_cast<BPLUSTREE_INTERNAL_PAGE_TYPE *>(
+        new_parent_guard.GetData());
+    if (new_parent->ValueIndex(old_node->GetPageId()) != -1)
+      target = new_parent;
+  }
+  old_node->SetParentPageId(target->GetPageId());
+  new_node->SetParentPageId(target->GetPageId());
+  int size = target->InsertNodeAfter(old_node->GetPageId(), key,
+                                     new_node->GetPageId());
+  new_guard.Release();
+  old_guard.Release();
+  if (new_parent_guard.GetPage() == nullptr && size > parent->GetMaxSize())
+    new_parent_guard = Split(parent);
+  if (new_parent_guard.GetPage() != nullptr) {
+    auto *new_parent = reinterpret_cast<BPLUSTREE_INTERNAL_PAGE_TYPE *>(
+        new_parent_guard.GetData());
+    InsertIntoParent(parent_guard, new_parent->KeyAt(0), new_parent_guard,
+                     path);
+  }
+}
 
 /*****************************************************************************
  * REMOVE
@@ -114,19 +269,115 @@ void BPLUSTREE_TYPE::InsertIntoParent(BPlusTreePage *old_node,
  * necessary.
  */
 INDEX_TEMPLATE_ARGUMENTS
-void BPLUSTREE_TYPE::Remove(const KeyType &key, Transaction *transaction) {}
+void BPLUSTREE_TYPE::Remove(const KeyType &key, Transaction *transaction) {
+  ValueType existing;
+  bool underflows = false;
+  structure_latch_.RLock();
+  {
+    WritePageGuard guard = FetchLeafWrite(key, nullptr);
+    if (guard.GetPage() != nullptr) {
+      auto *leaf =
+          reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(guard.GetData());
+      bool found = leaf->Lookup(key, existing, comparator_);
+      underflows = found && !IsSafe(leaf);
+      if (found && !underflows)
+        leaf->RemoveAndDeleteRecord(key, comparator_);
+      else
+        guard.SetDirty(false);
+    }
+  }
+  structure_latch_.RUnlock();
+  if (!underflows)
+    return;
+
+  // the leaf underflows, start over alone and keep the ancestors that change
+  structure_latch_.WLock();
+  {
+    std::deque<WritePageGuard> path;
+    FetchPathWrite(key, path);
+    if (!path.empty()) {
+      auto *leaf = reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(
+          path.back().GetData());
+      if (leaf->Lookup(key, existing, comparator_)) {
+        leaf->RemoveAndDeleteRecord(key, comparator_);
+        if (leaf->IsRootPage() || leaf->GetSize() < leaf->GetMinSize())
+          CoalesceOrRedistribute(leaf, path);
+      } else {
+        for (auto &guard : path)
+          guard.SetDirty(false);
+      }
+    }
+  }
+  structure_latch_.WUnlock();
+}
 
 /*
  * User needs to first find the sibling of input page. If sibling's size + input
  * page's size > page's max size, then redistribute. Otherwise, merge.
+ * The keys of internal pages have to fit as well, a page that can neither
+ * merge nor redistribute stays underfull.
  * Using template N to represent either internal page or leaf page.
+ * @param   path          write latched pages down to node, node and its
+ *                        sibling are unlatched on return
  * @return: true means target leaf page should be deleted, false means no
  * deletion happens
  */
 INDEX_TEMPLATE_ARGUMENTS
 template <typename N>
-bool BPLUSTREE_TYPE::CoalesceOrRedistribute(N *node, Transaction *transaction) {
-  return false;
+bool BPLUSTREE_TYPE::CoalesceOrRedistribute(N *node,
+                                            std::deque<WritePageGuard> &path) {
+  page_id_t page_id = node->GetPageId();
+  if (node->IsRootPage()) {
+    bool deleted = AdjustRoot(node);
+    path.pop_back();
+    if (deleted)
+      buffer_pool_manager_->DeletePage(page_id);
+    return deleted;
+  }
+
+  auto *parent = reinterpret_cast<BPLUSTREE_INTERNAL_PAGE_TYPE *>(
+      path[path.size() - 2].GetData());
+  int index = parent->ValueIndex(page_id);
+  assert(index != -1);
+  WritePageGuard neighbor_guard;
+  if (index == 0) {
+    neighbor_guard = buffer_pool_manager_->FetchPageWrite(parent->ValueAt(1));
+  } else {
+    // iterators latch leaves from left to right, so latch the left sibling
+    // first. Nobody else gets to the node meanwhile, its parent is latched.
+    path.back().Release();
+    neighbor_guard =
+        buffer_pool_manager_->FetchPageWrite(parent->ValueAt(index - 1));
+    path.back() = buffer_pool_manager_->FetchPageWrite(page_id);
+    if (path.back().GetPage() == nullptr)
+      throw Exception(EXCEPTION_TYPE_INDEX, "out of memory");
+    node = reinterpret_cast<N *>(path.back().GetData());
+  }
+  if (neighbor_guard.GetPage() == nullptr)
+    throw Exception(EXCEPTION_TYPE_INDEX, "out of memory");
+  N *neighbor_node = reinterpret_cast<N *>(neighbor_guard.GetData());
+  // the page helpers find the parent through these hints
+  node->SetParentPageId(parent->GetPageId());
+  neighbor_node->SetParentPageId(parent->GetPageId());
+
+  N *left = index == 0 ? node : neighbor_node;
+  N *right = index == 0 ? neighbor_node : node;
+  if (!left->CanMoveFrom(right, right->GetSize())) {
+    if (CanRedistribute(neighbor_node, node, parent, index))
+      Redistribute(neighbor_node, node, index);
+    path.pop_back();
+    return false;
+  }
+
+  bool parent_underflows = Coalesce(neighbor_node, node, parent, index);
+  // the right one of both pages is empty now
+  page_id_t deleted_page_id = node->GetPageId();
+  path.pop_back();
+  neighbor_guard.Release();
+  buffer_pool_manager_->DeletePage(deleted_page_id);
+  if (parent_underflows)
+    CoalesceOrRedistribute(parent, path);
+  return deleted_page_id == page_id;
 }
 
 /*
@@ -140,14 +391,41 @@ bool BPLUSTREE_TYPE::CoalesceOrRedistribute(N *node, Transaction *transaction) {
  * @param   parent             parent page of input "node"
  * @return  true means parent node should be deleted, false means no deletion
  * happend
+ * NOTE: the right page is always merged into the left one, on return node is
+ * the emptied right page and neighbor_node the left one. The caller deletes
+ * node once it is unlatched and takes care of the parent.
  */
 INDEX_TEMPLATE_ARGUMENTS
 template <typename N>
-bool BPLUSTREE_TYPE::Coalesce(
-    N *&neighbor_node, N *&node,
-    BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator> *&parent,
-    int index, Transaction *transaction) {
-  return false;
+bool BPLUSTREE_TYPE::Coalesce(N *&neighbor_node, N *&node,
+                              BPLUSTREE_INTERNAL_PAGE_TYPE *&parent,
+                              int index) {
+  if (index == 0)
+    std::swap(neighbor_node, node);
+  int node_index = parent->ValueIndex(node->GetPageId());
+  node->MoveAllTo(neighbor_node, node_index, buffer_pool_manager_);
+  parent->Remove(node_index);
+  if (parent->IsRootPage())
+    return parent->GetSize() == 1;
+  return parent->IsUnderfull();
+}
+
+/*
+ * Helper function to decide whether Redistribute() fits: node takes a pair
+ * of its sibling, and the parent a new separator between both
+ * Using template N to represent either internal page or leaf page.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+template <typename N>
+bool BPLUSTREE_TYPE::CanRedistribute(N *neighbor_node, N *node,
+                                     BPLUSTREE_INTERNAL_PAGE_TYPE *parent,
+                                     int index) const {
+  if (!node->CanMoveFrom(neighbor_node, 1))
+    return false;
+  if (index == 0)
+    return parent->CanSetKeyAt(1, neighbor_node->KeyAt(1));
+  return parent->CanSetKeyAt(
+      index, neighbor_node->KeyAt(neighbor_node->GetSize() - 1));
 }
 
 /*
@@ -161,7 +439,12 @@ bool BPLUSTREE_TYPE::Coalesce(
  */
 INDEX_TEMPLATE_ARGUMENTS
 template <typename N>
-void BPLUSTREE_TYPE::Redistribute(N *neighbor_node, N *node, int index) {}
+void BPLUSTREE_TYPE::Redistribute(N *neighbor_node, N *node, int index) {
+  if (index == 0)
+    neighbor_node->MoveFirstToEndOf(node, buffer_pool_manager_);
+  else
+    neighbor_node->MoveLastToFrontOf(node, index, buffer_pool_manager_);
+}
 /*
  * Update root page if necessary
  * NOTE: size of root page can be less than min size and this method is only
@@ -171,10 +454,212 @@ void BPLUSTREE_TYPE::Redistribute(N *neighbor_node, N *node, int index) {}
  * case 2: when you delete the last element in whole b+ tree
  * @return : true means root page should be deleted, false means no deletion
  * happend
+ * NOTE: caller must hold the write latch of old_root_node
  */
 INDEX_TEMPLATE_ARGUMENTS
 bool BPLUSTREE_TYPE::AdjustRoot(BPlusTreePage *old_root_node) {
-  return false;
+  if (old_root_node->IsLeafPage()) {
+    if (old_root_node->GetSize() > 0)
+      return false;
+    root_page_id_ = INVALID_PAGE_ID;
+    UpdateRootPageId(false);
+    return true;
+  }
+  if (old_root_node->GetSize() > 1)
+    return false;
+  auto *old_root = static_cast<BPLUSTREE_INTERNAL_PAGE_TYPE *>(old_root_node);
+  page_id_t child_page_id = old_root->RemoveAndReturnOnlyChild();
+  Page *page = FetchPinnedPage(child_page_id);
+  reinterpret_cast<BPlusTreePage *>(page->GetData())
+      ->SetParentPageId(INVALID_PAGE_ID);
+  buffer_pool_manager_->UnpinPage(child_page_id, true);
+  root_page_id_ = child_page_id;
+  UpdateRootPageId(false);
+  return true;
+}
+
+/*****************************************************************************
+ * BULK LOAD
+ *****************************************************************************/
+/*
+ * Build this empty b+ tree bottom-up from key & value pairs in ascending key
+ * order, pass unsorted input through an ExternalSorter first. Leaves are
+ * filled to fill_factor one after another, the internal levels above them
+ * grow along, so every page is written once and the pages of a level are
+ * allocated in key order. Only the first of equal keys is loaded.
+ * @return: false if the tree is not empty, or if the source is not sorted.
+ * The tree then holds the pairs before the first out of order one.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::BulkLoad(const PairSource &source, double fill_factor,
+                              Transaction *transaction) {
+  structure_latch_.WLock();
+  if (!IsEmpty()) {
+    structure_latch_.WUnlock();
+    return false;
+  }
+  std::vector<BulkLoadLevel> levels;
+  KeyType key, last_key;
+  ValueType value;
+  bool sorted = true;
+  while (source(key, value)) {
+    if (!levels.empty()) {
+      int order = comparator_(key, last_key);
+      if (order == 0)
+        continue;
+      if (order < 0) {
+        sorted = false;
+        break;
+      }
+    }
+    BulkLoadAppend<B_PLUS_TREE_LEAF_PAGE_TYPE>(levels, 0, key, value,
+                                               fill_factor);
+    last_key = key;
+  }
+  if (!levels.empty()) {
+    root_page_id_ = BulkLoadFinish(levels, fill_factor);
+    UpdateRootPageId(true);
+  }
+  structure_latch_.WUnlock();
+  return sorted;
+}
+
+/*
+ * Helper function to get how many pairs a bulk load puts into a page at
+ * level, never less than the min size
+ */
+INDEX_TEMPLATE_ARGUMENTS
+int BPLUSTREE_TYPE::BulkLoadFillSize(size_t level, double fill_factor) const {
+  int max_size = level == 0 ? leaf_max_size_ : internal_max_size_;
+  int fill = static_cast<int>(max_size * fill_factor);
+  // an internal page points to two children at least
+  fill = std::max(fill, std::max(max_size / 2, level == 0 ? 1 : 2));
+  return std::min(fill, max_size);
+}
+
+/*
+ * Append key & value pair to the rightmost page of level, start a new page
+ * if it is full. The page left of the new one is complete then and linked
+ * into the level above.
+ * Using template N to represent either internal page or leaf page.
+ * @return: the page the pair went into
+ * NOTE: caller must hold the structure latch exclusively
+ */
+INDEX_TEMPLATE_ARGUMENTS
+template <typename N, typename V>
+N *BPLUSTREE_TYPE::BulkLoadAppend(std::vector<BulkLoadLevel> &levels,
+                                  size_t level, const KeyType &key,
+                                  const V &value, double fill_factor) {
+  if (levels.size() == level)
+    levels.emplace_back();
+  N *node = levels[level].right.GetPage() == nullptr
+                ? nullptr
+                : reinterpret_cast<N *>(levels[level].right.GetData());
+  if (node == nullptr ||
+      node->GetSize() >= BulkLoadFillSize(level, fill_factor) ||
+      !node->HasRoomFor(key)) {
+    // levels may grow here, they are indexed again afterwards
+    if (levels[level].left.GetPage() != nullptr)
+      BulkLoadLink(levels, level, fill_factor);
+    page_id_t page_id;
+    WritePageGuard guard = buffer_pool_manager_->NewPageGuarded(page_id);
+    if (guard.GetPage() == nullptr)
+      throw Exception(EXCEPTION_TYPE_INDEX, "out of memory");
+    N *new_node = reinterpret_cast<N *>(guard.GetData());
+    new_node->Init(page_id, INVALID_PAGE_ID,
+                   level == 0 ? leaf_max_size_ : internal_max_size_);
+    if (level > 0)
+      reinterpret_cast<BPLUSTREE_INTERNAL_PAGE_TYPE *>(new_node)->SetLevel(
+          static_cast<int>(level));
+    if (node != nullptr) {
+      node->SetNextPageId(page_id);
+      node->SetHighKey(key);
+    }
+    levels[level].left = std::move(levels[level].right);
+    levels[level].right = std::move(guard);
+    node = new_node;
+  }
+  node->Append(key, value);
+  return node;
+}
+
+/*
+ * Helper function to link the left page of level into the level above: its
+ * first key becomes the separator. The page is complete and unlatched.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::BulkLoadLink(std::vector<BulkLoadLevel> &levels,
+                                  size_t level, double fill_factor) {
+  auto *node = reinterpret_cast<BPlusTreePage *>(levels[level].left.GetData());
+  KeyType key =
+      node->IsLeafPage()
+          ? static_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(node)->KeyAt(0)
+          : static_cast<BPLUSTREE_INTERNAL_PAGE_TYPE *>(node)->KeyAt(0);
+  auto *parent = BulkLoadAppend<BPLUSTREE_INTERNAL_PAGE_TYPE>(
+      levels, level + 1, key, node->GetPageId(), fill_factor);
+  node->SetParentPageId(parent->GetPageId());
+  levels[level].left.Release();
+}
+
+/*
+ * Helper function to fill up the last page of a level from its left sibling
+ * if it is underfull, or to merge both if they fit into one page.
+ * Children moved keep their parent page id as a hint.
+ * Using template N to represent either internal page or leaf page.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+template <typename N>
+void BPLUSTREE_TYPE::BulkLoadBalance(BulkLoadLevel &pages) {
+  N *left = reinterpret_cast<N *>(pages.left.GetData());
+  N *right = reinterpret_cast<N *>(pages.right.GetData());
+  if (!right->IsUnderfull())
+    return;
+  if (left->CanMoveFrom(right, right->GetSize())) {
+    right->MoveHeadTo(left, right->GetSize());
+    return;
+  }
+  int size = (left->GetSize() + right->GetSize()) / 2 - right->GetSize();
+  while (size > 0 && !right->CanMoveFrom(left, size))
+    size--;
+  if (size > 0)
+    left->MoveTailTo(right, size);
+}
+
+/*
+ * Helper function to complete a bulk load once the input is exhausted. Level
+ * by level, the last two pages are balanced and linked into the level above,
+ * until a level has a single page.
+ * @return: the page id of the new root
+ */
+INDEX_TEMPLATE_ARGUMENTS
+page_id_t BPLUSTREE_TYPE::BulkLoadFinish(std::vector<BulkLoadLevel> &levels,
+                                         double fill_factor) {
+  for (size_t level = 0;; level++) {
+    if (levels[level].left.GetPage() != nullptr) {
+      if (level == 0)
+        BulkLoadBalance<B_PLUS_TREE_LEAF_PAGE_TYPE>(levels[level]);
+      else
+        BulkLoadBalance<BPLUSTREE_INTERNAL_PAGE_TYPE>(levels[level]);
+      auto *right =
+          reinterpret_cast<BPlusTreePage *>(levels[level].right.GetData());
+      if (right->GetSize() == 0) {
+        page_id_t page_id = right->GetPageId();
+        levels[level].right.SetDirty(false);
+        levels[level].right = std::move(levels[level].left);
+        buffer_pool_manager_->DeletePage(page_id);
+      }
+    }
+    if (levels[level].left.GetPage() == nullptr &&
+        levels.size() == level + 1) {
+      page_id_t page_id = levels[level].right.GetPageId();
+      levels[level].right.Release();
+      return page_id;
+    }
+    if (levels[level].left.GetPage() != nullptr)
+      BulkLoadLink(levels, level, fill_factor);
+    levels[level].left = std::move(levels[level].right);
+    BulkLoadLink(levels, level, fill_factor);
+  }
 }
 
 /*****************************************************************************
@@ -186,7 +671,13 @@ bool BPLUSTREE_TYPE::AdjustRoot(BPlusTreePage *old_root_node) {
  * @return : index iterator
  */
 INDEX_TEMPLATE_ARGUMENTS
-INDEXITERATOR_TYPE BPLUSTREE_TYPE::Begin() { return INDEXITERATOR_TYPE(); }
+INDEXITERATOR_TYPE BPLUSTREE_TYPE::Begin() {
+  structure_latch_.RLock();
+  ReadPageGuard guard = FetchLeafRead(KeyType(), true);
+  structure_latch_.RUnlock();
+  return INDEXITERATOR_TYPE(buffer_pool_manager_, std::move(guard), 0,
+                            comparator_);
+}
 
 /*
  * Input parameter is low key, find the leaf page that contains the input key
@@ -195,7 +686,35 @@ INDEXITERATOR_TYPE BPLUSTREE_TYPE::Begin() { return INDEXITERATOR_TYPE(); }
  */
 INDEX_TEMPLATE_ARGUMENTS
 INDEXITERATOR_TYPE BPLUSTREE_TYPE::Begin(const KeyType &key) {
-  return INDEXITERATOR_TYPE();
+  structure_latch_.RLock();
+  ReadPageGuard guard = FetchLeafRead(key);
+  structure_latch_.RUnlock();
+  int index = 0;
+  if (guard.GetPage() != nullptr)
+    index = reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(guard.GetData())
+                ->KeyIndex(key, comparator_);
+  return INDEXITERATOR_TYPE(buffer_pool_manager_, std::move(guard), index,
+                            comparator_);
+}
+
+/*
+ * Input parameter is the first key of a range and the first key past it, find
+ * the leaf page of the first key, then construct an index iterator that stops
+ * in front of end_key
+ * @return : index iterator
+ */
+INDEX_TEMPLATE_ARGUMENTS
+INDEXITERATOR_TYPE BPLUSTREE_TYPE::Begin(const KeyType &key,
+                                         const KeyType &end_key) {
+  structure_latch_.RLock();
+  ReadPageGuard guard = FetchLeafRead(key);
+  structure_latch_.RUnlock();
+  int index = 0;
+  if (guard.GetPage() != nullptr)
+    index = reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(guard.GetData())
+                ->KeyIndex(key, comparator_);
+  return INDEXITERATOR_TYPE(buffer_pool_manager_, std::move(guard), index,
+                            comparator_, &end_key);
 }
 
 /*****************************************************************************
@@ -204,11 +723,246 @@ INDEXITERATOR_TYPE BPLUSTREE_TYPE::Begin(const KeyType &key) {
 /*
  * Find leaf page containing particular key, if leftMost flag == true, find
  * the left most leaf page
+ * NOTE: the leaf is returned pinned but not latched, caller must unpin it
  */
 INDEX_TEMPLATE_ARGUMENTS
 B_PLUS_TREE_LEAF_PAGE_TYPE *BPLUSTREE_TYPE::FindLeafPage(const KeyType &key,
                                                          bool leftMost) {
-  return nullptr;
+  structure_latch_.RLock();
+  ReadPageGuard guard = FetchLeafRead(key, leftMost);
+  structure_latch_.RUnlock();
+  if (guard.GetPage() == nullptr)
+    return nullptr;
+  Page *page = FetchPinnedPage(guard.GetPageId());
+  return reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(page->GetData());
+}
+
+/*
+ * Helper function to fetch a page that is only pinned, throw an "out of
+ * memory" exception if all frames are pinned
+ */
+INDEX_TEMPLATE_ARGUMENTS
+Page *BPLUSTREE_TYPE::FetchPinnedPage(page_id_t page_id) {
+  Page *page = buffer_pool_manager_->FetchPage(page_id);
+  if (page == nullptr)
+    throw Exception(EXCEPTION_TYPE_INDEX, "out of memory");
+  return page;
+}
+
+/*
+ * Helper functions to latch the root page. The root page id is read without a
+ * latch, the page is only taken once it is still the root after latching it.
+ * Whoever replaces the root holds the write latch of the old one.
+ * @return: an empty guard if the tree is empty
+ */
+INDEX_TEMPLATE_ARGUMENTS
+ReadPageGuard BPLUSTREE_TYPE::FetchRootRead() {
+  while (true) {
+    page_id_t root_page_id = root_page_id_;
+    if (root_page_id == INVALID_PAGE_ID)
+      return ReadPageGuard();
+    ReadPageGuard guard = buffer_pool_manager_->FetchPageRead(root_page_id);
+    if (guard.GetPage() == nullptr)
+      throw Exception(EXCEPTION_TYPE_INDEX, "out of memory");
+    if (root_page_id_ == root_page_id)
+      return guard;
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+WritePageGuard BPLUSTREE_TYPE::FetchRootWrite() {
+  while (true) {
+    page_id_t root_page_id = root_page_id_;
+    if (root_page_id == INVALID_PAGE_ID)
+      return WritePageGuard();
+    WritePageGuard guard = buffer_pool_manager_->FetchPageWrite(root_page_id);
+    if (guard.GetPage() == nullptr)
+      throw Exception(EXCEPTION_TYPE_INDEX, "out of memory");
+    if (root_page_id_ == root_page_id)
+      return guard;
+    guard.SetDirty(false);
+  }
+}
+
+/*
+ * Helper function to descend to the page at level that covers key, holding
+ * one read latch at a time. A page that split before it was latched is left
+ * through its right link.
+ * @param   path          if not null, the internal pages above level are
+ *                        appended to it, the root first
+ * @return: an empty guard if the tree is empty, the root if it is lower than
+ * level
+ * NOTE: caller must hold the structure latch
+ */
+INDEX_TEMPLATE_ARGUMENTS
+ReadPageGuard BPLUSTREE_TYPE::Descend(const KeyType &key, int level,
+                                      bool leftMost,
+                                      std::vector<page_id_t> *path) {
+  ReadPageGuard guard = FetchRootRead();
+  if (guard.GetPage() == nullptr)
+    return guard;
+  while (true) {
+    // the leftmost page of a level keeps the smallest keys when it splits
+    if (!leftMost)
+      MoveRight(key, guard);
+    auto *node = reinterpret_cast<BPlusTreePage *>(guard.GetData());
+    if (GetLevel(node) <= level)
+      return guard;
+    auto *internal = static_cast<BPLUSTREE_INTERNAL_PAGE_TYPE *>(node);
+    page_id_t child_page_id =
+        leftMost ? internal->ValueAt(0) : internal->Lookup(key, comparator_);
+    if (path != nullptr)
+      path->push_back(internal->GetPageId());
+    guard.Release();
+    guard = buffer_pool_manager_->FetchPageRead(child_page_id);
+    if (guard.GetPage() == nullptr)
+      throw Exception(EXCEPTION_TYPE_INDEX, "out of memory");
+  }
+}
+
+/*
+ * Helper function to read latch the leaf that contains key
+ * @return: an empty guard if the tree is empty
+ */
+INDEX_TEMPLATE_ARGUMENTS
+ReadPageGuard BPLUSTREE_TYPE::FetchLeafRead(const KeyType &key,
+                                            bool leftMost) {
+  return Descend(key, 0, leftMost, nullptr);
+}
+
+/*
+ * Helper function to write latch the leaf that contains key, the pages above
+ * it are read latched one at a time
+ * @param   path          if not null, the internal pages passed are appended
+ *                        to it, the root first
+ * @return: an empty guard if the tree is empty
+ */
+INDEX_TEMPLATE_ARGUMENTS
+WritePageGuard BPLUSTREE_TYPE::FetchLeafWrite(const KeyType &key,
+                                              std::vector<page_id_t> *path) {
+  ReadPageGuard guard = Descend(key, 1, false, path);
+  if (guard.GetPage() == nullptr)
+    return WritePageGuard();
+  auto *node = reinterpret_cast<BPlusTreePage *>(guard.GetData());
+  page_id_t leaf_page_id = node->GetPageId();
+  // otherwise the root is the only leaf and it is latched again for writing
+  if (!node->IsLeafPage()) {
+    if (path != nullptr)
+      path->push_back(leaf_page_id);
+    leaf_page_id = static_cast<BPLUSTREE_INTERNAL_PAGE_TYPE *>(node)->Lookup(
+        key, comparator_);
+  }
+  guard.Release();
+  WritePageGuard leaf = buffer_pool_manager_->FetchPageWrite(leaf_page_id);
+  if (leaf.GetPage() == nullptr)
+    throw Exception(EXCEPTION_TYPE_INDEX, "out of memory");
+  MoveRight(key, leaf);
+  return leaf;
+}
+
+/*
+ * Helper function for removals that underflow their leaf: couple write
+ * latches down to the leaf that contains key. Ancestors are unlatched as soon
+ * as a page below them is safe, the change cannot reach them then.
+ * @param   path          filled with the latched pages top-down, the leaf is
+ *                        last. Left empty if the tree is empty
+ * NOTE: caller must hold the structure latch exclusively, all splits are
+ * complete then
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::FetchPathWrite(const KeyType &key,
+                                    std::deque<WritePageGuard> &path) {
+  WritePageGuard guard = FetchRootWrite();
+  if (guard.GetPage() == nullptr)
+    return;
+  path.push_back(std::move(guard));
+  auto *node = reinterpret_cast<BPlusTreePage *>(path.back().GetData());
+  while (!node->IsLeafPage()) {
+    auto *internal = static_cast<BPLUSTREE_INTERNAL_PAGE_TYPE *>(node);
+    WritePageGuard child = buffer_pool_manager_->FetchPageWrite(
+        internal->Lookup(key, comparator_));
+    if (child.GetPage() == nullptr)
+      throw Exception(EXCEPTION_TYPE_INDEX, "out of memory");
+    node = reinterpret_cast<BPlusTreePage *>(child.GetData());
+    if (IsSafe(node)) {
+      for (auto &ancestor : path)
+        ancestor.SetDirty(false);
+      path.clear();
+    }
+    path.push_back(std::move(child));
+  }
+}
+
+/*
+ * Helper function to find where key continues if node split before it was
+ * latched
+ * @return: the right sibling of node if key lies beyond its high key,
+ * INVALID_PAGE_ID otherwise
+ */
+INDEX_TEMPLATE_ARGUMENTS
+page_id_t BPLUSTREE_TYPE::RightLink(BPlusTreePage *node,
+                                    const KeyType &key) const {
+  if (node->IsLeafPage()) {
+    auto *leaf = static_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(node);
+    return leaf->IsBeyondHighKey(key, comparator_) ? leaf->GetNextPageId()
+                                                   : INVALID_PAGE_ID;
+  }
+  auto *internal = static_cast<BPLUSTREE_INTERNAL_PAGE_TYPE *>(node);
+  return internal->IsBeyondHighKey(key, comparator_)
+             ? internal->GetNextPageId()
+             : INVALID_PAGE_ID;
+}
+
+/*
+ * Helper functions to move the latch right until the page covers key. The
+ * right sibling is latched before the page is left.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::MoveRight(const KeyType &key, ReadPageGuard &guard) {
+  page_id_t page_id;
+  while ((page_id = RightLink(
+              reinterpret_cast<BPlusTreePage *>(guard.GetData()), key)) !=
+         INVALID_PAGE_ID) {
+    ReadPageGuard right = buffer_pool_manager_->FetchPageRead(page_id);
+    if (right.GetPage() == nullptr)
+      throw Exception(EXCEPTION_TYPE_INDEX, "out of memory");
+    guard = std::move(right);
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::MoveRight(const KeyType &key, WritePageGuard &guard) {
+  page_id_t page_id;
+  while ((page_id = RightLink(
+              reinterpret_cast<BPlusTreePage *>(guard.GetData()), key)) !=
+         INVALID_PAGE_ID) {
+    WritePageGuard right = buffer_pool_manager_->FetchPageWrite(page_id);
+    if (right.GetPage() == nullptr)
+      throw Exception(EXCEPTION_TYPE_INDEX, "out of memory");
+    guard.SetDirty(false);
+    guard = std::move(right);
+  }
+}
+
+/*
+ * Helper function to get the level of node, leaves are at level 0
+ */
+INDEX_TEMPLATE_ARGUMENTS
+int BPLUSTREE_TYPE::GetLevel(BPlusTreePage *node) const {
+  if (node->IsLeafPage())
+    return 0;
+  return static_cast<BPLUSTREE_INTERNAL_PAGE_TYPE *>(node)->GetLevel();
+}
+
+/*
+ * Helper function to decide whether a removal from node leaves its parent
+ * alone, i.e. node does not underflow
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::IsSafe(BPlusTreePage *node) const {
+  if (node->IsRootPage())
+    return node->GetSize() > (node->IsLeafPage() ? 1 : 2);
+  return node->GetSize() > node->GetMinSize();
 }
 
 /*
@@ -221,15 +975,15 @@ B_PLUS_TREE_LEAF_PAGE_TYPE *BPLUSTREE_TYPE::FindLeafPage(const KeyType &key,
  */
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_TYPE::UpdateRootPageId(int insert_record) {
-  HeaderPage *header_page = static_cast<HeaderPage *>(
-      buffer_pool_manager_->FetchPage(HEADER_PAGE_ID));
-  if (insert_record)
-    // create a new record<index_name + root_page_id> in header_page
-    header_page->InsertRecord(index_name_, root_page_id_);
-  else
-    // update root_page_id in header_page
-    header_page->UpdateRecord(index_name_, root_page_id_);
-  buffer_pool_manager_->UnpinPage(HEADER_PAGE_ID, true);
+  WritePageGuard header_page =
+      buffer_pool_manager_->FetchPageWrite(HEADER_PAGE_ID);
+  // create a new record<index_name + root_page_id> in header_page, it is
+  // still there when the tree was emptied before
+  if (insert_record &&
+      header_page.As<HeaderPage>()->InsertRecord(index_name_, root_page_id_))
+    return;
+  // update root_page_id in header_page
+  header_page.As<HeaderPage>()->UpdateRecord(index_name_, root_page_id_);
 }
 
 /*
@@ -237,7 +991,35 @@ void BPLUSTREE_TYPE::UpdateRootPageId(int insert_record) {
  * print out whole b+tree sturcture, rank by rank
  */
 INDEX_TEMPLATE_ARGUMENTS
-std::string BPLUSTREE_TYPE::ToString(bool verbose) { return "Empty tree"; }
+std::string BPLUSTREE_TYPE::ToString(bool verbose) {
+  if (IsEmpty())
+    return "Empty tree";
+  // pages are not latched, do not print while the tree changes
+  std::queue<BPlusTreePage *> level, next_level;
+  level.push(reinterpret_cast<BPlusTreePage *>(
+      FetchPinnedPage(root_page_id_)->GetData()));
+  std::ostringstream os;
+  while (!level.empty()) {
+    BPlusTreePage *node = level.front();
+    level.pop();
+    if (node->IsLeafPage()) {
+      os << static_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(node)->ToString(verbose);
+    } else {
+      auto *internal = static_cast<BPLUSTREE_INTERNAL_PAGE_TYPE *>(node);
+      os << internal->ToString(verbose);
+      internal->QueueUpChildren(&next_level, buffer_pool_manager_);
+    }
+    buffer_pool_manager_->UnpinPage(node->GetPageId(), false);
+    if (level.empty()) {
+      std::swap(level, next_level);
+      if (!level.empty())
+        os << '\n';
+    } else {
+      os << " | ";
+    }
+  }
+  return os.str();
+}
 
 /*
  * This method is used for test only
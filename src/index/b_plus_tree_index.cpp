@@ -2,6 +2,9 @@
  * b_plus_tree_index.cpp
  */
 
+#include <algorithm>
+#include <cstring>
+
 #include "index/b_plus_tree_index.h"
 
 namespace cmudb {
@@ -12,7 +15,7 @@ INDEX_TEMPLATE_ARGUMENTS
 BPLUSTREE_INDEX_TYPE::BPlusTreeIndex(IndexMetadata *metadata,
                                      BufferPoolManager *buffer_pool_manager,
                                      page_id_t root_page_id)
-    : Index(metadata), comparator_(metadata->GetKeySchema()),
+    : Index(metadata), comparator_(metadata->GetKeySchema(), true),
       container_(metadata->GetName(), buffer_pool_manager, comparator_,
                  root_page_id) {}
 
@@ -21,7 +24,7 @@ void BPLUSTREE_INDEX_TYPE::InsertEntry(const Tuple &key, RID rid,
                                        Transaction *transaction) {
   // construct insert index key
   KeyType index_key;
-  index_key.SetFromKey(key);
+  index_key.SetFromKey(key, GetKeySchema());
 
   container_.Insert(index_key, rid, transaction);
 }
@@ -31,7 +34,7 @@ void BPLUSTREE_INDEX_TYPE::DeleteEntry(const Tuple &key,
                                        Transaction *transaction) {
   // construct delete index key
   KeyType index_key;
-  index_key.SetFromKey(key);
+  index_key.SetFromKey(key, GetKeySchema());
 
   container_.Remove(index_key, transaction);
 }
@@ -41,10 +44,63 @@ void BPLUSTREE_INDEX_TYPE::ScanKey(const Tuple &key, std::vector<RID> &result,
                                    Transaction *transaction) {
   // construct scan index key
   KeyType index_key;
-  index_key.SetFromKey(key);
+  index_key.SetFromKey(key, GetKeySchema());
 
   container_.GetValue(index_key, result, transaction);
 }
+
+/*
+ * Collect the entries between low and high. Normalized keys compare
+ * bytewise, the keys that match the columns of a bound are the ones that
+ * start with its encoding. So every range is turned into one from a first key
+ * up to a first key past it.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_INDEX_TYPE::ScanRange(const ScanBound &low,
+                                     const ScanBound &high,
+                                     std::vector<RID> &result,
+                                     Transaction *transaction) {
+  // the all zero key is the least one
+  KeyType low_key;
+  memset(low_key.data, 0, sizeof(low_key.data));
+  if (low.key != nullptr) {
+    size_t size = low_key.SetFromKey(*low.key, GetKeySchema(),
+                                     low.column_count);
+    if (!low.inclusive && !SetToSuccessor(low_key, size))
+      return;
+  }
+  KeyType high_key;
+  bool bounded = high.key != nullptr;
+  if (bounded) {
+    size_t size = high_key.SetFromKey(*high.key, GetKeySchema(),
+                                      high.column_count);
+    if (high.inclusive)
+      bounded = SetToSuccessor(high_key, size);
+  }
+
+  auto iterator = bounded ? container_.Begin(low_key, high_key)
+                          : container_.Begin(low_key);
+  for (; !iterator.isEnd(); ++iterator)
+    result.push_back((*iterator).second);
+}
+
+/*
+ * Helper function to turn key into the least key that is greater than all
+ * keys starting with its first size bytes
+ * @return: false if there is none
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_INDEX_TYPE::SetToSuccessor(KeyType &key, size_t size) {
+  for (size_t i = std::min(size, sizeof(key.data)); i-- > 0;) {
+    if (static_cast<uint8_t>(key.data[i]) != 0xFF) {
+      key.data[i]++;
+      memset(key.data + i + 1, 0, sizeof(key.data) - i - 1);
+      return true;
+    }
+  }
+  return false;
+}
+
 template class BPlusTreeIndex<GenericKey<4>, RID, GenericComparator<4>>;
 template class BPlusTreeIndex<GenericKey<8>, RID, GenericComparator<8>>;
 template class BPlusTreeIndex<GenericKey<16>, RID, GenericComparator<16>>;
@@ -0,0 +1,464 @@
+/**
+ * extendible_hash_table.cpp
+ */
+#include "common/rid.h"
+#include "index/extendible_hash_table.h"
+#include "page/header_page.h"
+
+namespace cmudb {
+
+INDEX_TEMPLATE_ARGUMENTS
+EXTENDIBLE_HASH_TABLE_TYPE::ExtendibleHashTable(
+    const std::string &name, BufferPoolManager *buffer_pool_manager,
+    const KeyComparator &comparator, page_id_t directory_page_id)
+    : index_name_(name), directory_page_id_(directory_page_id),
+      buffer_pool_manager_(buffer_pool_manager), comparator_(comparator) {}
+
+/*
+ * Helper function to decide whether current hash table is empty
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool EXTENDIBLE_HASH_TABLE_TYPE::IsEmpty() const {
+  page_id_t directory_page_id = directory_page_id_.load();
+  if (directory_page_id == INVALID_PAGE_ID)
+    return true;
+  ReadPageGuard directory_page =
+      buffer_pool_manager_->FetchPageRead(directory_page_id);
+  auto directory =
+      reinterpret_cast<HashTableDirectoryPage *>(directory_page.GetData());
+  // merging folds empty buckets away, only a lone bucket can be empty
+  if (directory->GetGlobalDepth() > 0)
+    return false;
+  ReadPageGuard bucket_page =
+      buffer_pool_manager_->FetchPageRead(directory->GetBucketPageId(0));
+  return reinterpret_cast<HASH_TABLE_BUCKET_PAGE_TYPE *>(
+             bucket_page.GetData())
+      ->IsEmpty();
+}
+
+/*****************************************************************************
+ * SEARCH
+ *****************************************************************************/
+/*
+ * Return the only value that associated with input key
+ * This method is used for point query
+ * @return : true means key exists
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool EXTENDIBLE_HASH_TABLE_TYPE::GetValue(const KeyType &key,
+                                          std::vector<ValueType> &result,
+                                          Transaction *transaction) {
+  page_id_t directory_page_id = directory_page_id_.load();
+  if (directory_page_id == INVALID_PAGE_ID)
+    return false;
+  ReadPageGuard directory_page =
+      buffer_pool_manager_->FetchPageRead(directory_page_id);
+  auto directory =
+      reinterpret_cast<HashTableDirectoryPage *>(directory_page.GetData());
+  ReadPageGuard bucket_page = buffer_pool_manager_->FetchPageRead(
+      directory->GetBucketPageId(directory->GetSlot(Hash(key))));
+
+  ValueType value;
+  if (!ChainLookup(reinterpret_cast<HASH_TABLE_BUCKET_PAGE_TYPE *>(
+                       bucket_page.GetData()),
+                   key, value))
+    return false;
+  result.push_back(value);
+  return true;
+}
+
+/*****************************************************************************
+ * INSERTION
+ *****************************************************************************/
+/*
+ * Insert constant key & value pair into the hash table. The bucket is
+ * modified under the directory read latch unless it has to split, a full
+ * bucket at DIRECTORY_MAX_DEPTH gets overflow pages instead.
+ * @return: since we only support unique key, if user try to insert duplicate
+ * keys return false, otherwise return true. Also false if the buffer pool is
+ * out of frames.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool EXTENDIBLE_HASH_TABLE_TYPE::Insert(const KeyType &key,
+                                        const ValueType &value,
+                                        Transaction *transaction) {
+  if (directory_page_id_.load() == INVALID_PAGE_ID && !StartNewTable())
+    return false;
+
+  {
+    ReadPageGuard directory_page =
+        buffer_pool_manager_->FetchPageRead(directory_page_id_.load());
+    auto directory =
+        reinterpret_cast<HashTableDirectoryPage *>(directory_page.GetData());
+    uint32_t slot = directory->GetSlot(Hash(key));
+    WritePageGuard bucket_page =
+        buffer_pool_manager_->FetchPageWrite(directory->GetBucketPageId(slot));
+    auto bucket =
+        reinterpret_cast<HASH_TABLE_BUCKET_PAGE_TYPE *>(bucket_page.GetData());
+    ValueType existing;
+    if (ChainLookup(bucket, key, existing)) {
+      bucket_page.SetDirty(false);
+      return false;
+    }
+    if (bucket->Insert(key, value, comparator_))
+      return true;
+    // the bucket links to its first overflow page
+    if (directory->GetLocalDepth(slot) == DIRECTORY_MAX_DEPTH)
+      return ChainInsert(bucket, key, value);
+    bucket_page.SetDirty(false);
+  }
+  return SplitInsert(key, value);
+}
+
+/*
+ * Helper function to create the directory and its first bucket of an empty
+ * table and record the directory in the header page
+ * @return: false if the buffer pool is out of frames
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool EXTENDIBLE_HASH_TABLE_TYPE::StartNewTable() {
+  std::lock_guard<std::mutex> guard(latch_);
+  if (directory_page_id_.load() != INVALID_PAGE_ID)
+    return true;
+
+  page_id_t directory_page_id, bucket_page_id;
+  WritePageGuard directory_page =
+      buffer_pool_manager_->NewPageGuarded(directory_page_id);
+  if (!directory_page)
+    return false;
+  WritePageGuard bucket_page =
+      buffer_pool_manager_->NewPageGuarded(bucket_page_id);
+  if (!bucket_page) {
+    directory_page.Release();
+    buffer_pool_manager_->DeletePage(directory_page_id);
+    return false;
+  }
+  reinterpret_cast<HashTableDirectoryPage *>(directory_page.GetData())
+      ->Init(directory_page_id, bucket_page_id);
+  reinterpret_cast<HASH_TABLE_BUCKET_PAGE_TYPE *>(bucket_page.GetData())
+      ->Init();
+
+  // create a new record<index_name + directory_page_id> in header_page
+  WritePageGuard header_page =
+      buffer_pool_manager_->FetchPageWrite(HEADER_PAGE_ID);
+  header_page.As<HeaderPage>()->InsertRecord(index_name_, directory_page_id);
+  directory_page_id_.store(directory_page_id);
+  return true;
+}
+
+/*
+ * Helper function to insert into a full bucket. Under the directory write
+ * latch the bucket of key is split, doubling the directory when it is at
+ * global depth, until the key fits; all entries may land on the same side of
+ * a split. Once the bucket is at DIRECTORY_MAX_DEPTH the key goes to its
+ * overflow pages.
+ * @return: false if the key exists or the buffer pool is out of frames
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool EXTENDIBLE_HASH_TABLE_TYPE::SplitInsert(const KeyType &key,
+                                             const ValueType &value) {
+  WritePageGuard directory_page =
+      buffer_pool_manager_->FetchPageWrite(directory_page_id_.load());
+  auto directory =
+      reinterpret_cast<HashTableDirectoryPage *>(directory_page.GetData());
+  uint32_t hash = Hash(key);
+  while (true) {
+    uint32_t slot = directory->GetSlot(hash);
+    page_id_t bucket_page_id = directory->GetBucketPageId(slot);
+    WritePageGuard bucket_page =
+        buffer_pool_manager_->FetchPageWrite(bucket_page_id);
+    auto bucket =
+        reinterpret_cast<HASH_TABLE_BUCKET_PAGE_TYPE *>(bucket_page.GetData());
+    ValueType existing;
+    if (ChainLookup(bucket, key, existing)) {
+      bucket_page.SetDirty(false);
+      directory_page.SetDirty(false);
+      return false;
+    }
+    if (bucket->Insert(key, value, comparator_))
+      return true;
+
+    uint32_t local_depth = directory->GetLocalDepth(slot);
+    if (local_depth == DIRECTORY_MAX_DEPTH)
+      return ChainInsert(bucket, key, value);
+    if (local_depth == directory->GetGlobalDepth())
+      directory->IncrGlobalDepth();
+    page_id_t image_page_id;
+    WritePageGuard image_page =
+        buffer_pool_manager_->NewPageGuarded(image_page_id);
+    if (!image_page)
+      return false;
+    auto image =
+        reinterpret_cast<HASH_TABLE_BUCKET_PAGE_TYPE *>(image_page.GetData());
+    image->Init();
+
+    // entries whose new distinguishing bit is set move to the image
+    uint32_t high_bit = 1u << local_depth;
+    for (int i = bucket->GetSize() - 1; i >= 0; i--) {
+      KeyType bucket_key = bucket->KeyAt(i);
+      if (Hash(bucket_key) & high_bit) {
+        image->Insert(bucket_key, bucket->ValueAt(i), comparator_);
+        bucket->RemoveAt(i);
+      }
+    }
+    for (uint32_t i = 0; i < directory->GetSize(); i++) {
+      if (directory->GetBucketPageId(i) != bucket_page_id)
+        continue;
+      directory->SetLocalDepth(i, local_depth + 1);
+      if (i & high_bit)
+        directory->SetBucketPageId(i, image_page_id);
+    }
+  }
+}
+
+/*****************************************************************************
+ * REMOVE
+ *****************************************************************************/
+/*
+ * Delete key & value pair associated with input key. A bucket that empties
+ * out is merged with its split image.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void EXTENDIBLE_HASH_TABLE_TYPE::Remove(const KeyType &key,
+                                        Transaction *transaction) {
+  page_id_t directory_page_id = directory_page_id_.load();
+  if (directory_page_id == INVALID_PAGE_ID)
+    return;
+  bool merge;
+  {
+    ReadPageGuard directory_page =
+        buffer_pool_manager_->FetchPageRead(directory_page_id);
+    auto directory =
+        reinterpret_cast<HashTableDirectoryPage *>(directory_page.GetData());
+    uint32_t slot = directory->GetSlot(Hash(key));
+    WritePageGuard bucket_page =
+        buffer_pool_manager_->FetchPageWrite(directory->GetBucketPageId(slot));
+    auto bucket =
+        reinterpret_cast<HASH_TABLE_BUCKET_PAGE_TYPE *>(bucket_page.GetData());
+    if (!ChainRemove(bucket, key)) {
+      bucket_page.SetDirty(false);
+      return;
+    }
+    merge = bucket->IsEmpty() && directory->GetLocalDepth(slot) > 0;
+  }
+  if (merge)
+    Merge(key);
+}
+
+/*
+ * Helper function to fold the empty bucket of key into its split image for
+ * as long as both share a local depth, then halve the directory while no
+ * bucket needs its full depth. The emptiness is checked again, an insert may
+ * have come in between.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void EXTENDIBLE_HASH_TABLE_TYPE::Merge(const KeyType &key) {
+  WritePageGuard directory_page =
+      buffer_pool_manager_->FetchPageWrite(directory_page_id_.load());
+  auto directory =
+      reinterpret_cast<HashTableDirectoryPage *>(directory_page.GetData());
+  uint32_t hash = Hash(key);
+  bool merged = false;
+  while (true) {
+    uint32_t slot = directory->GetSlot(hash);
+    uint32_t local_depth = directory->GetLocalDepth(slot);
+    uint32_t image_slot = directory->GetSplitImageSlot(slot);
+    if (local_depth == 0 || directory->GetLocalDepth(image_slot) != local_depth)
+      break;
+    page_id_t bucket_page_id = directory->GetBucketPageId(slot);
+    page_id_t image_page_id = directory->GetBucketPageId(image_slot);
+    {
+      ReadPageGuard bucket_page =
+          buffer_pool_manager_->FetchPageRead(bucket_page_id);
+      if (!reinterpret_cast<HASH_TABLE_BUCKET_PAGE_TYPE *>(
+               bucket_page.GetData())
+               ->IsEmpty())
+        break;
+      // a bucket with overflow pages must not drop below the maximum depth,
+      // a later split would leave its overflow entries behind
+      ReadPageGuard image_page =
+          buffer_pool_manager_->FetchPageRead(image_page_id);
+      if (reinterpret_cast<HASH_TABLE_BUCKET_PAGE_TYPE *>(image_page.GetData())
+              ->GetNextPageId() != INVALID_PAGE_ID)
+        break;
+    }
+    for (uint32_t i = 0; i < directory->GetSize(); i++) {
+      page_id_t page_id = directory->GetBucketPageId(i);
+      if (page_id != bucket_page_id && page_id != image_page_id)
+        continue;
+      directory->SetBucketPageId(i, image_page_id);
+      directory->SetLocalDepth(i, local_depth - 1);
+    }
+    buffer_pool_manager_->DeletePage(bucket_page_id);
+    merged = true;
+
+    // continue with the image if it is empty as well
+    ReadPageGuard image_page =
+        buffer_pool_manager_->FetchPageRead(image_page_id);
+    if (!reinterpret_cast<HASH_TABLE_BUCKET_PAGE_TYPE *>(image_page.GetData())
+             ->IsEmpty())
+      break;
+  }
+  while (directory->CanShrink()) {
+    directory->DecrGlobalDepth();
+    merged = true;
+  }
+  directory_page.SetDirty(merged);
+}
+
+/*****************************************************************************
+ * OVERFLOW PAGES
+ *****************************************************************************/
+/*
+ * Helper function to look key up in bucket and its overflow pages. Overflow
+ * pages are only ever accessed under the latch of their bucket.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool EXTENDIBLE_HASH_TABLE_TYPE::ChainLookup(
+    const HASH_TABLE_BUCKET_PAGE_TYPE *bucket, const KeyType &key,
+    ValueType &value) {
+  if (bucket->Lookup(key, value, comparator_))
+    return true;
+  page_id_t next_page_id = bucket->GetNextPageId();
+  while (next_page_id != INVALID_PAGE_ID) {
+    ReadPageGuard overflow_page =
+        buffer_pool_manager_->FetchPageRead(next_page_id);
+    auto overflow = reinterpret_cast<HASH_TABLE_BUCKET_PAGE_TYPE *>(
+        overflow_page.GetData());
+    if (overflow->Lookup(key, value, comparator_))
+      return true;
+    next_page_id = overflow->GetNextPageId();
+  }
+  return false;
+}
+
+/*
+ * Helper function to add key to the overflow pages of a full bucket that
+ * cannot split any further. All pages of a chain but the last one are full,
+ * a new overflow page is appended once the last one is full as well.
+ * @return: false if the buffer pool is out of frames
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool EXTENDIBLE_HASH_TABLE_TYPE::ChainInsert(
+    HASH_TABLE_BUCKET_PAGE_TYPE *bucket, const KeyType &key,
+    const ValueType &value) {
+  WritePageGuard last_page;
+  HASH_TABLE_BUCKET_PAGE_TYPE *last = bucket;
+  while (last->GetNextPageId() != INVALID_PAGE_ID) {
+    last_page.SetDirty(false);
+    last_page = buffer_pool_manager_->FetchPageWrite(last->GetNextPageId());
+    last = reinterpret_cast<HASH_TABLE_BUCKET_PAGE_TYPE *>(last_page.GetData());
+  }
+  if (last->Insert(key, value, comparator_))
+    return true;
+
+  page_id_t overflow_page_id;
+  WritePageGuard overflow_page =
+      buffer_pool_manager_->NewPageGuarded(overflow_page_id);
+  if (!overflow_page) {
+    last_page.SetDirty(false);
+    return false;
+  }
+  auto overflow =
+      reinterpret_cast<HASH_TABLE_BUCKET_PAGE_TYPE *>(overflow_page.GetData());
+  overflow->Init();
+  overflow->Insert(key, value, comparator_);
+  last->SetNextPageId(overflow_page_id);
+  return true;
+}
+
+/*
+ * Helper function to remove key from bucket or its overflow pages. The gap
+ * is filled with the last entry of the chain and an overflow page that
+ * empties is dropped, so the bucket itself only empties with its chain.
+ * @return: false if key is not there
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool EXTENDIBLE_HASH_TABLE_TYPE::ChainRemove(
+    HASH_TABLE_BUCKET_PAGE_TYPE *bucket, const KeyType &key) {
+  if (bucket->GetNextPageId() == INVALID_PAGE_ID)
+    return bucket->Remove(key, comparator_);
+
+  std::vector<WritePageGuard> overflow_pages;
+  std::vector<HASH_TABLE_BUCKET_PAGE_TYPE *> chain(1, bucket);
+  for (page_id_t next_page_id = bucket->GetNextPageId();
+       next_page_id != INVALID_PAGE_ID;
+       next_page_id = chain.back()->GetNextPageId()) {
+    overflow_pages.push_back(
+        buffer_pool_manager_->FetchPageWrite(next_page_id));
+    chain.push_back(reinterpret_cast<HASH_TABLE_BUCKET_PAGE_TYPE *>(
+        overflow_pages.back().GetData()));
+  }
+  size_t index = 0;
+  while (index < chain.size() && !chain[index]->Remove(key, comparator_))
+    index++;
+  if (index == chain.size()) {
+    for (auto &overflow_page : overflow_pages)
+      overflow_page.SetDirty(false);
+    return false;
+  }
+
+  HASH_TABLE_BUCKET_PAGE_TYPE *last = chain.back();
+  if (index + 1 < chain.size()) {
+    int last_index = last->GetSize() - 1;
+    chain[index]->Insert(last->KeyAt(last_index), last->ValueAt(last_index),
+                         comparator_);
+    last->RemoveAt(last_index);
+  }
+  if (last->IsEmpty()) {
+    HASH_TABLE_BUCKET_PAGE_TYPE *previous = chain[chain.size() - 2];
+    page_id_t last_page_id = previous->GetNextPageId();
+    previous->SetNextPageId(INVALID_PAGE_ID);
+    overflow_pages.back().SetDirty(false);
+    overflow_pages.back().Release();
+    buffer_pool_manager_->DeletePage(last_page_id);
+  }
+  return true;
+}
+
+/*****************************************************************************
+ * UTILITIES AND DEBUG
+ *****************************************************************************/
+INDEX_TEMPLATE_ARGUMENTS
+page_id_t EXTENDIBLE_HASH_TABLE_TYPE::GetDirectoryPageId() const {
+  return directory_page_id_.load();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+uint32_t EXTENDIBLE_HASH_TABLE_TYPE::GetGlobalDepth() {
+  page_id_t directory_page_id = directory_page_id_.load();
+  if (directory_page_id == INVALID_PAGE_ID)
+    return 0;
+  ReadPageGuard directory_page =
+      buffer_pool_manager_->FetchPageRead(directory_page_id);
+  return reinterpret_cast<HashTableDirectoryPage *>(directory_page.GetData())
+      ->GetGlobalDepth();
+}
+
+/*
+ * Helper function to hash the key bytes, FNV-1a followed by the murmur3
+ * finalizer so that the low bits the directory uses are well mixed
+ */
+INDEX_TEMPLATE_ARGUMENTS
+uint32_t EXTENDIBLE_HASH_TABLE_TYPE::Hash(const KeyType &key) const {
+  const unsigned char *data = reinterpret_cast<const unsigned char *>(&key);
+  uint32_t hash = 2166136261u;
+  for (size_t i = 0; i < sizeof(KeyType); i++) {
+    hash ^= data[i];
+    hash *= 16777619u;
+  }
+  hash ^= hash >> 16;
+  hash *= 0x85ebca6bu;
+  hash ^= hash >> 13;
+  hash *= 0xc2b2ae35u;
+  hash ^= hash >> 16;
+  return hash;
+}
+
+template class ExtendibleHashTable<GenericKey<4>, RID, GenericComparator<4>>;
+template class ExtendibleHashTable<GenericKey<8>, RID, GenericComparator<8>>;
+template class ExtendibleHashTable<GenericKey<16>, RID, GenericComparator<16>>;
+template class ExtendibleHashTable<GenericKey<32>, RID, GenericComparator<32>>;
+template class ExtendibleHashTable<GenericKey<64>, RID, GenericComparator<64>>;
+
+} // namespace cmudb
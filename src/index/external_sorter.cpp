@@ -0,0 +1,143 @@
+/**
+ * external_sorter.cpp
+ */
+#include <algorithm>
+#include <cassert>
+
+#include "common/exception.h"
+#include "common/rid.h"
+#include "index/external_sorter.h"
+
+namespace cmudb {
+
+INDEX_TEMPLATE_ARGUMENTS
+EXTERNAL_SORTER_TYPE::ExternalSorter(const KeyComparator &comparator,
+                                     size_t run_size)
+    : comparator_(comparator), run_size_(std::max<size_t>(run_size, 1)),
+      run_position_(0), reading_(false) {}
+
+INDEX_TEMPLATE_ARGUMENTS
+EXTERNAL_SORTER_TYPE::~ExternalSorter() {
+  // temporary files are removed once they are closed
+  for (auto *file : run_files_)
+    std::fclose(file);
+}
+
+/*
+ * Add key & value pair, the collected run is spilled once it is full
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void EXTERNAL_SORTER_TYPE::Add(const KeyType &key, const ValueType &value) {
+  assert(!reading_);
+  run_.push_back(MappingType(key, value));
+  if (run_.size() >= run_size_)
+    SpillRun();
+}
+
+/*
+ * Return the next key & value pair in ascending key order, pairs with equal
+ * keys come in no particular order
+ * @return: false once all pairs were read
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool EXTERNAL_SORTER_TYPE::Next(KeyType &key, ValueType &value) {
+  if (!reading_) {
+    reading_ = true;
+    if (run_files_.empty())
+      SortRun();
+    else
+      StartMerge();
+  }
+  if (run_files_.empty()) {
+    if (run_position_ == run_.size())
+      return false;
+    key = run_[run_position_].first;
+    value = run_[run_position_].second;
+    run_position_++;
+    return true;
+  }
+
+  // the heap keeps the smallest key last after popping
+  auto greater = [this](const std::pair<MappingType, size_t> &left,
+                        const std::pair<MappingType, size_t> &right) {
+    return comparator_(left.first.first, right.first.first) > 0;
+  };
+  if (heads_.empty())
+    return false;
+  std::pop_heap(heads_.begin(), heads_.end(), greater);
+  key = heads_.back().first.first;
+  value = heads_.back().first.second;
+  // refill from the run the pair came from
+  if (ReadPair(heads_.back().second, heads_.back().first))
+    std::push_heap(heads_.begin(), heads_.end(), greater);
+  else
+    heads_.pop_back();
+  return true;
+}
+
+/*
+ * Helper function to sort the collected run in memory
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void EXTERNAL_SORTER_TYPE::SortRun() {
+  std::sort(run_.begin(), run_.end(),
+            [this](const MappingType &left, const MappingType &right) {
+              return comparator_(left.first, right.first) < 0;
+            });
+}
+
+/*
+ * Helper function to sort the collected run and write it to a new temporary
+ * file in one go
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void EXTERNAL_SORTER_TYPE::SpillRun() {
+  SortRun();
+  std::FILE *file = std::tmpfile();
+  if (file == nullptr)
+    throw Exception(EXCEPTION_TYPE_INDEX, "cannot create a sort run file");
+  run_files_.push_back(file);
+  if (std::fwrite(run_.data(), sizeof(MappingType), run_.size(), file) !=
+      run_.size())
+    throw Exception(EXCEPTION_TYPE_INDEX, "cannot write a sort run file");
+  run_.clear();
+}
+
+/*
+ * Helper function to spill what is left and read the first pair of every run
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void EXTERNAL_SORTER_TYPE::StartMerge() {
+  if (!run_.empty())
+    SpillRun();
+  run_.shrink_to_fit();
+  MappingType pair;
+  for (size_t run = 0; run < run_files_.size(); run++) {
+    std::rewind(run_files_[run]);
+    if (ReadPair(run, pair))
+      heads_.push_back(std::make_pair(pair, run));
+  }
+  std::make_heap(heads_.begin(), heads_.end(),
+                 [this](const std::pair<MappingType, size_t> &left,
+                        const std::pair<MappingType, size_t> &right) {
+                   return comparator_(left.first.first, right.first.first) > 0;
+                 });
+}
+
+/*
+ * Helper function to read the next pair of a spilled run, the file buffers
+ * keep the reads sequential
+ * @return: false if the run is exhausted
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool EXTERNAL_SORTER_TYPE::ReadPair(size_t run, MappingType &pair) {
+  return std::fread(&pair, sizeof(MappingType), 1, run_files_[run]) == 1;
+}
+
+template class ExternalSorter<GenericKey<4>, RID, GenericComparator<4>>;
+template class ExternalSorter<GenericKey<8>, RID, GenericComparator<8>>;
+template class ExternalSorter<GenericKey<16>, RID, GenericComparator<16>>;
+template class ExternalSorter<GenericKey<32>, RID, GenericComparator<32>>;
+template class ExternalSorter<GenericKey<64>, RID, GenericComparator<64>>;
+
+} // namespace cmudb
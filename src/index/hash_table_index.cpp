@@ -0,0 +1,69 @@
+/**
+ * hash_table_index.cpp
+ */
+
+#include "common/exception.h"
+#include "index/hash_table_index.h"
+
+namespace cmudb {
+/*
+ * Constructor
+ */
+INDEX_TEMPLATE_ARGUMENTS
+HASH_TABLE_INDEX_TYPE::HashTableIndex(IndexMetadata *metadata,
+                                      BufferPoolManager *buffer_pool_manager,
+                                      page_id_t directory_page_id)
+    : Index(metadata), comparator_(metadata->GetKeySchema(), true),
+      container_(metadata->GetName(), buffer_pool_manager, comparator_,
+                 directory_page_id) {}
+
+INDEX_TEMPLATE_ARGUMENTS
+void HASH_TABLE_INDEX_TYPE::InsertEntry(const Tuple &key, RID rid,
+                                        Transaction *transaction) {
+  // construct insert index key
+  KeyType index_key;
+  index_key.SetFromKey(key, GetKeySchema());
+
+  // a duplicate key is ignored like in the b+ tree index, anything else
+  // would drop the entry silently
+  if (!container_.Insert(index_key, rid, transaction)) {
+    std::vector<RID> result;
+    if (!container_.GetValue(index_key, result, transaction))
+      throw Exception(EXCEPTION_TYPE_INDEX, "out of memory");
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void HASH_TABLE_INDEX_TYPE::DeleteEntry(const Tuple &key,
+                                        Transaction *transaction) {
+  // construct delete index key
+  KeyType index_key;
+  index_key.SetFromKey(key, GetKeySchema());
+
+  container_.Remove(index_key, transaction);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void HASH_TABLE_INDEX_TYPE::ScanKey(const Tuple &key, std::vector<RID> &result,
+                                    Transaction *transaction) {
+  // construct scan index key
+  KeyType index_key;
+  index_key.SetFromKey(key, GetKeySchema());
+
+  container_.GetValue(index_key, result, transaction);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void HASH_TABLE_INDEX_TYPE::ScanRange(const ScanBound &, const ScanBound &,
+                                      std::vector<RID> &, Transaction *) {
+  throw Exception(EXCEPTION_TYPE_NOT_IMPLEMENTED,
+                  "hash table indexes do not support range scans");
+}
+
+template class HashTableIndex<GenericKey<4>, RID, GenericComparator<4>>;
+template class HashTableIndex<GenericKey<8>, RID, GenericComparator<8>>;
+template class HashTableIndex<GenericKey<16>, RID, GenericComparator<16>>;
+template class HashTableIndex<GenericKey<32>, RID, GenericComparator<32>>;
+template class HashTableIndex<GenericKey<64>, RID, GenericComparator<64>>;
+
+} // namespace cmudb
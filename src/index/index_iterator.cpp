@@ -3,19 +3,89 @@
  */
 #include <cassert>
 
+#include "common/exception.h"
 #include "index/index_iterator.h"
 
 namespace cmudb {
 
+INDEX_TEMPLATE_ARGUMENTS
+INDEXITERATOR_TYPE::IndexIterator(BufferPoolManager *buffer_pool_manager,
+                                  ReadPageGuard leaf, int index,
+                                  const KeyComparator &comparator,
+                                  const KeyType *end_key)
+    : buffer_pool_manager_(buffer_pool_manager),
+      leaf_guard_(std::move(leaf)), leaf_(nullptr), index_(index),
+      comparator_(comparator), bounded_(end_key != nullptr) {
+  if (bounded_)
+    end_key_ = *end_key;
+  if (leaf_guard_.GetPage() != nullptr) {
+    leaf_ =
+        reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(leaf_guard_.GetData());
+    PrefetchNextLeaf();
+    SkipExhaustedLeaves();
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+INDEXITERATOR_TYPE::~IndexIterator() {}
+
+INDEX_TEMPLATE_ARGUMENTS
+bool INDEXITERATOR_TYPE::isEnd() { return leaf_ == nullptr; }
+
+INDEX_TEMPLATE_ARGUMENTS
+const MappingType &INDEXITERATOR_TYPE::operator*() {
+  assert(!isEnd());
+  item_ = leaf_->GetItem(index_);
+  return item_;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+INDEXITERATOR_TYPE &INDEXITERATOR_TYPE::operator++() {
+  assert(!isEnd());
+  index_++;
+  SkipExhaustedLeaves();
+  return *this;
+}
+
 /*
- * NOTE: you can change the destructor/constructor method here
- * set your own input parameters
+ * Helper function to move on to the next leaf that has an entry left, the
+ * iterator is at the end when there is none or the entry is past the end key
  */
 INDEX_TEMPLATE_ARGUMENTS
-INDEXITERATOR_TYPE::IndexIterator() {}
+void INDEXITERATOR_TYPE::SkipExhaustedLeaves() {
+  while (index_ >= leaf_->GetSize() ||
+         (bounded_ && comparator_(leaf_->KeyAt(index_), end_key_) >= 0)) {
+    page_id_t next_page_id = leaf_->GetNextPageId();
+    // the range may end before the next leaf already
+    if (next_page_id == INVALID_PAGE_ID || index_ < leaf_->GetSize() ||
+        (bounded_ && comparator_(leaf_->GetHighKey(), end_key_) >= 0)) {
+      leaf_guard_.Release();
+      leaf_ = nullptr;
+      return;
+    }
+    ReadPageGuard next = buffer_pool_manager_->FetchPageRead(next_page_id);
+    if (next.GetPage() == nullptr)
+      throw Exception(EXCEPTION_TYPE_INDEX, "out of memory");
+    leaf_guard_ = std::move(next);
+    leaf_ =
+        reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(leaf_guard_.GetData());
+    index_ = 0;
+    PrefetchNextLeaf();
+  }
+}
 
+/*
+ * Helper function to start reading the leaf after the current one, unless
+ * the range ends in the current one
+ */
 INDEX_TEMPLATE_ARGUMENTS
-INDEXITERATOR_TYPE::~IndexIterator() {}
+void INDEXITERATOR_TYPE::PrefetchNextLeaf() {
+  page_id_t next_page_id = leaf_->GetNextPageId();
+  if (next_page_id == INVALID_PAGE_ID ||
+      (bounded_ && comparator_(leaf_->GetHighKey(), end_key_) >= 0))
+    return;
+  buffer_pool_manager_->Prefetch(next_page_id);
+}
 
 template class IndexIterator<GenericKey<4>, RID, GenericComparator<4>>;
 template class IndexIterator<GenericKey<8>, RID, GenericComparator<8>>;
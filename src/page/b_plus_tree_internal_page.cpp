@@ -1,6 +1,8 @@
 /**
  * b_plus_tree_internal_page.cpp
  */
+#include <algorithm>
+#include <cstring>
 #include <iostream>
 #include <sstream>
 
@@ -14,24 +16,50 @@ namespace cmudb {
 /*
  * Init method after creating a new internal page
  * Including set page type, set current size, set page id, set parent id and set
- * max page size
+ * max page size. The page starts out right above the leaves and as the
+ * rightmost page of its level.
  */
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE_TYPE::Init(page_id_t page_id,
-                                          page_id_t parent_id) {}
+                                          page_id_t parent_id, int max_size) {
+  SetPageType(IndexPageType::INTERNAL_PAGE);
+  SetSize(0);
+  SetPageId(page_id);
+  SetParentPageId(parent_id);
+  SetMaxSize(max_size);
+  SetLevel(1);
+  SetNextPageId(INVALID_PAGE_ID);
+  prefix_size_ = 0;
+  key_offset_ = PAGE_SIZE;
+}
 /*
  * Helper method to get/set the key associated with input "index"(a.k.a
  * array offset)
  */
 INDEX_TEMPLATE_ARGUMENTS
 KeyType B_PLUS_TREE_INTERNAL_PAGE_TYPE::KeyAt(int index) const {
-  // replace with your own code
+  assert(index >= 0 && index < GetSize());
   KeyType key;
+  char *data = reinterpret_cast<char *>(&key);
+  const char *page = reinterpret_cast<const char *>(this);
+  memcpy(data, page + PAGE_SIZE - prefix_size_, prefix_size_);
+  memcpy(data + prefix_size_, page + slots_[index].key_offset,
+         slots_[index].key_size);
+  memset(data + prefix_size_ + slots_[index].key_size, 0,
+         sizeof(KeyType) - prefix_size_ - slots_[index].key_size);
   return key;
 }
 
+/*
+ * NOTE: the page must have room for key, see CanSetKeyAt()
+ */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_INTERNAL_PAGE_TYPE::SetKeyAt(int index, const KeyType &key) {}
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::SetKeyAt(int index, const KeyType &key) {
+  assert(index >= 0 && index < GetSize());
+  std::vector<MappingType> items = GetItems();
+  items[index].first = key;
+  SetItems(items);
+}
 
 /*
  * Helper method to find and return array index(or offset), so that its value
@@ -39,7 +67,11 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::SetKeyAt(int index, const KeyType &key) {}
  */
 INDEX_TEMPLATE_ARGUMENTS
 int B_PLUS_TREE_INTERNAL_PAGE_TYPE::ValueIndex(const ValueType &value) const {
-  return 0;
+  for (int i = 0; i < GetSize(); i++) {
+    if (slots_[i].value == value)
+      return i;
+  }
+  return -1;
 }
 
 /*
@@ -47,7 +79,261 @@ int B_PLUS_TREE_INTERNAL_PAGE_TYPE::ValueIndex(const ValueType &value) const {
  * offset)
  */
 INDEX_TEMPLATE_ARGUMENTS
-ValueType B_PLUS_TREE_INTERNAL_PAGE_TYPE::ValueAt(int index) const { return 0; }
+ValueType B_PLUS_TREE_INTERNAL_PAGE_TYPE::ValueAt(int index) const {
+  assert(index >= 0 && index < GetSize());
+  return slots_[index].value;
+}
+
+/*
+ * Helper methods to get/set the level, the right sibling and the high key
+ */
+INDEX_TEMPLATE_ARGUMENTS
+int B_PLUS_TREE_INTERNAL_PAGE_TYPE::GetLevel() const { return level_; }
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::SetLevel(int level) { level_ = level; }
+
+INDEX_TEMPLATE_ARGUMENTS
+page_id_t B_PLUS_TREE_INTERNAL_PAGE_TYPE::GetNextPageId() const {
+  return next_page_id_;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::SetNextPageId(page_id_t next_page_id) {
+  next_page_id_ = next_page_id;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+KeyType B_PLUS_TREE_INTERNAL_PAGE_TYPE::GetHighKey() const {
+  return high_key_;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::SetHighKey(const KeyType &key) {
+  high_key_ = key;
+}
+
+/*
+ * Helper method to decide whether key belongs to a page right of this one,
+ * i.e. this page split after its parent was read
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool B_PLUS_TREE_INTERNAL_PAGE_TYPE::IsBeyondHighKey(
+    const KeyType &key, const KeyComparator &comparator) const {
+  return next_page_id_ != INVALID_PAGE_ID &&
+         comparator(key, high_key_) >= 0;
+}
+
+/*
+ * Helper methods to decode all key & value pairs, and to store pairs in place
+ * of the current ones with the prefix they share factored out
+ */
+INDEX_TEMPLATE_ARGUMENTS
+std::vector<MappingType> B_PLUS_TREE_INTERNAL_PAGE_TYPE::GetItems() const {
+  std::vector<MappingType> items;
+  items.reserve(GetSize());
+  for (int i = 0; i < GetSize(); i++)
+    items.push_back(MappingType(KeyAt(i), slots_[i].value));
+  return items;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::SetItems(
+    const std::vector<MappingType> &items) {
+  assert(static_cast<int>(sizeof(BPlusTreeInternalPage)) + ItemsSize(items) <=
+         PAGE_SIZE);
+  int prefix_size = items.empty() ? 0 : static_cast<int>(sizeof(KeyType));
+  for (auto &item : items)
+    prefix_size =
+        std::min(prefix_size, PrefixSize(items[0].first, item.first));
+  char *page = reinterpret_cast<char *>(this);
+  int offset = PAGE_SIZE - prefix_size;
+  if (prefix_size > 0)
+    memcpy(page + offset, &items[0].first, prefix_size);
+  for (size_t i = 0; i < items.size(); i++) {
+    int size = StoredKeySize(items[i].first, prefix_size);
+    offset -= size;
+    memcpy(page + offset,
+           reinterpret_cast<const char *>(&items[i].first) + prefix_size, size);
+    slots_[i].value = items[i].second;
+    slots_[i].key_head = KeyHead(page + offset, size);
+    slots_[i].key_offset = static_cast<uint16_t>(offset);
+    slots_[i].key_size = static_cast<uint16_t>(size);
+  }
+  prefix_size_ = static_cast<uint16_t>(prefix_size);
+  key_offset_ = static_cast<uint16_t>(offset);
+  SetSize(static_cast<int>(items.size()));
+}
+
+/*
+ * Helper method to put key & value pair at index, in the free space if key
+ * starts with the prefix of the page
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::InsertAt(int index, const KeyType &key,
+                                              const ValueType &value) {
+  if (GetSize() == 0 || !SharesPrefix(key)) {
+    std::vector<MappingType> items = GetItems();
+    items.insert(items.begin() + index, MappingType(key, value));
+    SetItems(items);
+    return;
+  }
+  int size = StoredKeySize(key, prefix_size_);
+  assert(key_offset_ - size >=
+         static_cast<int>(sizeof(BPlusTreeInternalPage) +
+                          (GetSize() + 1) * sizeof(Slot)));
+  key_offset_ -= size;
+  memcpy(reinterpret_cast<char *>(this) + key_offset_,
+         reinterpret_cast<const char *>(&key) + prefix_size_, size);
+  std::copy_backward(slots_ + index, slots_ + GetSize(),
+                     slots_ + GetSize() + 1);
+  slots_[index].value = value;
+  slots_[index].key_head =
+      KeyHead(reinterpret_cast<char *>(this) + key_offset_, size);
+  slots_[index].key_offset = key_offset_;
+  slots_[index].key_size = static_cast<uint16_t>(size);
+  IncreaseSize(1);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+bool B_PLUS_TREE_INTERNAL_PAGE_TYPE::SharesPrefix(const KeyType &key) const {
+  return memcmp(&key,
+                reinterpret_cast<const char *>(this) + PAGE_SIZE -
+                    prefix_size_,
+                prefix_size_) == 0;
+}
+
+/*
+ * Helper methods to get the bytes used by slots and keys, the bytes the page
+ * has for them, and the bytes items would use
+ */
+INDEX_TEMPLATE_ARGUMENTS
+int B_PLUS_TREE_INTERNAL_PAGE_TYPE::GetUsedSize() const {
+  return PAGE_SIZE - key_offset_ + GetSize() * static_cast<int>(sizeof(Slot));
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+int B_PLUS_TREE_INTERNAL_PAGE_TYPE::GetCapacity() const {
+  return PAGE_SIZE - static_cast<int>(sizeof(BPlusTreeInternalPage));
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+int B_PLUS_TREE_INTERNAL_PAGE_TYPE::ItemsSize(
+    const std::vector<MappingType> &items) {
+  if (items.empty())
+    return 0;
+  int prefix_size = sizeof(KeyType);
+  for (auto &item : items)
+    prefix_size =
+        std::min(prefix_size, PrefixSize(items[0].first, item.first));
+  int size = prefix_size;
+  for (auto &item : items)
+    size += sizeof(Slot) + StoredKeySize(item.first, prefix_size);
+  return size;
+}
+
+/*
+ * Helper method to count the bytes two keys start with
+ */
+INDEX_TEMPLATE_ARGUMENTS
+int B_PLUS_TREE_INTERNAL_PAGE_TYPE::PrefixSize(const KeyType &left,
+                                               const KeyType &right) {
+  auto *left_data = reinterpret_cast<const char *>(&left);
+  auto *right_data = reinterpret_cast<const char *>(&right);
+  int size = 0;
+  while (size < static_cast<int>(sizeof(KeyType)) &&
+         left_data[size] == right_data[size])
+    size++;
+  return size;
+}
+
+/*
+ * Helper method to count the bytes of key kept after the prefix, trailing
+ * zero bytes are left out
+ */
+INDEX_TEMPLATE_ARGUMENTS
+int B_PLUS_TREE_INTERNAL_PAGE_TYPE::StoredKeySize(const KeyType &key,
+                                                  int prefix_size) {
+  auto *data = reinterpret_cast<const char *>(&key);
+  int end = sizeof(KeyType);
+  while (end > prefix_size && data[end - 1] == 0)
+    end--;
+  return end - prefix_size;
+}
+
+/*
+ * Helper method to read the first 4 of size key bytes as a big-endian
+ * integer, missing bytes are zero
+ */
+INDEX_TEMPLATE_ARGUMENTS
+uint32_t B_PLUS_TREE_INTERNAL_PAGE_TYPE::KeyHead(const char *data, int size) {
+  uint32_t head = 0;
+  for (int i = 0; i < static_cast<int>(sizeof(head)); i++)
+    head = head << 8 | (i < size ? static_cast<uint8_t>(data[i]) : 0);
+  return head;
+}
+
+/*****************************************************************************
+ * SPACE
+ *****************************************************************************/
+/*
+ * Decide whether one more child with key fits, a key without the prefix of
+ * the page makes every key longer. The page may go beyond its max size, it
+ * is split right after then.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool B_PLUS_TREE_INTERNAL_PAGE_TYPE::HasRoomFor(const KeyType &key) const {
+  auto *data = reinterpret_cast<const char *>(&key);
+  auto *prefix =
+      reinterpret_cast<const char *>(this) + PAGE_SIZE - prefix_size_;
+  int prefix_size = 0;
+  while (prefix_size < prefix_size_ &&
+         data[prefix_size] == prefix[prefix_size])
+    prefix_size++;
+  // every key grows by the bytes the prefix loses, at most
+  int size = GetUsedSize() + (prefix_size_ - prefix_size) * GetSize() +
+             static_cast<int>(sizeof(Slot)) + StoredKeySize(key, prefix_size);
+  return size <= GetCapacity();
+}
+
+/*
+ * Decide whether the key at index can be replaced by key
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool B_PLUS_TREE_INTERNAL_PAGE_TYPE::CanSetKeyAt(int index,
+                                                 const KeyType &key) const {
+  std::vector<MappingType> items = GetItems();
+  items[index].first = key;
+  return ItemsSize(items) <= GetCapacity();
+}
+
+/*
+ * Decide whether size pairs of a sibling fit into this page: the first ones
+ * if it is our right sibling, the last ones otherwise
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool B_PLUS_TREE_INTERNAL_PAGE_TYPE::CanMoveFrom(
+    const BPlusTreeInternalPage *sibling, int size) const {
+  if (GetSize() + size > GetMaxSize())
+    return false;
+  std::vector<MappingType> items = GetItems();
+  std::vector<MappingType> moved = sibling->GetItems();
+  if (sibling->GetPageId() == GetNextPageId())
+    items.insert(items.end(), moved.begin(), moved.begin() + size);
+  else
+    items.insert(items.begin(), moved.end() - size, moved.end());
+  return ItemsSize(items) <= GetCapacity();
+}
+
+/*
+ * A page is underfull with less than min size children that take less than
+ * half of the page. Pages are split in the middle, with keys of different
+ * length the halves are only about half full.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool B_PLUS_TREE_INTERNAL_PAGE_TYPE::IsUnderfull() const {
+  return GetSize() < GetMinSize() && 2 * GetUsedSize() < GetCapacity();
+}
 
 /*****************************************************************************
  * LOOKUP
@@ -61,7 +347,54 @@ INDEX_TEMPLATE_ARGUMENTS
 ValueType
 B_PLUS_TREE_INTERNAL_PAGE_TYPE::Lookup(const KeyType &key,
                                        const KeyComparator &comparator) const {
-  return INVALID_PAGE_ID;
+  if (comparator.IsNormalized())
+    return NormalizedLookup(key);
+  // find the last key that is not greater than key
+  int low = 1, high = GetSize() - 1;
+  while (low <= high) {
+    int mid = low + (high - low) / 2;
+    if (comparator(KeyAt(mid), key) <= 0)
+      low = mid + 1;
+    else
+      high = mid - 1;
+  }
+  return slots_[high].value;
+}
+
+/*
+ * Helper method to look up normalized keys, they compare bytewise. Key is
+ * compared with the prefix once and then with the key heads, key bytes are
+ * only read where the heads are equal.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+ValueType
+B_PLUS_TREE_INTERNAL_PAGE_TYPE::NormalizedLookup(const KeyType &key) const {
+  const char *page = reinterpret_cast<const char *>(this);
+  const char *data = reinterpret_cast<const char *>(&key);
+  int order = memcmp(data, page + PAGE_SIZE - prefix_size_, prefix_size_);
+  if (order != 0)
+    return slots_[order < 0 ? 0 : GetSize() - 1].value;
+  const char *rest = data + prefix_size_;
+  uint32_t head = KeyHead(rest, sizeof(KeyType) - prefix_size_);
+  int head_size = sizeof(head);
+  int low = 1, high = GetSize() - 1;
+  while (low <= high) {
+    int mid = low + (high - low) / 2;
+    const Slot &slot = slots_[mid];
+    // the bytes a key does not keep are zero, so equal heads of a short key
+    // mean it is not greater
+    bool not_greater =
+        slot.key_head != head
+            ? slot.key_head < head
+            : slot.key_size <= head_size ||
+                  memcmp(page + slot.key_offset + head_size, rest + head_size,
+                         slot.key_size - head_size) <= 0;
+    if (not_greater)
+      low = mid + 1;
+    else
+      high = mid - 1;
+  }
+  return slots_[high].value;
 }
 
 /*****************************************************************************
@@ -76,17 +409,24 @@ B_PLUS_TREE_INTERNAL_PAGE_TYPE::Lookup(const KeyType &key,
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE_TYPE::PopulateNewRoot(
     const ValueType &old_value, const KeyType &new_key,
-    const ValueType &new_value) {}
+    const ValueType &new_value) {
+  // the first key is not used, it does not cost the prefix either
+  SetItems({MappingType(new_key, old_value), MappingType(new_key, new_value)});
+}
 /*
  * Insert new_key & new_value pair right after the pair with its value ==
  * old_value
  * @return:  new size after insertion
+ * NOTE: the page must have room for new_key, see HasRoomFor()
  */
 INDEX_TEMPLATE_ARGUMENTS
 int B_PLUS_TREE_INTERNAL_PAGE_TYPE::InsertNodeAfter(
     const ValueType &old_value, const KeyType &new_key,
     const ValueType &new_value) {
-  return 0;
+  int index = ValueIndex(old_value) + 1;
+  assert(index > 0);
+  InsertAt(index, new_key, new_value);
+  return GetSize();
 }
 
 /*****************************************************************************
@@ -94,15 +434,44 @@ int B_PLUS_TREE_INTERNAL_PAGE_TYPE::InsertNodeAfter(
  *****************************************************************************/
 /*
  * Remove half of key & value pairs from this page to "recipient" page
+ * The recipient becomes the right sibling, the key of its first child is our
+ * new high key.
  */
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveHalfTo(
     BPlusTreeInternalPage *recipient,
-    BufferPoolManager *buffer_pool_manager) {}
+    BufferPoolManager *buffer_pool_manager) {
+  std::vector<MappingType> items = GetItems();
+  int keep = (GetSize() + 1) / 2;
+  recipient->SetItems(
+      std::vector<MappingType>(items.begin() + keep, items.end()));
+  for (int i = 0; i < recipient->GetSize(); i++)
+    recipient->AdoptChild(recipient->ValueAt(i), buffer_pool_manager);
+  items.resize(keep);
+  SetItems(items);
+  recipient->SetLevel(GetLevel());
+  recipient->SetNextPageId(GetNextPageId());
+  recipient->SetHighKey(GetHighKey());
+  SetNextPageId(recipient->GetPageId());
+  SetHighKey(recipient->KeyAt(0));
+}
 
+/*
+ * Helper function to point the parent page id of a moved child at this page.
+ * The child is only pinned, its parent page id is written by whoever holds
+ * the write latch of its parent. Splits do not wait for their parent, so
+ * the parent page id is only a hint apart from telling the root.
+ */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyHalfFrom(
-    MappingType *items, int size, BufferPoolManager *buffer_pool_manager) {}
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::AdoptChild(
+    page_id_t child_page_id, BufferPoolManager *buffer_pool_manager) {
+  auto *page = buffer_pool_manager->FetchPage(child_page_id);
+  if (page == nullptr)
+    throw Exception(EXCEPTION_TYPE_INDEX, "out of memory");
+  reinterpret_cast<BPlusTreePage *>(page->GetData())
+      ->SetParentPageId(GetPageId());
+  buffer_pool_manager->UnpinPage(child_page_id, true);
+}
 
 /*****************************************************************************
  * REMOVE
@@ -113,7 +482,12 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyHalfFrom(
  * NOTE: store key&value pair continuously after deletion
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_INTERNAL_PAGE_TYPE::Remove(int index) {}
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::Remove(int index) {
+  assert(index >= 0 && index < GetSize());
+  std::vector<MappingType> items = GetItems();
+  items.erase(items.begin() + index);
+  SetItems(items);
+}
 
 /*
  * Remove the only key & value pair in internal page and return the value
@@ -121,7 +495,10 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::Remove(int index) {}
  */
 INDEX_TEMPLATE_ARGUMENTS
 ValueType B_PLUS_TREE_INTERNAL_PAGE_TYPE::RemoveAndReturnOnlyChild() {
-  return INVALID_PAGE_ID;
+  assert(GetSize() == 1);
+  ValueType value = slots_[0].value;
+  SetItems({});
+  return value;
 }
 /*****************************************************************************
  * MERGE
@@ -129,15 +506,30 @@ ValueType B_PLUS_TREE_INTERNAL_PAGE_TYPE::RemoveAndReturnOnlyChild() {
 /*
  * Remove all of key & value pairs from this page to "recipient" page, then
  * update relavent key & value pair in its parent page.
+ * NOTE: the recipient must have room for them, see CanMoveFrom()
  */
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveAllTo(
     BPlusTreeInternalPage *recipient, int index_in_parent,
-    BufferPoolManager *buffer_pool_manager) {}
+    BufferPoolManager *buffer_pool_manager) {
+  // the separator in the parent becomes the key of our first child
+  auto *page = buffer_pool_manager->FetchPage(GetParentPageId());
+  if (page == nullptr)
+    throw Exception(EXCEPTION_TYPE_INDEX, "out of memory");
+  auto *parent = reinterpret_cast<BPlusTreeInternalPage *>(page->GetData());
+  std::vector<MappingType> items = GetItems();
+  items[0].first = parent->KeyAt(index_in_parent);
+  buffer_pool_manager->UnpinPage(parent->GetPageId(), false);
 
-INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyAllFrom(
-    MappingType *items, int size, BufferPoolManager *buffer_pool_manager) {}
+  std::vector<MappingType> recipient_items = recipient->GetItems();
+  recipient_items.insert(recipient_items.end(), items.begin(), items.end());
+  recipient->SetItems(recipient_items);
+  for (auto &item : items)
+    recipient->AdoptChild(item.second, buffer_pool_manager);
+  recipient->SetNextPageId(GetNextPageId());
+  recipient->SetHighKey(GetHighKey());
+  SetItems({});
+}
 
 /*****************************************************************************
  * REDISTRIBUTE
@@ -145,29 +537,128 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyAllFrom(
 /*
  * Remove the first key & value pair from this page to tail of "recipient"
  * page, then update relavent key & value pair in its parent page.
+ * NOTE: the recipient must have room for it and the parent for the new
+ * separator, see CanMoveFrom() and CanSetKeyAt()
  */
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveFirstToEndOf(
     BPlusTreeInternalPage *recipient,
-    BufferPoolManager *buffer_pool_manager) {}
+    BufferPoolManager *buffer_pool_manager) {
+  auto *page = buffer_pool_manager->FetchPage(GetParentPageId());
+  if (page == nullptr)
+    throw Exception(EXCEPTION_TYPE_INDEX, "out of memory");
+  auto *parent = reinterpret_cast<BPlusTreeInternalPage *>(page->GetData());
+  // our separator moves down with the first child, the next key moves up
+  int index = parent->ValueIndex(GetPageId());
+  MappingType pair(parent->KeyAt(index), slots_[0].value);
+  parent->SetKeyAt(index, KeyAt(1));
+  buffer_pool_manager->UnpinPage(parent->GetPageId(), true);
+
+  recipient->SetHighKey(KeyAt(1));
+  Remove(0);
+  recipient->CopyLastFrom(pair, buffer_pool_manager);
+}
 
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyLastFrom(
-    const MappingType &pair, BufferPoolManager *buffer_pool_manager) {}
+    const MappingType &pair, BufferPoolManager *buffer_pool_manager) {
+  InsertAt(GetSize(), pair.first, pair.second);
+  AdoptChild(pair.second, buffer_pool_manager);
+}
 
 /*
  * Remove the last key & value pair from this page to head of "recipient"
  * page, then update relavent key & value pair in its parent page.
+ * NOTE: see MoveFirstToEndOf()
  */
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveLastToFrontOf(
     BPlusTreeInternalPage *recipient, int parent_index,
-    BufferPoolManager *buffer_pool_manager) {}
+    BufferPoolManager *buffer_pool_manager) {
+  MappingType pair(KeyAt(GetSize() - 1), ValueAt(GetSize() - 1));
+  Remove(GetSize() - 1);
+  SetHighKey(pair.first);
+  recipient->CopyFirstFrom(pair, parent_index, buffer_pool_manager);
+}
 
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyFirstFrom(
     const MappingType &pair, int parent_index,
-    BufferPoolManager *buffer_pool_manager) {}
+    BufferPoolManager *buffer_pool_manager) {
+  auto *page = buffer_pool_manager->FetchPage(GetParentPageId());
+  if (page == nullptr)
+    throw Exception(EXCEPTION_TYPE_INDEX, "out of memory");
+  auto *parent = reinterpret_cast<BPlusTreeInternalPage *>(page->GetData());
+  // our separator moves down to the old first child, the key of the moved
+  // child moves up and stays our first key
+  std::vector<MappingType> items = GetItems();
+  items[0].first = parent->KeyAt(parent_index);
+  items.insert(items.begin(), pair);
+  parent->SetKeyAt(parent_index, pair.first);
+  buffer_pool_manager->UnpinPage(parent->GetPageId(), true);
+
+  SetItems(items);
+  AdoptChild(pair.second, buffer_pool_manager);
+}
+
+/*****************************************************************************
+ * BULK LOAD
+ *****************************************************************************/
+/*
+ * Append key & value pair behind the last one. The key of the first pair is
+ * kept as well, it is the separator of this page.
+ * NOTE: the page must have room for key, see HasRoomFor()
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::Append(const KeyType &key,
+                                            const ValueType &value) {
+  InsertAt(GetSize(), key, value);
+}
+
+/*
+ * Remove the last size key & value pairs from this page to head of
+ * "recipient", our right sibling, the first of them becomes our high key.
+ * Children keep their parent page id, it is only a hint.
+ * NOTE: only for pages built by a bulk load before they are linked into a
+ * parent, the first keys hold the separators of both pages then. The
+ * recipient must have room for them, see CanMoveFrom().
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveTailTo(
+    BPlusTreeInternalPage *recipient, int size) {
+  std::vector<MappingType> items = GetItems();
+  std::vector<MappingType> recipient_items = recipient->GetItems();
+  recipient_items.insert(recipient_items.begin(), items.end() - size,
+                         items.end());
+  recipient->SetItems(recipient_items);
+  items.resize(items.size() - size);
+  SetItems(items);
+  SetHighKey(recipient->KeyAt(0));
+}
+
+/*
+ * Remove the first size key & value pairs from this page to tail of
+ * "recipient", our left sibling. If this page is emptied, the recipient takes
+ * over our right sibling and high key.
+ * NOTE: only for pages built by a bulk load, see MoveTailTo()
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveHeadTo(
+    BPlusTreeInternalPage *recipient, int size) {
+  std::vector<MappingType> items = GetItems();
+  std::vector<MappingType> recipient_items = recipient->GetItems();
+  recipient_items.insert(recipient_items.end(), items.begin(),
+                         items.begin() + size);
+  recipient->SetItems(recipient_items);
+  items.erase(items.begin(), items.begin() + size);
+  SetItems(items);
+  if (GetSize() > 0) {
+    recipient->SetHighKey(KeyAt(0));
+    return;
+  }
+  recipient->SetNextPageId(GetNextPageId());
+  recipient->SetHighKey(GetHighKey());
+}
 
 /*****************************************************************************
  * DEBUG
@@ -177,7 +668,7 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::QueueUpChildren(
     std::queue<BPlusTreePage *> *queue,
     BufferPoolManager *buffer_pool_manager) {
   for (int i = 0; i < GetSize(); i++) {
-    auto *page = buffer_pool_manager->FetchPage(array[i].second);
+    auto *page = buffer_pool_manager->FetchPage(slots_[i].value);
     if (page == nullptr)
       throw Exception(EXCEPTION_TYPE_INDEX,
                       "all page are pinned while printing");
@@ -207,9 +698,9 @@ std::string B_PLUS_TREE_INTERNAL_PAGE_TYPE::ToString(bool verbose) const {
     } else {
       os << " ";
     }
-    os << std::dec << array[entry].first.ToString();
+    os << std::dec << KeyAt(entry).ToString();
     if (verbose) {
-      os << "(" << array[entry].second << ")";
+      os << "(" << slots_[entry].value << ")";
     }
     ++entry;
   }
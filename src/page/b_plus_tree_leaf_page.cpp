@@ -2,10 +2,16 @@
  * b_plus_tree_leaf_page.cpp
  */
 
+#include <algorithm>
+#include <cstring>
 #include <sstream>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
 
 #include "common/exception.h"
 #include "common/rid.h"
+#include "page/b_plus_tree_internal_page.h"
 #include "page/b_plus_tree_leaf_page.h"
 
 namespace cmudb {
@@ -20,27 +26,163 @@ namespace cmudb {
  * next page id and set max size
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE_TYPE::Init(page_id_t page_id, page_id_t parent_id) {}
+void B_PLUS_TREE_LEAF_PAGE_TYPE::Init(page_id_t page_id, page_id_t parent_id,
+                                      int max_size) {
+  SetPageType(IndexPageType::LEAF_PAGE);
+  SetSize(0);
+  SetPageId(page_id);
+  SetParentPageId(parent_id);
+  SetNextPageId(INVALID_PAGE_ID);
+  SetMaxSize(max_size);
+}
 
 /**
  * Helper methods to set/get next page id
  */
 INDEX_TEMPLATE_ARGUMENTS
 page_id_t B_PLUS_TREE_LEAF_PAGE_TYPE::GetNextPageId() const {
-  return INVALID_PAGE_ID;
+  return next_page_id_;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_LEAF_PAGE_TYPE::SetNextPageId(page_id_t next_page_id) {
+  next_page_id_ = next_page_id;
+}
+
+/**
+ * Helper methods to set/get the high key
+ */
+INDEX_TEMPLATE_ARGUMENTS
+KeyType B_PLUS_TREE_LEAF_PAGE_TYPE::GetHighKey() const { return high_key_; }
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_LEAF_PAGE_TYPE::SetHighKey(const KeyType &key) {
+  high_key_ = key;
 }
 
+/**
+ * Helper method to decide whether key belongs to a leaf right of this one,
+ * i.e. this leaf split after its parent was read
+ */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE_TYPE::SetNextPageId(page_id_t next_page_id) {}
+bool B_PLUS_TREE_LEAF_PAGE_TYPE::IsBeyondHighKey(
+    const KeyType &key, const KeyComparator &comparator) const {
+  return next_page_id_ != INVALID_PAGE_ID &&
+         comparator(key, high_key_) >= 0;
+}
 
 /**
- * Helper method to find the first index i so that array[i].first >= key
- * NOTE: This method is only used when generating index iterator
+ * Helper method to find the first index i so that keys_[i] >= key
  */
 INDEX_TEMPLATE_ARGUMENTS
 int B_PLUS_TREE_LEAF_PAGE_TYPE::KeyIndex(
     const KeyType &key, const KeyComparator &comparator) const {
-  return 0;
+  if (comparator.IsNormalized() &&
+      (sizeof(KeyType) == sizeof(uint32_t) ||
+       sizeof(KeyType) == sizeof(uint64_t)))
+    return NormalizedKeyIndex(key);
+  int low = 0, high = GetSize();
+  while (low < high) {
+    int mid = low + (high - low) / 2;
+    if (comparator(keys_[mid], key) < 0)
+      low = mid + 1;
+    else
+      high = mid;
+  }
+  return low;
+}
+
+namespace {
+/*
+ * Helper functions to read a normalized key of 4 or 8 bytes as the integer it
+ * compares like
+ */
+inline uint32_t LoadKey32(const char *data) {
+  uint32_t value;
+  memcpy(&value, data, sizeof(value));
+  return __builtin_bswap32(value);
+}
+
+inline uint64_t LoadKey64(const char *data) {
+  uint64_t value;
+  memcpy(&value, data, sizeof(value));
+  return __builtin_bswap64(value);
+}
+
+/*
+ * Helper functions to count the normalized keys less than needle, the keys
+ * are compared 8 or 4 at a time
+ */
+int CountLess32(const char *keys, int size, uint32_t needle) {
+  int count = 0, i = 0;
+#if defined(__AVX2__)
+  // reverse the bytes of every key, flip the sign bit for a signed compare
+  const __m256i reverse = _mm256_setr_epi8(
+      3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12, 3, 2, 1, 0, 7, 6,
+      5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+  const __m256i sign = _mm256_set1_epi32(INT32_MIN);
+  const __m256i target =
+      _mm256_set1_epi32(static_cast<int32_t>(needle ^ 0x80000000u));
+  for (; i + 8 <= size; i += 8) {
+    __m256i chunk = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i *>(keys + i * sizeof(uint32_t)));
+    chunk = _mm256_xor_si256(_mm256_shuffle_epi8(chunk, reverse), sign);
+    count += __builtin_popcount(_mm256_movemask_ps(
+        _mm256_castsi256_ps(_mm256_cmpgt_epi32(target, chunk))));
+  }
+#endif
+  for (; i < size; i++)
+    count += LoadKey32(keys + i * sizeof(uint32_t)) < needle;
+  return count;
+}
+
+int CountLess64(const char *keys, int size, uint64_t needle) {
+  int count = 0, i = 0;
+#if defined(__AVX2__)
+  const __m256i reverse = _mm256_setr_epi8(
+      7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2,
+      1, 0, 15, 14, 13, 12, 11, 10, 9, 8);
+  const __m256i sign = _mm256_set1_epi64x(INT64_MIN);
+  const __m256i target = _mm256_set1_epi64x(
+      static_cast<int64_t>(needle ^ UINT64_C(0x8000000000000000)));
+  for (; i + 4 <= size; i += 4) {
+    __m256i chunk = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i *>(keys + i * sizeof(uint64_t)));
+    chunk = _mm256_xor_si256(_mm256_shuffle_epi8(chunk, reverse), sign);
+    count += __builtin_popcount(_mm256_movemask_pd(
+        _mm256_castsi256_pd(_mm256_cmpgt_epi64(target, chunk))));
+  }
+#endif
+  for (; i < size; i++)
+    count += LoadKey64(keys + i * sizeof(uint64_t)) < needle;
+  return count;
+}
+} // namespace
+
+/*
+ * Helper method to find the first index i so that keys_[i] >= key, for
+ * normalized keys of 4 or 8 bytes. A binary search narrows the keys down to
+ * a window, the keys less than key in there are counted at once.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+int B_PLUS_TREE_LEAF_PAGE_TYPE::NormalizedKeyIndex(const KeyType &key) const {
+  const char *keys = reinterpret_cast<const char *>(keys_);
+  const char *data = reinterpret_cast<const char *>(&key);
+  bool wide = sizeof(KeyType) == sizeof(uint64_t);
+  uint64_t needle = wide ? LoadKey64(data) : LoadKey32(data);
+  int low = 0, high = GetSize();
+  while (high - low > KEY_SEARCH_WINDOW) {
+    int mid = low + (high - low) / 2;
+    const char *probe = keys + mid * sizeof(KeyType);
+    if ((wide ? LoadKey64(probe) : LoadKey32(probe)) < needle)
+      low = mid + 1;
+    else
+      high = mid;
+  }
+  const char *window = keys + low * sizeof(KeyType);
+  if (wide)
+    return low + CountLess64(window, high - low, needle);
+  return low + CountLess32(window, high - low, static_cast<uint32_t>(needle));
 }
 
 /*
@@ -49,9 +191,8 @@ int B_PLUS_TREE_LEAF_PAGE_TYPE::KeyIndex(
  */
 INDEX_TEMPLATE_ARGUMENTS
 KeyType B_PLUS_TREE_LEAF_PAGE_TYPE::KeyAt(int index) const {
-  // replace with your own code
-  KeyType key;
-  return key;
+  assert(index >= 0 && index < GetSize());
+  return keys_[index];
 }
 
 /*
@@ -59,9 +200,46 @@ KeyType B_PLUS_TREE_LEAF_PAGE_TYPE::KeyAt(int index) const {
  * "index"(a.k.a array offset)
  */
 INDEX_TEMPLATE_ARGUMENTS
-const MappingType &B_PLUS_TREE_LEAF_PAGE_TYPE::GetItem(int index) {
-  // replace with your own code
-  return array[0];
+MappingType B_PLUS_TREE_LEAF_PAGE_TYPE::GetItem(int index) const {
+  assert(index >= 0 && index < GetSize());
+  return MappingType(keys_[index], Values()[index]);
+}
+
+/*
+ * Helper methods to get the record ids, they start behind the last key slot
+ */
+INDEX_TEMPLATE_ARGUMENTS
+ValueType *B_PLUS_TREE_LEAF_PAGE_TYPE::Values() {
+  return reinterpret_cast<ValueType *>(keys_ + GetMaxSize() + 1);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+const ValueType *B_PLUS_TREE_LEAF_PAGE_TYPE::Values() const {
+  return reinterpret_cast<const ValueType *>(keys_ + GetMaxSize() + 1);
+}
+
+/*
+ * Helper methods to put key & value pair at index, and to remove the one at
+ * index
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_LEAF_PAGE_TYPE::InsertAt(int index, const KeyType &key,
+                                          const ValueType &value) {
+  ValueType *values = Values();
+  std::copy_backward(keys_ + index, keys_ + GetSize(), keys_ + GetSize() + 1);
+  std::copy_backward(values + index, values + GetSize(),
+                     values + GetSize() + 1);
+  keys_[index] = key;
+  values[index] = value;
+  IncreaseSize(1);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_LEAF_PAGE_TYPE::RemoveAt(int index) {
+  ValueType *values = Values();
+  std::copy(keys_ + index + 1, keys_ + GetSize(), keys_ + index);
+  std::copy(values + index + 1, values + GetSize(), values + index);
+  IncreaseSize(-1);
 }
 
 /*****************************************************************************
@@ -75,7 +253,11 @@ INDEX_TEMPLATE_ARGUMENTS
 int B_PLUS_TREE_LEAF_PAGE_TYPE::Insert(const KeyType &key,
                                        const ValueType &value,
                                        const KeyComparator &comparator) {
-  return 0;
+  int index = KeyIndex(key, comparator);
+  if (index < GetSize() && comparator(keys_[index], key) == 0)
+    return GetSize();
+  InsertAt(index, key, value);
+  return GetSize();
 }
 
 /*****************************************************************************
@@ -87,10 +269,25 @@ int B_PLUS_TREE_LEAF_PAGE_TYPE::Insert(const KeyType &key,
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveHalfTo(
     BPlusTreeLeafPage *recipient,
-    __attribute__((unused)) BufferPoolManager *buffer_pool_manager) {}
+    __attribute__((unused)) BufferPoolManager *buffer_pool_manager) {
+  int keep = (GetSize() + 1) / 2;
+  recipient->CopyHalfFrom(this, keep, GetSize() - keep);
+  SetSize(keep);
+  // the recipient is the right sibling, its first key our new high key
+  recipient->SetNextPageId(GetNextPageId());
+  recipient->SetHighKey(GetHighKey());
+  SetNextPageId(recipient->GetPageId());
+  SetHighKey(recipient->KeyAt(0));
+}
 
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE_TYPE::CopyHalfFrom(MappingType *items, int size) {}
+void B_PLUS_TREE_LEAF_PAGE_TYPE::CopyHalfFrom(const BPlusTreeLeafPage *sibling,
+                                              int index, int size) {
+  std::copy(sibling->keys_ + index, sibling->keys_ + index + size, keys_);
+  std::copy(sibling->Values() + index, sibling->Values() + index + size,
+            Values());
+  SetSize(size);
+}
 
 /*****************************************************************************
  * LOOKUP
@@ -103,7 +300,11 @@ void B_PLUS_TREE_LEAF_PAGE_TYPE::CopyHalfFrom(MappingType *items, int size) {}
 INDEX_TEMPLATE_ARGUMENTS
 bool B_PLUS_TREE_LEAF_PAGE_TYPE::Lookup(const KeyType &key, ValueType &value,
                                         const KeyComparator &comparator) const {
-  return false;
+  int index = KeyIndex(key, comparator);
+  if (index == GetSize() || comparator(keys_[index], key) != 0)
+    return false;
+  value = Values()[index];
+  return true;
 }
 
 /*****************************************************************************
@@ -118,7 +319,37 @@ bool B_PLUS_TREE_LEAF_PAGE_TYPE::Lookup(const KeyType &key, ValueType &value,
 INDEX_TEMPLATE_ARGUMENTS
 int B_PLUS_TREE_LEAF_PAGE_TYPE::RemoveAndDeleteRecord(
     const KeyType &key, const KeyComparator &comparator) {
-  return 0;
+  int index = KeyIndex(key, comparator);
+  if (index == GetSize() || comparator(keys_[index], key) != 0)
+    return GetSize();
+  RemoveAt(index);
+  return GetSize();
+}
+
+/*****************************************************************************
+ * SPACE
+ *****************************************************************************/
+/*
+ * Decide whether one more pair fits, the page may go one beyond its max size
+ * before it is split
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool B_PLUS_TREE_LEAF_PAGE_TYPE::HasRoomFor(const KeyType &) const {
+  return GetSize() <= GetMaxSize();
+}
+
+/*
+ * Decide whether size pairs of a sibling fit into this page
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool B_PLUS_TREE_LEAF_PAGE_TYPE::CanMoveFrom(const BPlusTreeLeafPage *,
+                                             int size) const {
+  return GetSize() + size <= GetMaxSize();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+bool B_PLUS_TREE_LEAF_PAGE_TYPE::IsUnderfull() const {
+  return GetSize() < GetMinSize();
 }
 
 /*****************************************************************************
@@ -130,9 +361,21 @@ int B_PLUS_TREE_LEAF_PAGE_TYPE::RemoveAndDeleteRecord(
  */
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveAllTo(BPlusTreeLeafPage *recipient,
-                                           int, BufferPoolManager *) {}
+                                           int, BufferPoolManager *) {
+  recipient->CopyAllFrom(this, GetSize());
+  recipient->SetNextPageId(GetNextPageId());
+  recipient->SetHighKey(GetHighKey());
+  SetSize(0);
+}
+
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE_TYPE::CopyAllFrom(MappingType *items, int size) {}
+void B_PLUS_TREE_LEAF_PAGE_TYPE::CopyAllFrom(const BPlusTreeLeafPage *sibling,
+                                             int size) {
+  std::copy(sibling->keys_, sibling->keys_ + size, keys_ + GetSize());
+  std::copy(sibling->Values(), sibling->Values() + size,
+            Values() + GetSize());
+  IncreaseSize(size);
+}
 
 /*****************************************************************************
  * REDISTRIBUTE
@@ -144,10 +387,27 @@ void B_PLUS_TREE_LEAF_PAGE_TYPE::CopyAllFrom(MappingType *items, int size) {}
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveFirstToEndOf(
     BPlusTreeLeafPage *recipient,
-    BufferPoolManager *buffer_pool_manager) {}
+    BufferPoolManager *buffer_pool_manager) {
+  MappingType item = GetItem(0);
+  RemoveAt(0);
+  recipient->CopyLastFrom(item);
+  recipient->SetHighKey(keys_[0]);
+
+  // our new first key becomes our separator
+  auto *page = buffer_pool_manager->FetchPage(GetParentPageId());
+  if (page == nullptr)
+    throw Exception(EXCEPTION_TYPE_INDEX, "out of memory");
+  auto *parent =
+      reinterpret_cast<BPlusTreeInternalPage<KeyType, page_id_t,
+                                             KeyComparator> *>(page->GetData());
+  parent->SetKeyAt(parent->ValueIndex(GetPageId()), keys_[0]);
+  buffer_pool_manager->UnpinPage(parent->GetPageId(), true);
+}
 
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE_TYPE::CopyLastFrom(const MappingType &item) {}
+void B_PLUS_TREE_LEAF_PAGE_TYPE::CopyLastFrom(const MappingType &item) {
+  InsertAt(GetSize(), item.first, item.second);
+}
 /*
  * Remove the last key & value pair from this page to "recipient" page, then
  * update relavent key & value pair in its parent page.
@@ -155,12 +415,86 @@ void B_PLUS_TREE_LEAF_PAGE_TYPE::CopyLastFrom(const MappingType &item) {}
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveLastToFrontOf(
     BPlusTreeLeafPage *recipient, int parentIndex,
-    BufferPoolManager *buffer_pool_manager) {}
+    BufferPoolManager *buffer_pool_manager) {
+  MappingType item = GetItem(GetSize() - 1);
+  RemoveAt(GetSize() - 1);
+  SetHighKey(item.first);
+  recipient->CopyFirstFrom(item, parentIndex, buffer_pool_manager);
+}
 
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_LEAF_PAGE_TYPE::CopyFirstFrom(
     const MappingType &item, int parentIndex,
-    BufferPoolManager *buffer_pool_manager) {}
+    BufferPoolManager *buffer_pool_manager) {
+  InsertAt(0, item.first, item.second);
+
+  // the moved key becomes our separator
+  auto *page = buffer_pool_manager->FetchPage(GetParentPageId());
+  if (page == nullptr)
+    throw Exception(EXCEPTION_TYPE_INDEX, "out of memory");
+  auto *parent =
+      reinterpret_cast<BPlusTreeInternalPage<KeyType, page_id_t,
+                                             KeyComparator> *>(page->GetData());
+  parent->SetKeyAt(parentIndex, item.first);
+  buffer_pool_manager->UnpinPage(parent->GetPageId(), true);
+}
+
+/*****************************************************************************
+ * BULK LOAD
+ *****************************************************************************/
+/*
+ * Append key & value pair behind the last one, key must be greater than all
+ * keys in this page
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_LEAF_PAGE_TYPE::Append(const KeyType &key,
+                                        const ValueType &value) {
+  InsertAt(GetSize(), key, value);
+}
+
+/*
+ * Remove the last size key & value pairs from this page to head of
+ * "recipient", our right sibling, the first of them becomes our high key.
+ * NOTE: only for pages built by a bulk load before they are linked into a
+ * parent
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveTailTo(BPlusTreeLeafPage *recipient,
+                                            int size) {
+  KeyType *keys = recipient->keys_;
+  ValueType *values = recipient->Values();
+  std::copy_backward(keys, keys + recipient->GetSize(),
+                     keys + recipient->GetSize() + size);
+  std::copy_backward(values, values + recipient->GetSize(),
+                     values + recipient->GetSize() + size);
+  std::copy(keys_ + GetSize() - size, keys_ + GetSize(), keys);
+  std::copy(Values() + GetSize() - size, Values() + GetSize(), values);
+  recipient->IncreaseSize(size);
+  IncreaseSize(-size);
+  SetHighKey(recipient->KeyAt(0));
+}
+
+/*
+ * Remove the first size key & value pairs from this page to tail of
+ * "recipient", our left sibling. If this page is emptied, the recipient takes
+ * over our next page id and high key.
+ * NOTE: only for pages built by a bulk load before they are linked into a
+ * parent
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveHeadTo(BPlusTreeLeafPage *recipient,
+                                            int size) {
+  recipient->CopyAllFrom(this, size);
+  std::copy(keys_ + size, keys_ + GetSize(), keys_);
+  std::copy(Values() + size, Values() + GetSize(), Values());
+  IncreaseSize(-size);
+  if (GetSize() > 0) {
+    recipient->SetHighKey(keys_[0]);
+    return;
+  }
+  recipient->SetNextPageId(GetNextPageId());
+  recipient->SetHighKey(GetHighKey());
+}
 
 /*****************************************************************************
  * DEBUG
@@ -185,9 +519,9 @@ std::string B_PLUS_TREE_LEAF_PAGE_TYPE::ToString(bool verbose) const {
     } else {
       stream << " ";
     }
-    stream << std::dec << array[entry].first;
+    stream << std::dec << keys_[entry];
     if (verbose) {
-      stream << "(" << array[entry].second << ")";
+      stream << "(" << Values()[entry] << ")";
     }
     ++entry;
   }
@@ -0,0 +1,115 @@
+/**
+ * hash_table_bucket_page.cpp
+ */
+
+#include <cassert>
+
+#include "common/rid.h"
+#include "page/hash_table_bucket_page.h"
+
+namespace cmudb {
+
+INDEX_TEMPLATE_ARGUMENTS
+void HASH_TABLE_BUCKET_PAGE_TYPE::Init() {
+  size_ = 0;
+  next_page_id_ = INVALID_PAGE_ID;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+int HASH_TABLE_BUCKET_PAGE_TYPE::GetSize() const { return size_; }
+
+INDEX_TEMPLATE_ARGUMENTS
+bool HASH_TABLE_BUCKET_PAGE_TYPE::IsFull() const {
+  return size_ >= GetMaxSize();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+bool HASH_TABLE_BUCKET_PAGE_TYPE::IsEmpty() const { return size_ == 0; }
+
+/*
+ * Number of entries that fit behind the header
+ */
+INDEX_TEMPLATE_ARGUMENTS
+int HASH_TABLE_BUCKET_PAGE_TYPE::GetMaxSize() {
+  return static_cast<int>((PAGE_SIZE - sizeof(HashTableBucketPage)) /
+                          sizeof(MappingType));
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+page_id_t HASH_TABLE_BUCKET_PAGE_TYPE::GetNextPageId() const {
+  return next_page_id_;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void HASH_TABLE_BUCKET_PAGE_TYPE::SetNextPageId(page_id_t next_page_id) {
+  next_page_id_ = next_page_id;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+KeyType HASH_TABLE_BUCKET_PAGE_TYPE::KeyAt(int index) const {
+  assert(index >= 0 && index < size_);
+  return array_[index].first;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+ValueType HASH_TABLE_BUCKET_PAGE_TYPE::ValueAt(int index) const {
+  assert(index >= 0 && index < size_);
+  return array_[index].second;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+bool HASH_TABLE_BUCKET_PAGE_TYPE::Lookup(
+    const KeyType &key, ValueType &value,
+    const KeyComparator &comparator) const {
+  int index = KeyIndex(key, comparator);
+  if (index == -1)
+    return false;
+  value = array_[index].second;
+  return true;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+bool HASH_TABLE_BUCKET_PAGE_TYPE::Insert(const KeyType &key,
+                                         const ValueType &value,
+                                         const KeyComparator &comparator) {
+  if (IsFull() || KeyIndex(key, comparator) != -1)
+    return false;
+  array_[size_++] = MappingType(key, value);
+  return true;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+bool HASH_TABLE_BUCKET_PAGE_TYPE::Remove(const KeyType &key,
+                                         const KeyComparator &comparator) {
+  int index = KeyIndex(key, comparator);
+  if (index == -1)
+    return false;
+  RemoveAt(index);
+  return true;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void HASH_TABLE_BUCKET_PAGE_TYPE::RemoveAt(int index) {
+  assert(index >= 0 && index < size_);
+  array_[index] = array_[--size_];
+}
+
+/*
+ * Helper function to find the entry of key, return -1 if there is none
+ */
+INDEX_TEMPLATE_ARGUMENTS
+int HASH_TABLE_BUCKET_PAGE_TYPE::KeyIndex(
+    const KeyType &key, const KeyComparator &comparator) const {
+  for (int i = 0; i < size_; i++) {
+    if (comparator(array_[i].first, key) == 0)
+      return i;
+  }
+  return -1;
+}
+
+template class HashTableBucketPage<GenericKey<4>, RID, GenericComparator<4>>;
+template class HashTableBucketPage<GenericKey<8>, RID, GenericComparator<8>>;
+template class HashTableBucketPage<GenericKey<16>, RID, GenericComparator<16>>;
+template class HashTableBucketPage<GenericKey<32>, RID, GenericComparator<32>>;
+template class HashTableBucketPage<GenericKey<64>, RID, GenericComparator<64>>;
+} // namespace cmudb
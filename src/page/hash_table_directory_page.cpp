@@ -0,0 +1,94 @@
+/**
+ * hash_table_directory_page.cpp
+ */
+
+#include <cassert>
+
+#include "page/hash_table_directory_page.h"
+
+namespace cmudb {
+
+/*
+ * Init method after creating a new directory page: global depth zero, the
+ * only slot points to bucket_page_id
+ */
+void HashTableDirectoryPage::Init(page_id_t page_id, page_id_t bucket_page_id) {
+  page_id_ = page_id;
+  global_depth_ = 0;
+  local_depths_[0] = 0;
+  bucket_page_ids_[0] = bucket_page_id;
+}
+
+page_id_t HashTableDirectoryPage::GetPageId() const { return page_id_; }
+
+uint32_t HashTableDirectoryPage::GetGlobalDepth() const {
+  return global_depth_;
+}
+
+uint32_t HashTableDirectoryPage::GetSize() const {
+  return 1u << global_depth_;
+}
+
+uint32_t HashTableDirectoryPage::GetSlot(uint32_t hash) const {
+  return hash & (GetSize() - 1);
+}
+
+page_id_t HashTableDirectoryPage::GetBucketPageId(uint32_t slot) const {
+  assert(slot < GetSize());
+  return bucket_page_ids_[slot];
+}
+
+void HashTableDirectoryPage::SetBucketPageId(uint32_t slot,
+                                             page_id_t bucket_page_id) {
+  assert(slot < GetSize());
+  bucket_page_ids_[slot] = bucket_page_id;
+}
+
+uint32_t HashTableDirectoryPage::GetLocalDepth(uint32_t slot) const {
+  assert(slot < GetSize());
+  return local_depths_[slot];
+}
+
+void HashTableDirectoryPage::SetLocalDepth(uint32_t slot,
+                                           uint32_t local_depth) {
+  assert(slot < GetSize() && local_depth <= global_depth_);
+  local_depths_[slot] = static_cast<uint8_t>(local_depth);
+}
+
+/*
+ * The split image differs in the highest bit of the local depth. A bucket at
+ * local depth zero is its own image.
+ */
+uint32_t HashTableDirectoryPage::GetSplitImageSlot(uint32_t slot) const {
+  uint32_t local_depth = GetLocalDepth(slot);
+  if (local_depth == 0)
+    return slot;
+  return slot ^ (1u << (local_depth - 1));
+}
+
+void HashTableDirectoryPage::IncrGlobalDepth() {
+  assert(global_depth_ < DIRECTORY_MAX_DEPTH);
+  uint32_t size = GetSize();
+  for (uint32_t i = 0; i < size; i++) {
+    local_depths_[i + size] = local_depths_[i];
+    bucket_page_ids_[i + size] = bucket_page_ids_[i];
+  }
+  global_depth_++;
+}
+
+void HashTableDirectoryPage::DecrGlobalDepth() {
+  assert(CanShrink());
+  global_depth_--;
+}
+
+bool HashTableDirectoryPage::CanShrink() const {
+  if (global_depth_ == 0)
+    return false;
+  for (uint32_t i = 0; i < GetSize(); i++) {
+    if (local_depths_[i] == global_depth_)
+      return false;
+  }
+  return true;
+}
+
+} // namespace cmudb
@@ -18,6 +18,9 @@ bool HeaderPage::InsertRecord(const std::string &name,
 
   int record_num = GetRecordCount();
   int offset = 4 + record_num * 36;
+  // the trailer of the page is reserved for the disk manager
+  if (offset + 36 > PAGE_SIZE - HEADER_PAGE_RESERVED)
+    return false;
   // check for duplicate name
   if (FindRecord(name) != -1)
     return false;
@@ -14,15 +14,12 @@ TableHeap::TableHeap(BufferPoolManager *buffer_pool_manager,
     : buffer_pool_manager_(buffer_pool_manager), lock_manager_(lock_manager),
       first_page_id_(first_page_id) {
   if (first_page_id_ == INVALID_PAGE_ID) {
-    auto first_page =
-        static_cast<TablePage *>(buffer_pool_manager_->NewPage(first_page_id_));
-    assert(first_page != nullptr); // todo: abort table creation?
-    first_page->WLatch();
+    WritePageGuard first_page =
+        buffer_pool_manager_->NewPageGuarded(first_page_id_);
+    assert(first_page); // todo: abort table creation?
     LOG_DEBUG("new table page created %d", first_page_id_);
 
-    first_page->Init(first_page_id_, PAGE_SIZE);
-    first_page->WUnlatch();
-    buffer_pool_manager_->UnpinPage(first_page_id_, true);
+    first_page.As<TablePage>()->Init(first_page_id_, PAGE_SIZE);
   }
 }
 
@@ -32,119 +29,95 @@ bool TableHeap::InsertTuple(const Tuple &tuple, RID &rid, Transaction *txn) {
     return false;
   }
 
-  auto cur_page =
-      static_cast<TablePage *>(buffer_pool_manager_->FetchPage(first_page_id_));
-  if (cur_page == nullptr) {
+  WritePageGuard cur_page =
+      buffer_pool_manager_->FetchPageWrite(first_page_id_);
+  if (!cur_page) {
     txn->SetState(TransactionState::ABORTED);
     return false;
   }
 
-  cur_page->WLatch();
-  while (!cur_page->InsertTuple(
+  while (!cur_page.As<TablePage>()->InsertTuple(
       tuple, rid, txn,
       lock_manager_)) { // fail to insert due to not enough space
-    auto next_page_id = cur_page->GetNextPageId();
+    auto next_page_id = cur_page.As<TablePage>()->GetNextPageId();
     if (next_page_id != INVALID_PAGE_ID) { // valid next page
-      cur_page->WUnlatch();
-      buffer_pool_manager_->UnpinPage(cur_page->GetPageId(), false);
-      cur_page = static_cast<TablePage *>(
-          buffer_pool_manager_->FetchPage(next_page_id));
-      cur_page->WLatch();
+      cur_page.SetDirty(false);
+      cur_page.Release();
+      cur_page = buffer_pool_manager_->FetchPageWrite(next_page_id);
     } else { // create new page
-      auto new_page =
-          static_cast<TablePage *>(buffer_pool_manager_->NewPage(next_page_id));
-      if (new_page == nullptr) {
-        cur_page->WUnlatch();
-        buffer_pool_manager_->UnpinPage(cur_page->GetPageId(), false);
+      WritePageGuard new_page =
+          buffer_pool_manager_->NewPageGuarded(next_page_id);
+      if (!new_page) {
+        cur_page.SetDirty(false);
         txn->SetState(TransactionState::ABORTED);
         return false;
       }
-      new_page->WLatch();
       // std::cout << "new table page " << next_page_id << " created" <<
       // std::endl;
-      cur_page->SetNextPageId(next_page_id);
-      new_page->Init(next_page_id, PAGE_SIZE, cur_page->GetPageId(),
-                     INVALID_PAGE_ID);
-      cur_page->WUnlatch();
-      buffer_pool_manager_->UnpinPage(cur_page->GetPageId(), true);
-      cur_page = new_page;
+      cur_page.As<TablePage>()->SetNextPageId(next_page_id);
+      new_page.As<TablePage>()->Init(next_page_id, PAGE_SIZE,
+                                     cur_page.GetPageId(), INVALID_PAGE_ID);
+      cur_page = std::move(new_page);
     }
   }
-  cur_page->WUnlatch();
-  buffer_pool_manager_->UnpinPage(cur_page->GetPageId(), true);
+  cur_page.Release();
   txn->GetWriteSet()->emplace_back(rid, WType::INSERT, Tuple{RID()}, this);
   return true;
 }
 
 bool TableHeap::MarkDelete(const RID &rid, Transaction *txn) {
   // todo: remove empty page
-  auto page = reinterpret_cast<TablePage *>(
-      buffer_pool_manager_->FetchPage(rid.GetPageId()));
-  if (page == nullptr) {
+  WritePageGuard page = buffer_pool_manager_->FetchPageWrite(rid.GetPageId());
+  if (!page) {
     txn->SetState(TransactionState::ABORTED);
     return false;
   }
-  page->WLatch();
-  page->MarkDelete(rid, txn, lock_manager_);
-  page->WUnlatch();
-  buffer_pool_manager_->UnpinPage(page->GetPageId(), true);
+  page.As<TablePage>()->MarkDelete(rid, txn, lock_manager_);
+  page.Release();
   txn->GetWriteSet()->emplace_back(rid, WType::DELETE, Tuple{RID()}, this);
   return true;
 }
 
 bool TableHeap::UpdateTuple(const Tuple &tuple, const RID &rid,
                             Transaction *txn) {
-  auto page = reinterpret_cast<TablePage *>(
-      buffer_pool_manager_->FetchPage(rid.GetPageId()));
-  if (page == nullptr) {
+  WritePageGuard page = buffer_pool_manager_->FetchPageWrite(rid.GetPageId());
+  if (!page) {
     txn->SetState(TransactionState::ABORTED);
     return false;
   }
   Tuple old_tuple{RID()};
-  page->WLatch();
-  bool is_updated =
-      page->UpdateTuple(tuple, old_tuple, rid, txn, lock_manager_);
-  page->WUnlatch();
-  buffer_pool_manager_->UnpinPage(page->GetPageId(), is_updated);
+  bool is_updated = page.As<TablePage>()->UpdateTuple(tuple, old_tuple, rid,
+                                                      txn, lock_manager_);
+  page.SetDirty(is_updated);
+  page.Release();
   if (is_updated)
     txn->GetWriteSet()->emplace_back(rid, WType::UPDATE, old_tuple, this);
   return is_updated;
 }
 
 void TableHeap::ApplyDelete(const RID &rid, Transaction *txn) {
-  auto page = reinterpret_cast<TablePage *>(
-      buffer_pool_manager_->FetchPage(rid.GetPageId()));
-  assert(page != nullptr);
-  page->WLatch();
-  page->ApplyDelete(rid, txn);
+  WritePageGuard page = buffer_pool_manager_->FetchPageWrite(rid.GetPageId());
+  assert(page);
+  page.As<TablePage>()->ApplyDelete(rid, txn);
   lock_manager_->Unlock(txn, rid);
-  page->WUnlatch();
-  buffer_pool_manager_->UnpinPage(page->GetPageId(), true);
 }
 
 void TableHeap::RollbackDelete(const RID &rid, Transaction *txn) {
-  auto page = reinterpret_cast<TablePage *>(
-      buffer_pool_manager_->FetchPage(rid.GetPageId()));
-  assert(page != nullptr);
-  page->WLatch();
-  page->RollbackDelete(rid, txn);
-  page->WUnlatch();
-  buffer_pool_manager_->UnpinPage(page->GetPageId(), true);
+  WritePageGuard page = buffer_pool_manager_->FetchPageWrite(rid.GetPageId());
+  assert(page);
+  page.As<TablePage>()->RollbackDelete(rid, txn);
 }
 
 // called by tuple iterator
-bool TableHeap::GetTuple(const RID &rid, Tuple &tuple, Transaction *txn) {
-  auto page = static_cast<TablePage *>(
-      buffer_pool_manager_->FetchPage(rid.GetPageId()));
-  if (page == nullptr) {
+bool TableHeap::GetTuple(const RID &rid, Tuple &tuple, Transaction *txn,
+                         BufferRing *ring) {
+  ReadPageGuard page =
+      buffer_pool_manager_->FetchPageRead(rid.GetPageId(), ring);
+  if (!page) {
     txn->SetState(TransactionState::ABORTED);
     return false;
   }
-  page->RLatch();
-  bool res = page->GetTuple(rid, tuple, txn, lock_manager_);
-  page->RUnlatch();
-  buffer_pool_manager_->UnpinPage(rid.GetPageId(), false);
-  return res;
+  return page.As<TablePage>()->GetTuple(rid, tuple, txn, lock_manager_);
 }
 
 bool TableHeap::DeleteTableHeap() {
@@ -152,21 +125,61 @@ bool TableHeap::DeleteTableHeap() {
   return true;
 }
 
-TableIterator TableHeap::begin(Transaction *txn) {
-  auto page =
-      static_cast<TablePage *>(buffer_pool_manager_->FetchPage(first_page_id_));
-  page->RLatch();
+TableIterator TableHeap::begin(Transaction *txn, bool bulk_read) {
+  std::shared_ptr<BufferRing> ring;
+  if (bulk_read)
+    ring = std::make_shared<BufferRing>(buffer_pool_manager_, BUFFER_RING_SIZE);
   RID rid;
-  // if failed (no tuple), rid will be the result of default
-  // constructor, which means eof
-  page->GetFirstTupleRid(rid);
-  page->RUnlatch();
-  buffer_pool_manager_->UnpinPage(first_page_id_, false);
-  return TableIterator(this, rid, txn);
+  {
+    ReadPageGuard page =
+        buffer_pool_manager_->FetchPageRead(first_page_id_, ring.get());
+    // if failed (no tuple), rid will be the result of default
+    // constructor, which means eof
+    page.As<TablePage>()->GetFirstTupleRid(rid);
+    // the scan re-checks this window on its first page switch, the pages are
+    // cached by then and skipped
+    page_id_t readahead_end = INVALID_PAGE_ID;
+    Readahead(page.As<TablePage>(), readahead_end, ring.get());
+  }
+  return TableIterator(this, rid, txn, ring);
 }
 
 TableIterator TableHeap::end() {
   return TableIterator(this, RID(INVALID_PAGE_ID, -1), nullptr);
 }
 
+/*
+ * Called by scans whenever they reach a page. While the chain is sequential
+ * the window of readahead_pages_ pages after the current one is kept
+ * prefetched, it is topped up once half of it has been consumed. Otherwise
+ * only the next page of the chain is prefetched.
+ * readahead_end: one past the last page prefetched by this scan, kept by the
+ * iterator between calls
+ * ring: the scan's ring, if any. The window is then limited to half of the
+ * ring so that prefetched pages are not recycled before they are read.
+ */
+void TableHeap::Readahead(TablePage *page, page_id_t &readahead_end,
+                          BufferRing *ring) {
+  size_t window = readahead_pages_;
+  if (ring != nullptr && window > ring->GetSize() / 2)
+    window = ring->GetSize() / 2;
+  page_id_t next_page_id = page->GetNextPageId();
+  if (window == 0 || next_page_id == INVALID_PAGE_ID)
+    return;
+  if (next_page_id != page->GetPageId() + 1) {
+    readahead_end = INVALID_PAGE_ID;
+    buffer_pool_manager_->Prefetch(next_page_id, 1, ring);
+    return;
+  }
+  page_id_t window_end = next_page_id + static_cast<page_id_t>(window);
+  page_id_t start = next_page_id;
+  if (readahead_end != INVALID_PAGE_ID && next_page_id < readahead_end) {
+    if (static_cast<size_t>(readahead_end - next_page_id) > window / 2)
+      return;
+    start = readahead_end;
+  }
+  buffer_pool_manager_->Prefetch(start, window_end - start, ring);
+  readahead_end = window_end;
+}
+
 } // namespace cmudb
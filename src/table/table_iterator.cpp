@@ -8,10 +8,12 @@
 
 namespace cmudb {
 
-TableIterator::TableIterator(TableHeap *table_heap, RID rid, Transaction *txn)
-    : table_heap_(table_heap), tuple_(new Tuple(rid)), txn_(txn) {
+TableIterator::TableIterator(TableHeap *table_heap, RID rid, Transaction *txn,
+                             std::shared_ptr<BufferRing> ring)
+    : table_heap_(table_heap), tuple_(new Tuple(rid)), txn_(txn),
+      readahead_end_(INVALID_PAGE_ID), ring_(ring) {
   if (rid.GetPageId() != INVALID_PAGE_ID) {
-    table_heap_->GetTuple(tuple_->rid_, *tuple_, txn_);
+    table_heap_->GetTuple(tuple_->rid_, *tuple_, txn_, ring_.get());
   }
 };
 
@@ -27,22 +29,25 @@ Tuple *TableIterator::operator->() {
 
 TableIterator &TableIterator::operator++() {
   BufferPoolManager *buffer_pool_manager = table_heap_->buffer_pool_manager_;
-  auto cur_page = static_cast<TablePage *>(
-      buffer_pool_manager->FetchPage(tuple_->rid_.GetPageId()));
-  cur_page->RLatch();
-  assert(cur_page != nullptr); // all pages are pinned
+  ReadPageGuard cur_page = buffer_pool_manager->FetchPageRead(
+      tuple_->rid_.GetPageId(), ring_.get());
+  assert(cur_page); // all pages are pinned
 
   RID next_tuple_rid;
-  if (!cur_page->GetNextTupleRid(tuple_->rid_,
-                                 next_tuple_rid)) { // end of this page
-    while (cur_page->GetNextPageId() != INVALID_PAGE_ID) {
-      auto next_page = static_cast<TablePage *>(
-          buffer_pool_manager->FetchPage(cur_page->GetNextPageId()));
-      cur_page->RUnlatch();
-      buffer_pool_manager->UnpinPage(cur_page->GetPageId(), false);
-      cur_page = next_page;
-      cur_page->RLatch();
-      if (cur_page->GetFirstTupleRid(next_tuple_rid))
+  if (!cur_page.As<TablePage>()->GetNextTupleRid(
+          tuple_->rid_, next_tuple_rid)) { // end of this page
+    page_id_t next_page_id;
+    while ((next_page_id = cur_page.As<TablePage>()->GetNextPageId()) !=
+           INVALID_PAGE_ID) {
+      // pin the next page before the current one is released
+      Page *next_page = buffer_pool_manager->FetchPage(next_page_id,
+                                                       ring_.get());
+      cur_page.Release();
+      next_page->RLatch();
+      cur_page = ReadPageGuard(buffer_pool_manager, next_page);
+      table_heap_->Readahead(cur_page.As<TablePage>(), readahead_end_,
+                             ring_.get());
+      if (cur_page.As<TablePage>()->GetFirstTupleRid(next_tuple_rid))
         break;
     }
   }
@@ -52,8 +57,6 @@ TableIterator &TableIterator::operator++() {
     table_heap_->GetTuple(tuple_->rid_, *tuple_, txn_);
   }
   // release until copy the tuple
-  cur_page->RUnlatch();
-  buffer_pool_manager->UnpinPage(cur_page->GetPageId(), false);
   return *this;
 }
 
@@ -4,6 +4,7 @@
 #include <algorithm>
 #include <cstring>
 #include <iostream>
+#include <new>
 #include <sys/stat.h>
 #include <vector>
 
@@ -104,9 +105,11 @@ int VtabConnect(sqlite3 *db, void *pAux, int argc, const char *const *argv,
 }
 
 /*
- * we only support
- * (1) equlity check. e.g select * from foo where a = 1
- * (2) indexed column == predicated column
+ * we support
+ * (1) equality on all indexed columns, e.g. select * from foo where a = 1
+ * (2) b+ tree indexes only: equality on a key prefix and a range on the next
+ * key column, e.g. select * from foo where a = 1 and b > 2 and b <= 5
+ * sqlite checks all constraints again, the scan only has to cover the rows
  */
 int VtabBestIndex(sqlite3_vtab *tab, sqlite3_index_info *pIdxInfo) {
   // LOG_DEBUG("VtabBestIndex");
@@ -114,33 +117,67 @@ int VtabBestIndex(sqlite3_vtab *tab, sqlite3_index_info *pIdxInfo) {
   if (table->GetIndex() == nullptr)
     return SQLITE_OK;
   const std::vector<int> key_attrs = table->GetIndex()->GetKeyAttrs();
-  // make sure indexed column == predicate column
-  // e.g select * from foo where a = 1 and b =2; indexed column must be {a,b}
-  if (pIdxInfo->nConstraint != (int)(key_attrs.size()))
-    return SQLITE_OK;
-
-  int counter = 0;
-  bool is_index_scan = true;
-  for (int i = 0; i < pIdxInfo->nConstraint; i++) {
-    if (pIdxInfo->aConstraint[i].usable == 0)
-      continue;
-    int item = pIdxInfo->aConstraint[i].iColumn;
-    // if predicate column is part of indexed column
-    if (std::find(key_attrs.begin(), key_attrs.end(), item) !=
-        key_attrs.end()) {
-      // equlity check
-      if (pIdxInfo->aConstraint[i].op != SQLITE_INDEX_CONSTRAINT_EQ) {
-        is_index_scan = false;
-        break;
-      }
-      pIdxInfo->aConstraintUsage[i].argvIndex = (i + 1);
-      counter++;
+  int key_size = static_cast<int>(key_attrs.size());
+  bool is_ordered = table->GetIndex()->GetMetadata()->GetIndexType() ==
+                    IndexType::BPlusTreeIndex;
+
+  // the first usable constraint on column with op, -1 if there is none
+  auto find_constraint = [pIdxInfo](int column, unsigned char op) {
+    for (int i = 0; i < pIdxInfo->nConstraint; i++) {
+      if (pIdxInfo->aConstraint[i].usable != 0 &&
+          pIdxInfo->aConstraint[i].iColumn == column &&
+          pIdxInfo->aConstraint[i].op == op)
+        return i;
     }
+    return -1;
+  };
+  std::vector<int> used;
+  int equal_columns = 0;
+  for (; equal_columns < key_size; equal_columns++) {
+    int i = find_constraint(key_attrs[equal_columns],
+                            SQLITE_INDEX_CONSTRAINT_EQ);
+    if (i < 0)
+      break;
+    used.push_back(i);
   }
-
-  if (counter == (int)key_attrs.size() && is_index_scan) {
-    pIdxInfo->idxNum = 1;
+  int plan = equal_columns;
+  if (equal_columns < key_size) {
+    // point scans only on hash indexes
+    if (!is_ordered)
+      return SQLITE_OK;
+    int column = key_attrs[equal_columns];
+    int i = find_constraint(column, SQLITE_INDEX_CONSTRAINT_GE);
+    if (i >= 0) {
+      plan |= SCAN_LOW | SCAN_LOW_INCLUSIVE;
+    } else if ((i = find_constraint(column, SQLITE_INDEX_CONSTRAINT_GT)) >= 0) {
+      plan |= SCAN_LOW;
+    }
+    if (i >= 0)
+      used.push_back(i);
+    i = find_constraint(column, SQLITE_INDEX_CONSTRAINT_LE);
+    if (i >= 0) {
+      plan |= SCAN_HIGH | SCAN_HIGH_INCLUSIVE;
+    } else if ((i = find_constraint(column, SQLITE_INDEX_CONSTRAINT_LT)) >= 0) {
+      plan |= SCAN_HIGH;
+    }
+    if (i >= 0)
+      used.push_back(i);
   }
+  if (plan == 0)
+    return SQLITE_OK;
+
+  for (size_t argv_index = 0; argv_index < used.size(); argv_index++)
+    pIdxInfo->aConstraintUsage[used[argv_index]].argvIndex = argv_index + 1;
+  pIdxInfo->idxNum = plan;
+  // every equality column and every bound narrows the scan
+  double cost = 1000000;
+  for (int i = 0; i < equal_columns; i++)
+    cost /= 100;
+  if (plan & SCAN_LOW)
+    cost /= 4;
+  if (plan & SCAN_HIGH)
+    cost /= 4;
+  pIdxInfo->estimatedCost = std::max(cost, 1.0);
   return SQLITE_OK;
 }
 
@@ -184,12 +221,49 @@ int VtabFilter(sqlite3_vtab_cursor *pVtabCursor, int idxNum, const char *idxStr,
   Cursor *cursor = reinterpret_cast<Cursor *>(pVtabCursor);
   Schema *key_schema;
   // if indexed scan
-  if (idxNum == 1) {
+  if (idxNum != 0) {
     cursor->SetScanFlag(true);
-    // Construct the tuple for point query
     key_schema = cursor->GetKeySchema();
-    Tuple scan_tuple = ConstructTuple(key_schema, argv);
-    cursor->ScanKey(scan_tuple);
+    int equal_columns = idxNum & SCAN_EQUAL_COLUMNS;
+    if (equal_columns == key_schema->GetColumnCount()) {
+      // Construct the tuple for point query
+      Tuple scan_tuple = ConstructTuple(key_schema, argv);
+      cursor->ScanKey(scan_tuple);
+      return SQLITE_OK;
+    }
+    // both bounds start with the equality columns, a bound on the next
+    // column is dropped if its value does not fit the column
+    TypeId type = key_schema->GetType(equal_columns);
+    int arg = equal_columns;
+    std::vector<sqlite3_value *> low_values(argv, argv + equal_columns);
+    std::vector<sqlite3_value *> high_values(argv, argv + equal_columns);
+    bool low_inclusive = true;
+    bool high_inclusive = true;
+    if (idxNum & SCAN_LOW) {
+      if (IsExactValue(type, argv[arg])) {
+        low_values.push_back(argv[arg]);
+        low_inclusive = (idxNum & SCAN_LOW_INCLUSIVE) != 0;
+      }
+      arg++;
+    }
+    if (idxNum & SCAN_HIGH) {
+      if (IsExactValue(type, argv[arg])) {
+        high_values.push_back(argv[arg]);
+        high_inclusive = (idxNum & SCAN_HIGH_INCLUSIVE) != 0;
+      }
+      arg++;
+    }
+    Tuple low_key =
+        ConstructTuple(key_schema, low_values.data(), low_values.size());
+    Tuple high_key =
+        ConstructTuple(key_schema, high_values.data(), high_values.size());
+    // no columns leave the end open
+    ScanBound low, high;
+    if (!low_values.empty())
+      low = ScanBound(&low_key, low_values.size(), low_inclusive);
+    if (!high_values.empty())
+      high = ScanBound(&high_key, high_values.size(), high_inclusive);
+    cursor->ScanRange(low, high);
   }
   return SQLITE_OK;
 }
@@ -342,6 +416,112 @@ sqlite3_module VtableModule = {
     0,              /* xRollbackTo */
 };
 
+/* Buffer pool statistics */
+int BpmStatsConnect(sqlite3 *db, void *pAux, int argc, const char *const *argv,
+                    sqlite3_vtab **ppVtab, char **pzErr) {
+  int rc = sqlite3_declare_vtab(
+      db, "CREATE TABLE X(name TEXT, page_id INTEGER, value INTEGER);");
+  if (rc != SQLITE_OK)
+    return rc;
+  *ppVtab = new sqlite3_vtab();
+  return SQLITE_OK;
+}
+
+// always a full scan of the snapshot, sqlite filters the rows itself
+int BpmStatsBestIndex(sqlite3_vtab *tab, sqlite3_index_info *pIdxInfo) {
+  pIdxInfo->estimatedCost = 1000;
+  return SQLITE_OK;
+}
+
+int BpmStatsDisconnect(sqlite3_vtab *pVtab) {
+  delete pVtab;
+  return SQLITE_OK;
+}
+
+int BpmStatsOpen(sqlite3_vtab *pVtab, sqlite3_vtab_cursor **ppCursor) {
+  BpmStatsCursor *cursor = new BpmStatsCursor;
+  *ppCursor = reinterpret_cast<sqlite3_vtab_cursor *>(cursor);
+  return SQLITE_OK;
+}
+
+int BpmStatsClose(sqlite3_vtab_cursor *cur) {
+  delete reinterpret_cast<BpmStatsCursor *>(cur);
+  return SQLITE_OK;
+}
+
+int BpmStatsFilter(sqlite3_vtab_cursor *pVtabCursor, int idxNum,
+                   const char *idxStr, int argc, sqlite3_value **argv) {
+  BpmStatsCursor *cursor = reinterpret_cast<BpmStatsCursor *>(pVtabCursor);
+  cursor->Snapshot(global_parameters->buffer_pool_manager_);
+  return SQLITE_OK;
+}
+
+int BpmStatsNext(sqlite3_vtab_cursor *cur) {
+  BpmStatsCursor *cursor = reinterpret_cast<BpmStatsCursor *>(cur);
+  ++(*cursor);
+  return SQLITE_OK;
+}
+
+int BpmStatsEof(sqlite3_vtab_cursor *cur) {
+  BpmStatsCursor *cursor = reinterpret_cast<BpmStatsCursor *>(cur);
+  return cursor->isEof();
+}
+
+int BpmStatsColumn(sqlite3_vtab_cursor *cur, sqlite3_context *ctx, int i) {
+  BpmStatsCursor *cursor = reinterpret_cast<BpmStatsCursor *>(cur);
+  const BpmStatsCursor::Row &row = cursor->GetCurrentRow();
+  switch (i) {
+  case 0:
+    sqlite3_result_text(ctx, row.name_.c_str(), -1, SQLITE_TRANSIENT);
+    break;
+  case 1:
+    if (row.page_id_ == INVALID_PAGE_ID)
+      sqlite3_result_null(ctx);
+    else
+      sqlite3_result_int(ctx, row.page_id_);
+    break;
+  case 2:
+    sqlite3_result_int64(ctx, (sqlite3_int64)row.value_);
+    break;
+  default:
+    return SQLITE_ERROR;
+  }
+  return SQLITE_OK;
+}
+
+int BpmStatsRowid(sqlite3_vtab_cursor *cur, sqlite3_int64 *pRowid) {
+  BpmStatsCursor *cursor = reinterpret_cast<BpmStatsCursor *>(cur);
+  *pRowid = cursor->GetCurrentRowid();
+  return SQLITE_OK;
+}
+
+// no xCreate: the table is eponymous only and cannot be written
+sqlite3_module BpmStatsModule = {
+    0,                  /* iVersion */
+    0,                  /* xCreate */
+    BpmStatsConnect,    /* xConnect */
+    BpmStatsBestIndex,  /* xBestIndex */
+    BpmStatsDisconnect, /* xDisconnect */
+    BpmStatsDisconnect, /* xDestroy */
+    BpmStatsOpen,       /* xOpen - open a cursor */
+    BpmStatsClose,      /* xClose - close a cursor */
+    BpmStatsFilter,     /* xFilter - configure scan constraints */
+    BpmStatsNext,       /* xNext - advance a cursor */
+    BpmStatsEof,        /* xEof - check for end of scan */
+    BpmStatsColumn,     /* xColumn - read data */
+    BpmStatsRowid,      /* xRowid - read data */
+    0,                  /* xUpdate */
+    0,                  /* xBegin */
+    0,                  /* xSync */
+    0,                  /* xCommit */
+    0,                  /* xRollback */
+    0,                  /* xFindMethod */
+    0,                  /* xRename */
+    0,                  /* xSavepoint */
+    0,                  /* xRelease */
+    0,                  /* xRollbackTo */
+};
+
 #ifdef _WIN32
 __declspec(dllexport)
 #endif
@@ -353,7 +533,7 @@ __declspec(dllexport)
   bool is_file_exist = (stat(file_name.c_str(), &buffer) == 0);
   // BufferPoolManager is a global object share by all the virtual tables
   BufferPoolManager *buffer_pool_manager =
-      new BufferPoolManager(100, file_name);
+      new BufferPoolManager(BUFFER_POOL_SIZE, file_name);
   SQLITE_EXTENSION_INIT2(pApi);
   // create header page from BufferPoolManager if necessary
   page_id_t header_page_id;
@@ -376,9 +556,47 @@ __declspec(dllexport)
   global_parameters->transaction_ = nullptr;
 
   int rc = sqlite3_create_module(db, "vtable", &VtableModule, nullptr);
+  if (rc != SQLITE_OK)
+    return rc;
+  // e.g select * from vtable_bpm_stats
+  rc = sqlite3_create_module(db, "vtable_bpm_stats", &BpmStatsModule, nullptr);
+  if (rc != SQLITE_OK)
+    return rc;
+  // e.g select bpm_pool_size(4096)
+  for (int argc = 0; argc <= 1 && rc == SQLITE_OK; ++argc)
+    rc = sqlite3_create_function(db, "bpm_pool_size", argc, SQLITE_UTF8,
+                                 nullptr, BpmPoolSizeFunction, nullptr,
+                                 nullptr);
   return rc;
 }
 
+/* SQL functions */
+void BpmPoolSizeFunction(sqlite3_context *ctx, int argc, sqlite3_value **argv) {
+  BufferPoolManager *buffer_pool_manager =
+      global_parameters->buffer_pool_manager_;
+  if (argc > 0) {
+    if (sqlite3_value_type(argv[0]) != SQLITE_INTEGER ||
+        sqlite3_value_int64(argv[0]) <= 0) {
+      sqlite3_result_error(ctx, "pool size must be a positive integer", -1);
+      return;
+    }
+    if (sqlite3_value_int64(argv[0]) > MAX_BUFFER_POOL_SIZE) {
+      sqlite3_result_error(ctx, "pool size is too large", -1);
+      return;
+    }
+    // exceptions must not unwind through sqlite
+    try {
+      buffer_pool_manager->Resize(
+          static_cast<size_t>(sqlite3_value_int64(argv[0])));
+    } catch (std::bad_alloc &) {
+      sqlite3_result_error(ctx, "out of memory resizing the pool", -1);
+      return;
+    }
+  }
+  sqlite3_result_int64(
+      ctx, static_cast<sqlite3_int64>(buffer_pool_manager->GetPoolSize()));
+}
+
 /* Helpers */
 Schema *ParseCreateStatement(const std::string &sql_base) {
   std::string::size_type n;
@@ -454,6 +672,17 @@ IndexMetadata *ParseIndexStatement(std::string &sql,
   assert(n != std::string::npos);
   index_name = sql.substr(0, n);
   sql = sql.substr(n + 1);
+  // optional index type ahead of the indexed columns, e.g. 'foo_pk hash a'
+  IndexType index_type = IndexType::BPlusTreeIndex;
+  n = sql.find_first_of(' ');
+  if (n != std::string::npos) {
+    std::string type_name = sql.substr(0, n);
+    if (type_name == "hash" || type_name == "btree") {
+      if (type_name == "hash")
+        index_type = IndexType::HashTableIndex;
+      sql = sql.substr(n + 1);
+    }
+  }
 
   std::vector<std::string> tok = StringUtility::Split(sql, ',');
   // iterate through returned result
@@ -467,36 +696,39 @@ IndexMetadata *ParseIndexStatement(std::string &sql,
     throw Exception(EXCEPTION_TYPE_INDEX, "can't create index, format error");
 
   IndexMetadata *metadata =
-      new IndexMetadata(index_name, table_name, schema, key_attrs);
+      new IndexMetadata(index_name, table_name, schema, key_attrs, index_type);
 
   LOG_DEBUG("%s", metadata->ToString().c_str());
   return metadata;
 }
 
-Tuple ConstructTuple(Schema *schema, sqlite3_value **argv) {
-  int column_count = schema->GetColumnCount();
+Tuple ConstructTuple(Schema *schema, sqlite3_value **argv, int column_count) {
+  if (column_count < 0)
+    column_count = schema->GetColumnCount();
   Value v(TypeId::INVALID);
   std::vector<Value> values;
   // iterate through schema, generate column value to insert
-  for (int i = 0; i < column_count; i++) {
+  for (int i = 0; i < schema->GetColumnCount(); i++) {
     TypeId type = schema->GetType(i);
+    bool is_set = i < column_count;
 
     switch (type) {
     case TypeId::BOOLEAN:
     case TypeId::INTEGER:
     case TypeId::SMALLINT:
     case TypeId::TINYINT:
-      v = Value(type, (int32_t)sqlite3_value_int(argv[i]));
+      v = Value(type, is_set ? (int32_t)sqlite3_value_int(argv[i]) : 0);
       break;
     case TypeId::BIGINT:
-      v = Value(type, (int64_t)sqlite3_value_int64(argv[i]));
+      v = Value(type, is_set ? (int64_t)sqlite3_value_int64(argv[i]) : 0);
       break;
     case TypeId::DECIMAL:
-      v = Value(type, sqlite3_value_double(argv[i]));
+      v = Value(type, is_set ? sqlite3_value_double(argv[i]) : 0.0);
       break;
     case TypeId::VARCHAR:
-      v = Value(type, std::string(reinterpret_cast<const char *>(
-                          sqlite3_value_text(argv[i]))));
+      v = Value(type, is_set ? std::string(reinterpret_cast<const char *>(
+                                   sqlite3_value_text(argv[i])))
+                             : std::string());
       break;
     default:
       break;
@@ -508,6 +740,32 @@ Tuple ConstructTuple(Schema *schema, sqlite3_value **argv) {
   return tuple;
 }
 
+/*
+ * Helper function to check that value converts to a column of type without
+ * changing, e.g. 2.5 does not fit an integer column and 300 no tinyint column
+ */
+bool IsExactValue(TypeId type, sqlite3_value *value) {
+  int value_type = sqlite3_value_type(value);
+  sqlite3_int64 i = sqlite3_value_int64(value);
+  switch (type) {
+  case TypeId::BOOLEAN:
+  case TypeId::TINYINT:
+    return value_type == SQLITE_INTEGER && i >= INT8_MIN && i <= INT8_MAX;
+  case TypeId::SMALLINT:
+    return value_type == SQLITE_INTEGER && i >= INT16_MIN && i <= INT16_MAX;
+  case TypeId::INTEGER:
+    return value_type == SQLITE_INTEGER && i >= INT32_MIN && i <= INT32_MAX;
+  case TypeId::BIGINT:
+    return value_type == SQLITE_INTEGER;
+  case TypeId::DECIMAL:
+    return value_type == SQLITE_INTEGER || value_type == SQLITE_FLOAT;
+  case TypeId::VARCHAR:
+    return value_type == SQLITE_TEXT;
+  default:
+    return false;
+  }
+}
+
 // serve the functionality of index factory
 Index *ConstructIndex(IndexMetadata *metadata,
                       BufferPoolManager *buffer_pool_manager,
@@ -518,6 +776,25 @@ Index *ConstructIndex(IndexMetadata *metadata,
   // for each varchar attribute, we assume the largest size is 16 bytes
   key_size += 16 * key_schema->GetUnlinedColumnCount();
 
+  if (metadata->GetIndexType() == IndexType::HashTableIndex) {
+    if (key_size <= 4) {
+      return new HashTableIndex<GenericKey<4>, RID, GenericComparator<4>>(
+          metadata, buffer_pool_manager, root_id);
+    } else if (key_size <= 8) {
+      return new HashTableIndex<GenericKey<8>, RID, GenericComparator<8>>(
+          metadata, buffer_pool_manager, root_id);
+    } else if (key_size <= 16) {
+      return new HashTableIndex<GenericKey<16>, RID, GenericComparator<16>>(
+          metadata, buffer_pool_manager, root_id);
+    } else if (key_size <= 32) {
+      return new HashTableIndex<GenericKey<32>, RID, GenericComparator<32>>(
+          metadata, buffer_pool_manager, root_id);
+    } else {
+      return new HashTableIndex<GenericKey<64>, RID, GenericComparator<64>>(
+          metadata, buffer_pool_manager, root_id);
+    }
+  }
+
   if (key_size <= 4) {
     return new BPlusTreeIndex<GenericKey<4>, RID, GenericComparator<4>>(
         metadata, buffer_pool_manager, root_id);
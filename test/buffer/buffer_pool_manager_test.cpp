@@ -2,7 +2,15 @@
  * buffer_pool_manager_test.cpp
  */
 
+#include <atomic>
+#include <chrono>
 #include <cstdio>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
 
 #include "buffer/buffer_pool_manager.h"
 #include "gtest/gtest.h"
@@ -46,4 +54,374 @@ TEST(BufferPoolManagerTest, SampleTest) {
   remove("test.db");
 }
 
+TEST(BufferPoolManagerTest, ShardedTest) {
+  page_id_t temp_page_id;
+  BufferPoolManager bpm(8, "test.db", 4);
+  EXPECT_EQ(4, bpm.GetNumShards());
+
+  // every shard holds two frames, page ids are spread round robin
+  for (int i = 0; i < 8; ++i) {
+    auto page = bpm.NewPage(temp_page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(i, temp_page_id);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", i);
+  }
+  // the whole pool is pinned
+  EXPECT_EQ(nullptr, bpm.NewPage(temp_page_id));
+
+  // only one shard has evictable frames, new pages still get them
+  EXPECT_EQ(true, bpm.UnpinPage(1, true));
+  EXPECT_EQ(true, bpm.UnpinPage(5, true));
+  std::vector<page_id_t> new_page_ids;
+  for (int i = 0; i < 2; ++i) {
+    ASSERT_NE(nullptr, bpm.NewPage(temp_page_id));
+    EXPECT_EQ(1, temp_page_id % 4);
+    new_page_ids.push_back(temp_page_id);
+  }
+  EXPECT_EQ(nullptr, bpm.NewPage(temp_page_id));
+
+  // unpin all the pages, each shard evicts its own pages to make room
+  for (int i = 0; i < 8; ++i) {
+    if (i % 4 != 1) {
+      EXPECT_EQ(true, bpm.UnpinPage(i, true));
+    }
+  }
+  for (auto page_id : new_page_ids) {
+    EXPECT_EQ(true, bpm.UnpinPage(page_id, false));
+  }
+  // the page ids skipped over were given back
+  ASSERT_NE(nullptr, bpm.NewPage(temp_page_id));
+  EXPECT_EQ(8, temp_page_id);
+  EXPECT_EQ(true, bpm.UnpinPage(temp_page_id, false));
+  for (int i = 0; i < 8; ++i) {
+    ASSERT_NE(nullptr, bpm.NewPage(temp_page_id));
+    EXPECT_EQ(true, bpm.UnpinPage(temp_page_id, false));
+  }
+
+  // evicted pages were written back
+  for (int i = 0; i < 8; ++i) {
+    auto page = bpm.FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ("page " + std::to_string(i), std::string(page->GetData()));
+    EXPECT_EQ(true, bpm.UnpinPage(i, false));
+    EXPECT_EQ(false, bpm.UnpinPage(i, false));
+  }
+
+  remove("test.db");
+}
+
+TEST(BufferPoolManagerTest, ShardedConcurrentTest) {
+  const int num_threads = 8;
+  const int num_pages = 64;
+  BufferPoolManager bpm(16, "test.db", 4);
+
+  page_id_t temp_page_id;
+  for (int i = 0; i < num_pages; ++i) {
+    auto page = bpm.NewPage(temp_page_id);
+    ASSERT_NE(nullptr, page);
+    memcpy(page->GetData(), &temp_page_id, sizeof(page_id_t));
+    EXPECT_EQ(true, bpm.UnpinPage(temp_page_id, true));
+  }
+
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; ++tid) {
+    threads.push_back(std::thread([&bpm, tid]() {
+      for (int i = 0; i < 200; ++i) {
+        page_id_t page_id = (i * 7 + tid) % num_pages;
+        auto page = bpm.FetchPage(page_id);
+        if (page == nullptr)
+          continue;
+        EXPECT_EQ(page_id, *reinterpret_cast<page_id_t *>(page->GetData()));
+        EXPECT_EQ(true, bpm.UnpinPage(page_id, false));
+      }
+    }));
+  }
+  for (auto &thread : threads)
+    thread.join();
+
+  remove("test.db");
+}
+
+TEST(BufferPoolManagerTest, ResidentConcurrentTest) {
+  const int num_readers = 4;
+  const int num_hot_pages = 8;
+  BufferPoolManager bpm(32, "test.db", 2);
+
+  page_id_t temp_page_id;
+  for (int i = 0; i < 64; ++i) {
+    auto page = bpm.NewPage(temp_page_id);
+    ASSERT_NE(nullptr, page);
+    memcpy(page->GetData(), &temp_page_id, sizeof(page_id_t));
+    EXPECT_EQ(true, bpm.UnpinPage(temp_page_id, true));
+  }
+
+  // readers mostly hit the hot pages without the shard latch while a writer
+  // cycles the cold pages through the same frames
+  std::atomic<bool> done(false);
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_readers; ++tid) {
+    threads.push_back(std::thread([&bpm, &done, tid]() {
+      for (int i = 0; !done; ++i) {
+        page_id_t page_id = (i + tid) % num_hot_pages;
+        auto page = bpm.FetchPage(page_id);
+        if (page == nullptr)
+          continue;
+        EXPECT_EQ(page_id, page->GetPageId());
+        EXPECT_EQ(page_id, *reinterpret_cast<page_id_t *>(page->GetData()));
+        EXPECT_EQ(true, bpm.UnpinPage(page_id, false));
+      }
+    }));
+  }
+  for (int i = 0; i < 2000; ++i) {
+    page_id_t page_id = num_hot_pages + i % (64 - num_hot_pages);
+    auto page = bpm.FetchPage(page_id);
+    if (page == nullptr)
+      continue;
+    EXPECT_EQ(page_id, *reinterpret_cast<page_id_t *>(page->GetData()));
+    EXPECT_EQ(true, bpm.UnpinPage(page_id, false));
+  }
+  done = true;
+  for (auto &thread : threads)
+    thread.join();
+
+  remove("test.db");
+}
+
+TEST(BufferPoolManagerTest, ResizeTest) {
+  remove("test.db");
+  const int num_pages = 32;
+  BufferPoolManager bpm(8, "test.db", 2);
+
+  // grow so that every page stays cached
+  bpm.Resize(num_pages);
+  EXPECT_EQ(static_cast<size_t>(num_pages), bpm.GetPoolSize());
+  EXPECT_EQ(static_cast<size_t>(num_pages), bpm.GetNumFrames());
+  page_id_t temp_page_id;
+  for (int i = 0; i < num_pages; ++i) {
+    auto page = bpm.NewPage(temp_page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", temp_page_id);
+  }
+  // pinned frames are kept until they are unpinned
+  bpm.Resize(4);
+  EXPECT_EQ(4u, bpm.GetPoolSize());
+  EXPECT_EQ(static_cast<size_t>(num_pages), bpm.GetNumFrames());
+  for (int i = 0; i < num_pages; ++i)
+    EXPECT_EQ(true, bpm.UnpinPage(i, true));
+  EXPECT_EQ(4u, bpm.GetNumFrames());
+  // at least one frame per shard
+  bpm.Resize(0);
+  EXPECT_EQ(2u, bpm.GetPoolSize());
+  EXPECT_EQ(2u, bpm.GetNumFrames());
+
+  // the evicted pages were written back
+  bpm.Resize(16);
+  EXPECT_EQ(16u, bpm.GetNumFrames());
+  // a pool that cannot be mapped leaves the current one in place
+  EXPECT_THROW(bpm.Resize(size_t(1) << 40), std::bad_alloc);
+  EXPECT_EQ(16u, bpm.GetPoolSize());
+  EXPECT_EQ(16u, bpm.GetNumFrames());
+  char expected[PAGE_SIZE];
+  for (int i = 0; i < num_pages; ++i) {
+    auto page = bpm.FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    snprintf(expected, PAGE_SIZE, "page %d", i);
+    EXPECT_STREQ(expected, page->GetData());
+    EXPECT_EQ(true, bpm.UnpinPage(i, false));
+  }
+
+  // resizing under concurrent traffic
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < 4; ++tid) {
+    threads.push_back(std::thread([&bpm, tid]() {
+      char expected[PAGE_SIZE];
+      for (int i = 0; i < 500; ++i) {
+        page_id_t page_id = (i * 7 + tid) % num_pages;
+        auto page = bpm.FetchPage(page_id);
+        if (page == nullptr)
+          continue;
+        snprintf(expected, PAGE_SIZE, "page %d", page_id);
+        EXPECT_STREQ(expected, page->GetData());
+        EXPECT_EQ(true, bpm.UnpinPage(page_id, i % 3 == 0));
+      }
+    }));
+  }
+  for (int i = 0; i < 50; ++i)
+    bpm.Resize(i % 2 == 0 ? 6 : 40);
+  for (auto &thread : threads)
+    thread.join();
+  EXPECT_EQ(40u, bpm.GetNumFrames());
+
+  remove("test.db");
+}
+
+TEST(BufferPoolManagerTest, PrefetchTest) {
+  remove("test.db");
+  BufferPoolManager bpm(8, "test.db", 2);
+
+  page_id_t temp_page_id;
+  for (int i = 0; i < 32; ++i) {
+    auto page = bpm.NewPage(temp_page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", temp_page_id);
+    EXPECT_EQ(true, bpm.UnpinPage(temp_page_id, true));
+  }
+
+  // prefetched pages are cached unpinned, beyond the last page is ignored
+  bpm.Prefetch(4, 4);
+  bpm.Prefetch(30, 10);
+  for (int i = 4; i < 8; ++i) {
+    auto page = bpm.FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ("page " + std::to_string(i), std::string(page->GetData()));
+    EXPECT_EQ(true, bpm.UnpinPage(i, false));
+    EXPECT_EQ(false, bpm.UnpinPage(i, false));
+  }
+
+  // a fully pinned pool skips the prefetch instead of failing
+  for (int i = 0; i < 8; ++i)
+    ASSERT_NE(nullptr, bpm.FetchPage(i));
+  bpm.Prefetch(16, 8);
+  EXPECT_EQ(nullptr, bpm.FetchPage(16));
+  for (int i = 0; i < 8; ++i)
+    EXPECT_EQ(true, bpm.UnpinPage(i, false));
+
+  remove("test.db");
+}
+
+TEST(BufferPoolManagerTest, FlusherTest) {
+  remove("test.db");
+  const int num_pages = 60;
+  BufferPoolManager bpm(100, "test.db", 4);
+  EXPECT_EQ(BufferPoolManager::LOW_WATERMARK, bpm.GetLowWatermark());
+  EXPECT_EQ(BufferPoolManager::HIGH_WATERMARK, bpm.GetHighWatermark());
+  // out of range watermarks are clamped
+  bpm.SetDirtyWatermarks(0.5, 2.0);
+  EXPECT_EQ(0.5, bpm.GetLowWatermark());
+  EXPECT_EQ(1.0, bpm.GetHighWatermark());
+  bpm.SetDirtyWatermarks(0.2, 0.1);
+  EXPECT_EQ(0.1, bpm.GetLowWatermark());
+  EXPECT_EQ(0.1, bpm.GetHighWatermark());
+  bpm.SetDirtyWatermarks(0.0, 0.3);
+
+  // pinned pages are never written behind the user's back
+  page_id_t pinned_page_id;
+  Page *pinned_page = bpm.NewPage(pinned_page_id);
+  ASSERT_NE(nullptr, pinned_page);
+  ASSERT_NE(nullptr, bpm.FetchPage(pinned_page_id));
+  EXPECT_EQ(true, bpm.UnpinPage(pinned_page_id, true));
+
+  page_id_t temp_page_id;
+  for (int i = 1; i < num_pages; ++i) {
+    auto page = bpm.NewPage(temp_page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", temp_page_id);
+    EXPECT_EQ(true, bpm.UnpinPage(temp_page_id, true));
+  }
+
+  // the flusher cleans everything that is unpinned
+  for (int i = 0; i < 200 && bpm.GetDirtyPageCount() > 1; ++i)
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  EXPECT_EQ(1, bpm.GetDirtyPageCount());
+  DiskManager disk_manager("test.db");
+  char buffer[PAGE_SIZE];
+  for (int i = 1; i < num_pages; ++i) {
+    disk_manager.ReadPage(i, buffer);
+    EXPECT_EQ("page " + std::to_string(i), std::string(buffer));
+  }
+  EXPECT_EQ(true, bpm.UnpinPage(pinned_page_id, false));
+
+  remove("test.db");
+}
+
+TEST(BufferPoolManagerTest, StatsTest) {
+  remove("test.db");
+  BufferPoolManager bpm(4, "test.db");
+  // keep the flusher from cleaning pages behind the test's back
+  bpm.SetDirtyWatermarks(1.0, 1.0);
+  const BufferPoolStats &stats = bpm.GetStats();
+
+  page_id_t temp_page_id;
+  for (int i = 0; i < 4; ++i) {
+    ASSERT_NE(nullptr, bpm.NewPage(temp_page_id));
+    EXPECT_EQ(true, bpm.UnpinPage(temp_page_id, true));
+  }
+  // page 0 is the dirty victim
+  ASSERT_NE(nullptr, bpm.NewPage(temp_page_id));
+  EXPECT_EQ(true, bpm.UnpinPage(temp_page_id, false));
+  EXPECT_EQ(1u, stats.Get(BufferPoolStats::EVICTIONS));
+  EXPECT_EQ(1u, stats.Get(BufferPoolStats::WRITE_BACKS));
+
+  for (int i = 0; i < 2; ++i) {
+    ASSERT_NE(nullptr, bpm.FetchPage(1));
+    EXPECT_EQ(true, bpm.UnpinPage(1, false));
+  }
+  EXPECT_EQ(2u, stats.Get(BufferPoolStats::HITS));
+  EXPECT_EQ(0u, stats.Get(BufferPoolStats::MISSES));
+
+  // page 2 is the next dirty victim
+  ASSERT_NE(nullptr, bpm.FetchPage(0));
+  EXPECT_EQ(true, bpm.UnpinPage(0, false));
+  EXPECT_EQ(1u, stats.Get(BufferPoolStats::MISSES));
+  EXPECT_EQ(2u, stats.Get(BufferPoolStats::EVICTIONS));
+  EXPECT_EQ(2u, stats.Get(BufferPoolStats::WRITE_BACKS));
+
+  // counts from other threads add up
+  std::thread thread([&bpm]() {
+    ASSERT_NE(nullptr, bpm.FetchPage(1));
+    EXPECT_EQ(true, bpm.UnpinPage(1, false));
+  });
+  thread.join();
+  EXPECT_EQ(3u, stats.Get(BufferPoolStats::HITS));
+
+  std::map<page_id_t, uint64_t> access_counts;
+  for (auto &entry : bpm.GetPageAccessCounts())
+    access_counts.insert(entry);
+  std::map<page_id_t, uint64_t> expected = {{0, 1}, {1, 4}, {3, 1}, {4, 1}};
+  EXPECT_EQ(expected, access_counts);
+  EXPECT_STREQ("hits", BufferPoolStats::GetName(BufferPoolStats::HITS));
+
+  remove("test.db");
+}
+
+// Fetch/unpin throughput over a fully resident working set, run with
+// --gtest_also_run_disabled_tests
+TEST(BufferPoolManagerTest, DISABLED_ScalingBenchmark) {
+  const int pool_size = 1024;
+  const int num_pages = 512;
+  const int ops_per_thread = 200000;
+
+  for (size_t num_shards : {1, 16, 64}) {
+    BufferPoolManager bpm(pool_size, "test.db", num_shards);
+    page_id_t temp_page_id;
+    for (int i = 0; i < num_pages; ++i) {
+      ASSERT_NE(nullptr, bpm.NewPage(temp_page_id));
+      bpm.UnpinPage(temp_page_id, true);
+    }
+    for (int num_threads = 1; num_threads <= 64; num_threads *= 2) {
+      std::vector<std::thread> threads;
+      auto start = std::chrono::steady_clock::now();
+      for (int tid = 0; tid < num_threads; ++tid) {
+        threads.push_back(std::thread([&bpm, tid]() {
+          std::mt19937 gen(tid);
+          std::uniform_int_distribution<page_id_t> dist(0, num_pages - 1);
+          for (int i = 0; i < ops_per_thread; ++i) {
+            page_id_t page_id = dist(gen);
+            if (bpm.FetchPage(page_id) != nullptr)
+              bpm.UnpinPage(page_id, false);
+          }
+        }));
+      }
+      for (auto &thread : threads)
+        thread.join();
+      std::chrono::duration<double> elapsed =
+          std::chrono::steady_clock::now() - start;
+      std::cout << "shards " << num_shards << " threads " << num_threads
+                << ": " << (num_threads * ops_per_thread) / elapsed.count()
+                << " fetch/unpin per second" << std::endl;
+    }
+  }
+  remove("test.db");
+}
+
 } // namespace cmudb
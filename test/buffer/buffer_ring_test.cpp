@@ -0,0 +1,142 @@
+/**
+ * buffer_ring_test.cpp
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include "buffer/buffer_pool_manager.h"
+#include "gtest/gtest.h"
+
+namespace cmudb {
+
+namespace {
+const int num_hot_pages = 8;
+const int num_scan_pages = 100;
+
+// hot pages first, then the pages of the table to scan
+void CreatePages(BufferPoolManager *bpm) {
+  page_id_t page_id;
+  for (int i = 0; i < num_hot_pages + num_scan_pages; ++i) {
+    Page *page = bpm->NewPage(page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+    bpm->UnpinPage(page_id, true);
+  }
+  bpm->FlushAllPages();
+}
+
+// scribble over the hot pages on disk, a cached hot page still shows the
+// original content when fetched
+void ScribbleHotPages() {
+  DiskManager disk_manager("test.db");
+  char data[PAGE_SIZE];
+  memset(data, 0, PAGE_SIZE);
+  strcpy(data, "scribbled");
+  for (int i = 0; i < num_hot_pages; ++i)
+    disk_manager.WritePage(i, data);
+}
+
+int CountCachedHotPages(BufferPoolManager *bpm) {
+  int cached = 0;
+  for (int i = 0; i < num_hot_pages; ++i) {
+    Page *page = bpm->FetchPage(i);
+    EXPECT_NE(nullptr, page);
+    if (std::string(page->GetData()) == "page " + std::to_string(i))
+      cached++;
+    bpm->UnpinPage(i, false);
+  }
+  return cached;
+}
+} // namespace
+
+TEST(BufferRingTest, ScanResistanceTest) {
+  remove("test.db");
+  BufferPoolManager bpm(20, "test.db");
+  CreatePages(&bpm);
+  for (int i = 0; i < num_hot_pages; ++i) {
+    ASSERT_NE(nullptr, bpm.FetchPage(i));
+    bpm.UnpinPage(i, false);
+  }
+
+  {
+    BufferRing ring(&bpm, 4);
+    EXPECT_EQ(4, ring.GetSize());
+    for (int i = num_hot_pages; i < num_hot_pages + num_scan_pages; ++i) {
+      Page *page = bpm.FetchPage(i, &ring);
+      ASSERT_NE(nullptr, page);
+      EXPECT_EQ("page " + std::to_string(i), std::string(page->GetData()));
+      // a dirty ring page is written back when its frame is recycled
+      if (i % 10 == 0)
+        strcat(page->GetData(), "!");
+      bpm.UnpinPage(i, i % 10 == 0);
+    }
+  }
+  ScribbleHotPages();
+  EXPECT_EQ(num_hot_pages, CountCachedHotPages(&bpm));
+
+  // all frames are back in the pool
+  for (int i = 0; i < 20; ++i)
+    ASSERT_NE(nullptr, bpm.FetchPage(num_hot_pages + i));
+  for (int i = 0; i < 20; ++i)
+    bpm.UnpinPage(num_hot_pages + i, false);
+  for (int i = 10; i < num_hot_pages + num_scan_pages; i += 10) {
+    Page *page = bpm.FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ("page " + std::to_string(i) + "!", std::string(page->GetData()));
+    bpm.UnpinPage(i, false);
+  }
+
+  remove("test.db");
+}
+
+TEST(BufferRingTest, WithoutRingTest) {
+  remove("test.db");
+  BufferPoolManager bpm(20, "test.db");
+  CreatePages(&bpm);
+  for (int i = 0; i < num_hot_pages; ++i) {
+    ASSERT_NE(nullptr, bpm.FetchPage(i));
+    bpm.UnpinPage(i, false);
+  }
+
+  // the same scan through the replacer flushes the hot pages out
+  for (int i = num_hot_pages; i < num_hot_pages + num_scan_pages; ++i) {
+    ASSERT_NE(nullptr, bpm.FetchPage(i));
+    bpm.UnpinPage(i, false);
+  }
+  ScribbleHotPages();
+  EXPECT_EQ(0, CountCachedHotPages(&bpm));
+
+  remove("test.db");
+}
+
+TEST(BufferRingTest, PinnedRingTest) {
+  remove("test.db");
+  BufferPoolManager bpm(16, "test.db", 2);
+  CreatePages(&bpm);
+
+  BufferRing *ring = new BufferRing(&bpm, 4);
+  EXPECT_EQ(4, ring->GetSize());
+  // more pages pinned than the ring holds, the rest comes from the pool
+  for (int i = 0; i < 8; ++i)
+    ASSERT_NE(nullptr, bpm.FetchPage(i, ring));
+  // prefetching through a fully pinned ring still works
+  bpm.Prefetch(20, 4, ring);
+  for (int i = 20; i < 24; ++i) {
+    Page *page = bpm.FetchPage(i, ring);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ("page " + std::to_string(i), std::string(page->GetData()));
+    bpm.UnpinPage(i, false);
+  }
+  // the ring may go away while its pages are still pinned
+  delete ring;
+  for (int i = 0; i < 8; ++i)
+    EXPECT_EQ(true, bpm.UnpinPage(i, false));
+  for (int i = 0; i < 16; ++i)
+    ASSERT_NE(nullptr, bpm.FetchPage(30 + i));
+
+  remove("test.db");
+}
+
+} // namespace cmudb
@@ -0,0 +1,46 @@
+/**
+ * clock_replacer_test.cpp
+ */
+
+#include <cstdio>
+
+#include "buffer/clock_replacer.h"
+#include "gtest/gtest.h"
+
+namespace cmudb {
+
+TEST(ClockReplacerTest, SampleTest) {
+  ClockReplacer<int> clock_replacer;
+
+  clock_replacer.Insert(1);
+  clock_replacer.Insert(2);
+  clock_replacer.Insert(3);
+  clock_replacer.Insert(4);
+  clock_replacer.Insert(1);
+  EXPECT_EQ(4, clock_replacer.Size());
+
+  // first sweep clears all the reference bits, then 1 goes
+  int value;
+  clock_replacer.Victim(value);
+  EXPECT_EQ(1, value);
+
+  // 3 gets a second chance, pinned 4 is skipped
+  clock_replacer.Insert(3);
+  EXPECT_EQ(true, clock_replacer.Erase(4));
+  EXPECT_EQ(false, clock_replacer.Erase(4));
+  EXPECT_EQ(false, clock_replacer.Erase(1));
+  EXPECT_EQ(2, clock_replacer.Size());
+
+  clock_replacer.Victim(value);
+  EXPECT_EQ(2, value);
+  clock_replacer.Victim(value);
+  EXPECT_EQ(3, value);
+  EXPECT_EQ(false, clock_replacer.Victim(value));
+
+  // unpinned 4 is evictable again
+  clock_replacer.Insert(4);
+  clock_replacer.Victim(value);
+  EXPECT_EQ(4, value);
+}
+
+} // namespace cmudb
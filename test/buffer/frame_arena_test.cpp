@@ -0,0 +1,69 @@
+/**
+ * frame_arena_test.cpp
+ */
+
+#include <cstdint>
+#include <cstring>
+
+#include "buffer/buffer_pool_manager.h"
+#include "buffer/frame_arena.h"
+#include "gtest/gtest.h"
+
+namespace cmudb {
+
+TEST(FrameArenaTest, LayoutTest) {
+  EXPECT_EQ(0u, sizeof(Page) % CACHE_LINE_SIZE);
+
+  // small enough for ordinary pages, and large enough for huge pages
+  for (size_t num_frames : {10, 3 * HUGE_PAGE_SIZE / PAGE_SIZE + 1}) {
+    FrameArena arena(num_frames);
+    EXPECT_EQ(num_frames, arena.GetNumFrames());
+    Page *pages = arena.GetPages();
+    for (size_t i = 0; i < num_frames; ++i) {
+      EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(&pages[i]) % CACHE_LINE_SIZE);
+      EXPECT_EQ(INVALID_PAGE_ID, pages[i].GetPageId());
+      EXPECT_EQ(0, pages[i].GetPinCount());
+      // contents are consecutive, page aligned and zeroed
+      char *data = pages[i].GetData();
+      EXPECT_EQ(pages[0].GetData() + i * PAGE_SIZE, data);
+      EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(data) % PAGE_SIZE);
+      EXPECT_EQ(0, data[0]);
+      EXPECT_EQ(0, data[PAGE_SIZE - 1]);
+      memset(data, static_cast<int>(i), PAGE_SIZE);
+    }
+    if (num_frames * PAGE_SIZE >= HUGE_PAGE_SIZE) {
+      EXPECT_EQ(0u,
+                reinterpret_cast<uintptr_t>(pages[0].GetData()) %
+                    HUGE_PAGE_SIZE);
+    }
+    for (size_t i = 0; i < num_frames; ++i)
+      EXPECT_EQ(static_cast<char>(i), pages[i].GetData()[PAGE_SIZE / 2]);
+  }
+}
+
+TEST(FrameArenaTest, BufferPoolTest) {
+  remove("test.db");
+  {
+    BufferPoolManager bpm(2 * HUGE_PAGE_SIZE / PAGE_SIZE, "test.db", 4);
+    page_id_t page_id;
+    for (int i = 0; i < 8; ++i) {
+      Page *page = bpm.NewPage(page_id);
+      ASSERT_NE(nullptr, page);
+      snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+      EXPECT_TRUE(bpm.UnpinPage(page_id, true));
+    }
+  }
+  BufferPoolManager bpm(10, "test.db");
+  EXPECT_FALSE(bpm.IsUsingHugePages());
+  char expected[PAGE_SIZE];
+  for (int i = 0; i < 8; ++i) {
+    Page *page = bpm.FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    snprintf(expected, PAGE_SIZE, "page %d", i);
+    EXPECT_STREQ(expected, page->GetData());
+    EXPECT_TRUE(bpm.UnpinPage(i, false));
+  }
+  remove("test.db");
+}
+
+} // namespace cmudb
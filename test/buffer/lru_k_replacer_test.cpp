@@ -0,0 +1,69 @@
+/**
+ * lru_k_replacer_test.cpp
+ */
+
+#include <cstdio>
+
+#include "buffer/lru_k_replacer.h"
+#include "gtest/gtest.h"
+
+namespace cmudb {
+
+TEST(LRUKReplacerTest, SampleTest) {
+  LRUKReplacer<int> lru_k_replacer(2, 0);
+
+  // 1 and 2 are referenced twice, the others only once
+  lru_k_replacer.Insert(1);
+  lru_k_replacer.Insert(2);
+  lru_k_replacer.Insert(3);
+  lru_k_replacer.Insert(4);
+  lru_k_replacer.Insert(1);
+  lru_k_replacer.Insert(2);
+  lru_k_replacer.Insert(5);
+  EXPECT_EQ(5, lru_k_replacer.Size());
+
+  // values with less than two references go first, oldest first
+  int value;
+  lru_k_replacer.Victim(value);
+  EXPECT_EQ(3, value);
+  lru_k_replacer.Victim(value);
+  EXPECT_EQ(4, value);
+
+  // pinning keeps the history
+  EXPECT_EQ(true, lru_k_replacer.Erase(5));
+  EXPECT_EQ(false, lru_k_replacer.Erase(5));
+  EXPECT_EQ(false, lru_k_replacer.Erase(3));
+  EXPECT_EQ(2, lru_k_replacer.Size());
+  lru_k_replacer.Insert(5);
+
+  // 5 now has two references but its second to last one is the newest
+  lru_k_replacer.Victim(value);
+  EXPECT_EQ(1, value);
+  lru_k_replacer.Victim(value);
+  EXPECT_EQ(2, value);
+  lru_k_replacer.Victim(value);
+  EXPECT_EQ(5, value);
+  EXPECT_EQ(false, lru_k_replacer.Victim(value));
+}
+
+TEST(LRUKReplacerTest, CorrelatedReferenceTest) {
+  LRUKReplacer<int> lru_k_replacer(2, 1);
+
+  // back-to-back references count once
+  lru_k_replacer.Insert(1);
+  lru_k_replacer.Insert(1);
+  lru_k_replacer.Insert(1);
+  lru_k_replacer.Insert(2);
+  lru_k_replacer.Insert(3);
+  lru_k_replacer.Insert(2);
+
+  int value;
+  lru_k_replacer.Victim(value);
+  EXPECT_EQ(1, value);
+  lru_k_replacer.Victim(value);
+  EXPECT_EQ(3, value);
+  lru_k_replacer.Victim(value);
+  EXPECT_EQ(2, value);
+}
+
+} // namespace cmudb
@@ -0,0 +1,119 @@
+/**
+ * page_guard_test.cpp
+ */
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <utility>
+
+#include "buffer/buffer_pool_manager.h"
+#include "gtest/gtest.h"
+
+namespace cmudb {
+
+TEST(PageGuardTest, ReadWriteGuardTest) {
+  remove("test.db");
+  BufferPoolManager bpm(2, "test.db");
+
+  page_id_t page_id;
+  {
+    WritePageGuard guard = bpm.NewPageGuarded(page_id);
+    ASSERT_NE(nullptr, guard.GetPage());
+    EXPECT_EQ(1, guard.GetPage()->GetPinCount());
+    strcpy(guard.GetData(), "written");
+  }
+  // unpinned dirty, evicting it writes it back
+  page_id_t temp_page_id;
+  for (int i = 0; i < 2; ++i) {
+    ASSERT_NE(nullptr, bpm.NewPage(temp_page_id));
+    EXPECT_EQ(true, bpm.UnpinPage(temp_page_id, false));
+  }
+  {
+    ReadPageGuard guard = bpm.FetchPageRead(page_id);
+    ASSERT_NE(nullptr, guard.GetPage());
+    EXPECT_STREQ("written", guard.GetData());
+    EXPECT_EQ(page_id, guard.GetPageId());
+
+    // moving hands over the pin
+    ReadPageGuard other = std::move(guard);
+    EXPECT_EQ(nullptr, guard.GetPage());
+    EXPECT_EQ(1, other.GetPage()->GetPinCount());
+    // readers share the latch
+    ReadPageGuard second = bpm.FetchPageRead(page_id);
+    EXPECT_EQ(2, second.GetPage()->GetPinCount());
+    second.Release();
+    EXPECT_EQ(nullptr, second.GetPage());
+    EXPECT_EQ(1, other.GetPage()->GetPinCount());
+  }
+  Page *page = bpm.FetchPage(page_id);
+  EXPECT_EQ(1, page->GetPinCount());
+  EXPECT_EQ(true, bpm.UnpinPage(page_id, false));
+
+  // nothing to guard once every frame is pinned
+  ReadPageGuard guard1 = bpm.FetchPageRead(page_id);
+  WritePageGuard guard2 = bpm.NewPageGuarded(temp_page_id);
+  ASSERT_NE(nullptr, guard1.GetPage());
+  ASSERT_NE(nullptr, guard2.GetPage());
+  EXPECT_EQ(nullptr, bpm.FetchPageWrite(temp_page_id + 1).GetPage());
+  EXPECT_EQ(nullptr, bpm.FetchPageOptimistic(temp_page_id + 1).GetPage());
+
+  remove("test.db");
+}
+
+TEST(PageGuardTest, OptimisticGuardTest) {
+  remove("test.db");
+  BufferPoolManager bpm(4, "test.db");
+
+  page_id_t page_id;
+  bpm.NewPageGuarded(page_id);
+  OptimisticPageGuard guard = bpm.FetchPageOptimistic(page_id);
+  ASSERT_NE(nullptr, guard.GetPage());
+  EXPECT_EQ(1, guard.GetPage()->GetPinCount());
+  EXPECT_TRUE(guard.Validate());
+  // read latches do not invalidate
+  bpm.FetchPageRead(page_id);
+  EXPECT_TRUE(guard.Validate());
+  // a writer in between does
+  {
+    WritePageGuard writer = bpm.FetchPageWrite(page_id);
+    EXPECT_FALSE(guard.Validate());
+  }
+  EXPECT_FALSE(guard.Validate());
+  guard.Restart();
+  EXPECT_TRUE(guard.Validate());
+
+  // a reader racing with a writer never accepts a torn value
+  std::atomic<bool> done(false);
+  std::thread writer([&bpm, &done, page_id]() {
+    for (int i = 0; i < 2000; ++i) {
+      WritePageGuard page = bpm.FetchPageWrite(page_id);
+      int *data = reinterpret_cast<int *>(page.GetData());
+      data[0] = i;
+      data[1] = i;
+    }
+    done = true;
+  });
+  while (!done) {
+    guard.Restart();
+    int *data = reinterpret_cast<int *>(guard.GetData());
+    int first = data[0];
+    int second = data[1];
+    if (guard.Validate()) {
+      EXPECT_EQ(first, second);
+    }
+  }
+  writer.join();
+  guard.Restart();
+  EXPECT_TRUE(guard.Validate());
+  EXPECT_EQ(1999, reinterpret_cast<int *>(guard.GetData())[1]);
+  guard.Release();
+  Page *page = bpm.FetchPage(page_id);
+  EXPECT_EQ(1, page->GetPinCount());
+  EXPECT_EQ(true, bpm.UnpinPage(page_id, false));
+
+  remove("test.db");
+}
+
+} // namespace cmudb
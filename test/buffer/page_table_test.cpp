@@ -0,0 +1,89 @@
+/**
+ * page_table_test.cpp
+ */
+
+#include <atomic>
+#include <deque>
+#include <thread>
+#include <vector>
+
+#include "buffer/page_table.h"
+#include "gtest/gtest.h"
+
+namespace cmudb {
+
+TEST(PageTableTest, SampleTest) {
+  PageTable page_table(4);
+  std::deque<Page> pages;
+  for (int i = 0; i < 200; ++i)
+    pages.emplace_back(nullptr);
+
+  // strided page ids as cached by one shard of many, beyond the capacity
+  for (int i = 0; i < 200; ++i)
+    page_table.Insert(i * 8, &pages[i]);
+  EXPECT_EQ(200u, page_table.GetSize());
+  EXPECT_LE(400u, page_table.GetCapacity());
+  Page *page = nullptr;
+  for (int i = 0; i < 200; ++i) {
+    EXPECT_TRUE(page_table.Find(i * 8, page));
+    EXPECT_EQ(&pages[i], page);
+  }
+  EXPECT_FALSE(page_table.Find(1, page));
+
+  // overwrite
+  page_table.Insert(0, &pages[1]);
+  EXPECT_TRUE(page_table.Find(0, page));
+  EXPECT_EQ(&pages[1], page);
+  EXPECT_EQ(200u, page_table.GetSize());
+
+  // removing closes the gaps, the remaining entries stay reachable
+  for (int i = 0; i < 200; i += 2)
+    EXPECT_TRUE(page_table.Remove(i * 8));
+  EXPECT_FALSE(page_table.Remove(0));
+  EXPECT_EQ(100u, page_table.GetSize());
+  for (int i = 0; i < 200; ++i) {
+    EXPECT_EQ(i % 2 == 1, page_table.Find(i * 8, page));
+    if (i % 2 == 1) {
+      EXPECT_EQ(&pages[i], page);
+    }
+  }
+}
+
+TEST(PageTableTest, ConcurrentFindTest) {
+  PageTable page_table(16);
+  std::deque<Page> pages;
+  for (int i = 0; i < 64; ++i)
+    pages.emplace_back(nullptr);
+  // even page ids stay, odd ones come and go
+  for (int i = 0; i < 64; i += 2)
+    page_table.Insert(i, &pages[i]);
+
+  std::atomic<bool> done(false);
+  std::vector<std::thread> readers;
+  for (int tid = 0; tid < 4; ++tid) {
+    readers.push_back(std::thread([&page_table, &pages, &done]() {
+      Page *page = nullptr;
+      while (!done) {
+        for (int i = 0; i < 64; ++i) {
+          // a lookup racing with a writer may miss, but never returns the
+          // frame of another stable entry
+          if (page_table.Find(i, page) && i % 2 == 0) {
+            EXPECT_EQ(&pages[i], page);
+          }
+        }
+      }
+    }));
+  }
+  for (int round = 0; round < 2000; ++round) {
+    for (int i = 1; i < 64; i += 2)
+      page_table.Insert(i, &pages[i]);
+    for (int i = 1; i < 64; i += 2)
+      page_table.Remove(i);
+  }
+  done = true;
+  for (auto &reader : readers)
+    reader.join();
+  EXPECT_EQ(32u, page_table.GetSize());
+}
+
+} // namespace cmudb
@@ -0,0 +1,142 @@
+/**
+ * replacer_policy_test.cpp
+ */
+
+#include <cstdio>
+#include <iostream>
+#include <list>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "buffer/clock_replacer.h"
+#include "buffer/lru_k_replacer.h"
+#include "buffer/lru_replacer.h"
+#include "buffer/two_queue_replacer.h"
+#include "gtest/gtest.h"
+
+namespace cmudb {
+
+// replays a page reference string against pool_size frames managed by
+// replacer, every reference pins and immediately unpins its frame
+double ReplayHitRatio(Replacer<int> *replacer, int pool_size,
+                      const std::vector<page_id_t> &references) {
+  std::unordered_map<page_id_t, int> page_table;
+  std::vector<page_id_t> frame_page(pool_size, INVALID_PAGE_ID);
+  std::list<int> free_list;
+  for (int i = 0; i < pool_size; ++i)
+    free_list.push_back(i);
+
+  size_t hits = 0;
+  for (auto page_id : references) {
+    int frame;
+    auto it = page_table.find(page_id);
+    if (it != page_table.end()) {
+      frame = it->second;
+      replacer->Erase(frame);
+      hits++;
+    } else {
+      if (!free_list.empty()) {
+        frame = free_list.front();
+        free_list.pop_front();
+      } else {
+        EXPECT_TRUE(replacer->Victim(frame));
+        page_table.erase(frame_page[frame]);
+      }
+      frame_page[frame] = page_id;
+      page_table[page_id] = frame;
+    }
+    replacer->Insert(frame);
+  }
+  return static_cast<double>(hits) / references.size();
+}
+
+// point lookups descend a small index (root 0, inner pages 1-9, leaves 10-89)
+// while full scans sweep table pages 1000 onwards, touching each page
+// tuples_per_page times in a row
+std::vector<page_id_t> MixedWorkload(int rounds, int lookups_per_round,
+                                     int table_pages, int tuples_per_page) {
+  std::mt19937 gen(15445);
+  std::uniform_int_distribution<page_id_t> inner(1, 9);
+  std::uniform_int_distribution<page_id_t> leaf(10, 89);
+  std::vector<page_id_t> references;
+  for (int round = 0; round < rounds; ++round) {
+    for (int i = 0; i < lookups_per_round; ++i) {
+      references.push_back(0);
+      references.push_back(inner(gen));
+      references.push_back(leaf(gen));
+    }
+    for (page_id_t page_id = 1000; page_id < 1000 + table_pages; ++page_id) {
+      for (int i = 0; i < tuples_per_page; ++i)
+        references.push_back(page_id);
+    }
+  }
+  return references;
+}
+
+TEST(ReplacerPolicyTest, BufferPoolManagerTest) {
+  for (auto policy : {ReplacerPolicy::LRU, ReplacerPolicy::LRU_K,
+                      ReplacerPolicy::TWO_QUEUE, ReplacerPolicy::CLOCK}) {
+    page_id_t temp_page_id;
+    BufferPoolManager bpm(10, "test.db", 1, policy);
+    EXPECT_EQ(policy, bpm.GetReplacerPolicy());
+
+    for (int i = 0; i < 10; ++i) {
+      auto page = bpm.NewPage(temp_page_id);
+      ASSERT_NE(nullptr, page);
+      snprintf(page->GetData(), PAGE_SIZE, "page %d", i);
+    }
+    EXPECT_EQ(nullptr, bpm.NewPage(temp_page_id));
+    for (int i = 0; i < 10; ++i)
+      EXPECT_EQ(true, bpm.UnpinPage(i, true));
+    // evicts every page written so far
+    for (int i = 0; i < 10; ++i) {
+      ASSERT_NE(nullptr, bpm.NewPage(temp_page_id));
+      EXPECT_EQ(true, bpm.UnpinPage(temp_page_id, false));
+    }
+    for (int i = 0; i < 10; ++i) {
+      auto page = bpm.FetchPage(i);
+      ASSERT_NE(nullptr, page);
+      EXPECT_EQ("page " + std::to_string(i), std::string(page->GetData()));
+      EXPECT_EQ(true, bpm.UnpinPage(i, false));
+    }
+    remove("test.db");
+  }
+}
+
+TEST(ReplacerPolicyTest, ScanResistanceTest) {
+  auto references = MixedWorkload(10, 200, 300, 4);
+  LRUReplacer<int> lru;
+  LRUKReplacer<int> lru_k(2);
+  TwoQueueReplacer<int> two_queue(25);
+  double lru_hit_ratio = ReplayHitRatio(&lru, 100, references);
+  // the index survives the scans under the scan resistant policies
+  EXPECT_GT(ReplayHitRatio(&lru_k, 100, references), lru_hit_ratio);
+  EXPECT_GT(ReplayHitRatio(&two_queue, 100, references), lru_hit_ratio);
+}
+
+// Hit ratio of every policy for lookups mixed with full scans through a 100
+// frame pool, run with --gtest_also_run_disabled_tests
+TEST(ReplacerPolicyTest, DISABLED_MixedWorkloadBenchmark) {
+  const int pool_size = 100;
+  for (int tuples_per_page : {1, 8}) {
+    auto references = MixedWorkload(50, 200, 1000, tuples_per_page);
+    LRUReplacer<int> lru;
+    LRUKReplacer<int> lru_k(2);
+    TwoQueueReplacer<int> two_queue(pool_size / 4);
+    ClockReplacer<int> clock;
+    std::cout << "tuples per page " << tuples_per_page << std::endl;
+    std::cout << "  LRU   " << ReplayHitRatio(&lru, pool_size, references)
+              << std::endl;
+    std::cout << "  LRU-2 " << ReplayHitRatio(&lru_k, pool_size, references)
+              << std::endl;
+    std::cout << "  2Q    "
+              << ReplayHitRatio(&two_queue, pool_size, references)
+              << std::endl;
+    std::cout << "  CLOCK " << ReplayHitRatio(&clock, pool_size, references)
+              << std::endl;
+  }
+}
+
+} // namespace cmudb
@@ -0,0 +1,89 @@
+/**
+ * two_queue_replacer_test.cpp
+ */
+
+#include <cstdio>
+
+#include "buffer/two_queue_replacer.h"
+#include "gtest/gtest.h"
+
+namespace cmudb {
+
+TEST(TwoQueueReplacerTest, SampleTest) {
+  TwoQueueReplacer<int> two_queue_replacer(2);
+
+  // 1 and 2 get promoted to Am by their second reference
+  two_queue_replacer.Insert(1);
+  two_queue_replacer.Insert(2);
+  two_queue_replacer.Insert(1);
+  two_queue_replacer.Insert(2);
+  two_queue_replacer.Insert(3);
+  two_queue_replacer.Insert(4);
+  two_queue_replacer.Insert(5);
+  EXPECT_EQ(5, two_queue_replacer.Size());
+
+  // A1 holds more than two values, evict from it in FIFO order
+  int value;
+  two_queue_replacer.Victim(value);
+  EXPECT_EQ(3, value);
+
+  // A1 is back to its share, evict the least recently used value of Am
+  two_queue_replacer.Victim(value);
+  EXPECT_EQ(1, value);
+
+  EXPECT_EQ(true, two_queue_replacer.Erase(4));
+  EXPECT_EQ(false, two_queue_replacer.Erase(4));
+  EXPECT_EQ(false, two_queue_replacer.Erase(1));
+  EXPECT_EQ(2, two_queue_replacer.Size());
+
+  two_queue_replacer.Victim(value);
+  EXPECT_EQ(2, value);
+  two_queue_replacer.Victim(value);
+  EXPECT_EQ(5, value);
+  EXPECT_EQ(false, two_queue_replacer.Victim(value));
+}
+
+TEST(TwoQueueReplacerTest, CorrelatedReferenceTest) {
+  TwoQueueReplacer<int> two_queue_replacer(1);
+
+  two_queue_replacer.Insert(1);
+  two_queue_replacer.Insert(2);
+  two_queue_replacer.Insert(1);
+  // back-to-back references of 3 keep it in A1
+  two_queue_replacer.Insert(3);
+  two_queue_replacer.Erase(3);
+  two_queue_replacer.Insert(3);
+
+  int value;
+  two_queue_replacer.Victim(value);
+  EXPECT_EQ(2, value);
+  two_queue_replacer.Victim(value);
+  EXPECT_EQ(1, value);
+  two_queue_replacer.Victim(value);
+  EXPECT_EQ(3, value);
+}
+
+TEST(TwoQueueReplacerTest, SetA1MaxTest) {
+  TwoQueueReplacer<int> two_queue_replacer(1);
+
+  // 1 and 2 are in Am, 3 and 4 in A1
+  two_queue_replacer.Insert(1);
+  two_queue_replacer.Insert(2);
+  two_queue_replacer.Insert(1);
+  two_queue_replacer.Insert(2);
+  two_queue_replacer.Insert(3);
+  two_queue_replacer.Insert(4);
+
+  // A1 is within the larger share, evict from Am
+  two_queue_replacer.SetA1Max(2);
+  int value;
+  two_queue_replacer.Victim(value);
+  EXPECT_EQ(1, value);
+
+  // A1 exceeds the smaller share again
+  two_queue_replacer.SetA1Max(1);
+  two_queue_replacer.Victim(value);
+  EXPECT_EQ(3, value);
+}
+
+} // namespace cmudb
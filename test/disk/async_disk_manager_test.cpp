@@ -0,0 +1,193 @@
+/**
+ * async_disk_manager_test.cpp
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <future>
+#include <memory>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "disk/async_disk_manager.h"
+#include "gtest/gtest.h"
+
+namespace cmudb {
+
+TEST(AsyncDiskManagerTest, ReadWriteTest) {
+  remove("test.db");
+  DiskManager disk_manager("test.db");
+  AsyncDiskManager async_disk_manager(&disk_manager);
+  char data[PAGE_SIZE], buffer[PAGE_SIZE];
+
+  // reading beyond the end of file gives back a zeroed page
+  memset(buffer, 'x', PAGE_SIZE);
+  std::future<bool> read = async_disk_manager.ReadPageAsync(3, buffer);
+  async_disk_manager.Submit();
+  EXPECT_TRUE(read.get());
+  for (int i = 0; i < PAGE_SIZE; ++i)
+    ASSERT_EQ(0, buffer[i]);
+
+  // the data is copied, changing it after queueing has no effect
+  strcpy(data, "A test string.");
+  std::future<bool> write = async_disk_manager.WritePageAsync(3, data);
+  memset(data, 'y', PAGE_SIZE);
+  async_disk_manager.Submit();
+  EXPECT_TRUE(write.get());
+  EXPECT_EQ(4 * PAGE_SIZE, disk_manager.GetFileSize());
+
+  read = async_disk_manager.ReadPageAsync(3, buffer);
+  async_disk_manager.Submit();
+  EXPECT_TRUE(read.get());
+  EXPECT_STREQ("A test string.", buffer);
+
+  remove("test.db");
+}
+
+TEST(AsyncDiskManagerTest, BatchTest) {
+  remove("test.db");
+  const int num_pages = 200;
+  DiskManager disk_manager("test.db");
+  {
+    // a batch much larger than the queue depth
+    AsyncDiskManager async_disk_manager(&disk_manager, 8, 2);
+    char data[PAGE_SIZE];
+    std::vector<std::future<bool>> writes;
+    for (int i = 0; i < num_pages; ++i) {
+      memset(data, i, PAGE_SIZE);
+      writes.push_back(async_disk_manager.WritePageAsync(i, data));
+    }
+    async_disk_manager.Submit();
+    for (auto &write : writes)
+      EXPECT_TRUE(write.get());
+    EXPECT_EQ(num_pages * PAGE_SIZE, disk_manager.GetFileSize());
+
+    std::unique_ptr<char[]> buffers(new char[num_pages * PAGE_SIZE]);
+    std::vector<std::future<bool>> reads;
+    for (int i = 0; i < num_pages; ++i)
+      reads.push_back(
+          async_disk_manager.ReadPageAsync(i, &buffers[i * PAGE_SIZE]));
+    async_disk_manager.Submit();
+    for (int i = 0; i < num_pages; ++i) {
+      EXPECT_TRUE(reads[i].get());
+      EXPECT_EQ(static_cast<char>(i), buffers[i * PAGE_SIZE]);
+      EXPECT_EQ(static_cast<char>(i), buffers[(i + 1) * PAGE_SIZE - 1]);
+    }
+
+    // requests left unsubmitted are completed on destruction
+    memset(data, 'z', PAGE_SIZE);
+    async_disk_manager.WritePageAsync(0, data);
+  }
+  char buffer[PAGE_SIZE];
+  disk_manager.ReadPage(0, buffer);
+  EXPECT_EQ('z', buffer[0]);
+
+  remove("test.db");
+}
+
+TEST(AsyncDiskManagerTest, CoalescedWriteTest) {
+  remove("test.db");
+  DiskManager disk_manager("test.db");
+  char pages[4][PAGE_SIZE];
+  std::vector<const char *> data;
+  for (int i = 0; i < 4; ++i) {
+    memset(pages[i], 'a' + i, PAGE_SIZE);
+    data.push_back(pages[i]);
+  }
+  {
+    AsyncDiskManager async_disk_manager(&disk_manager);
+    // one write for pages 5 to 8, and one starting at the header page
+    std::future<bool> write = async_disk_manager.WritePagesAsync(5, data);
+    async_disk_manager.Submit();
+    EXPECT_TRUE(write.get());
+    EXPECT_EQ(9 * PAGE_SIZE, disk_manager.GetFileSize());
+    data.resize(2);
+    write = async_disk_manager.WritePagesAsync(HEADER_PAGE_ID, data);
+    async_disk_manager.Submit();
+    EXPECT_TRUE(write.get());
+  }
+  char buffer[PAGE_SIZE];
+  for (int i = 0; i < 4; ++i) {
+    disk_manager.ReadPage(5 + i, buffer);
+    EXPECT_EQ(0, memcmp(pages[i], buffer, PAGE_SIZE));
+  }
+  disk_manager.ReadPage(1, buffer);
+  EXPECT_EQ(0, memcmp(pages[1], buffer, PAGE_SIZE));
+
+  remove("test.db");
+}
+
+TEST(AsyncDiskManagerTest, WriteOrderTest) {
+  remove("test.db");
+  const int num_pages = 16;
+  const int rounds = 8;
+  DiskManager disk_manager("test.db");
+  {
+    AsyncDiskManager async_disk_manager(&disk_manager, 8, 2);
+    char data[PAGE_SIZE];
+    std::vector<std::future<bool>> writes;
+    // several writes of every page in one batch, adjacent pages get merged
+    // and the last write of a page must land last
+    for (int round = 0; round < rounds; ++round) {
+      for (int i = 1; i <= num_pages; ++i) {
+        memset(data, 'a' + round, PAGE_SIZE);
+        writes.push_back(async_disk_manager.WritePageAsync(i, data));
+      }
+    }
+    // a read queued behind the writes sees the last of them
+    char buffer[PAGE_SIZE];
+    std::future<bool> read = async_disk_manager.ReadPageAsync(1, buffer);
+    async_disk_manager.Submit();
+    EXPECT_TRUE(read.get());
+    EXPECT_EQ('a' + rounds - 1, buffer[PAGE_SIZE - 1]);
+    for (auto &write : writes)
+      EXPECT_TRUE(write.get());
+  }
+  char buffer[PAGE_SIZE];
+  for (int i = 1; i <= num_pages; ++i) {
+    disk_manager.ReadPage(i, buffer);
+    EXPECT_EQ('a' + rounds - 1, buffer[0]);
+    EXPECT_EQ('a' + rounds - 1, buffer[PAGE_SIZE - 1]);
+  }
+
+  remove("test.db");
+}
+
+TEST(AsyncDiskManagerTest, BufferPoolWriteBackTest) {
+  remove("test.db");
+  const int pool_size = 4;
+  const int num_pages = 64;
+  {
+    BufferPoolManager bpm(pool_size, "test.db");
+    page_id_t page_id;
+    // every new page evicts a dirty one whose write-back is asynchronous
+    for (int i = 0; i < num_pages; ++i) {
+      Page *page = bpm.NewPage(page_id);
+      ASSERT_NE(nullptr, page);
+      snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+      EXPECT_TRUE(bpm.UnpinPage(page_id, true));
+    }
+    // refetching must see the written data, also right after eviction
+    char expected[PAGE_SIZE];
+    for (int i = 0; i < num_pages; ++i) {
+      Page *page = bpm.FetchPage(i);
+      ASSERT_NE(nullptr, page);
+      snprintf(expected, PAGE_SIZE, "page %d", i);
+      EXPECT_STREQ(expected, page->GetData());
+      strcat(page->GetData(), "!");
+      EXPECT_TRUE(bpm.UnpinPage(i, true));
+    }
+  }
+  // everything is on disk once the pool is gone
+  DiskManager disk_manager("test.db");
+  char buffer[PAGE_SIZE], expected[PAGE_SIZE];
+  for (int i = 0; i < num_pages; ++i) {
+    disk_manager.ReadPage(i, buffer);
+    snprintf(expected, PAGE_SIZE, "page %d!", i);
+    EXPECT_STREQ(expected, buffer);
+  }
+
+  remove("test.db");
+}
+
+} // namespace cmudb
@@ -0,0 +1,159 @@
+/**
+ * disk_manager_test.cpp
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "disk/disk_manager.h"
+#include "gtest/gtest.h"
+
+namespace cmudb {
+
+TEST(DiskManagerTest, ReadWriteTest) {
+  remove("test.db");
+  char data[PAGE_SIZE], buffer[PAGE_SIZE];
+  {
+    DiskManager disk_manager("test.db");
+    EXPECT_EQ(0, disk_manager.GetFileSize());
+
+    // reading beyond the end of file gives back a zeroed page
+    memset(buffer, 'x', PAGE_SIZE);
+    disk_manager.ReadPage(3, buffer);
+    for (int i = 0; i < PAGE_SIZE; ++i)
+      ASSERT_EQ(0, buffer[i]);
+
+    strcpy(data, "A test string.");
+    disk_manager.WritePage(3, data);
+    EXPECT_EQ(4 * PAGE_SIZE, disk_manager.GetFileSize());
+    disk_manager.ReadPage(3, buffer);
+    EXPECT_EQ(0, memcmp(data, buffer, PAGE_SIZE));
+
+    // writing a page in the middle does not shrink the file
+    disk_manager.WritePage(1, data);
+    EXPECT_EQ(4 * PAGE_SIZE, disk_manager.GetFileSize());
+  }
+
+  // the file length is picked up again on restart
+  DiskManager disk_manager("test.db");
+  EXPECT_EQ(4 * PAGE_SIZE, disk_manager.GetFileSize());
+  disk_manager.ReadPage(1, buffer);
+  EXPECT_EQ(0, memcmp(data, buffer, PAGE_SIZE));
+
+  remove("test.db");
+}
+
+TEST(DiskManagerTest, ConcurrentReadWriteTest) {
+  remove("test.db");
+  const int num_threads = 8;
+  const int pages_per_thread = 32;
+  DiskManager disk_manager("test.db");
+
+  // every thread writes its own pages while reading back what it wrote
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; ++tid) {
+    threads.push_back(std::thread([&disk_manager, tid]() {
+      char data[PAGE_SIZE], buffer[PAGE_SIZE];
+      for (int i = 0; i < pages_per_thread; ++i) {
+        page_id_t page_id = i * num_threads + tid;
+        memset(data, page_id, PAGE_SIZE);
+        disk_manager.WritePage(page_id, data);
+        disk_manager.ReadPage(page_id, buffer);
+        EXPECT_EQ(0, memcmp(data, buffer, PAGE_SIZE));
+      }
+    }));
+  }
+  for (auto &thread : threads)
+    thread.join();
+  EXPECT_EQ(num_threads * pages_per_thread * PAGE_SIZE,
+            disk_manager.GetFileSize());
+
+  remove("test.db");
+}
+
+TEST(DiskManagerTest, PageReuseTest) {
+  remove("test.db");
+  char data[PAGE_SIZE];
+  memset(data, 0, PAGE_SIZE);
+  {
+    DiskManager disk_manager("test.db");
+    // without deallocation page ids are handed out in order
+    for (page_id_t i = 0; i < 10; ++i) {
+      EXPECT_EQ(i, disk_manager.AllocatePage());
+      disk_manager.WritePage(i, data);
+    }
+    // the header page and pages never allocated cannot be freed
+    disk_manager.DeallocatePage(HEADER_PAGE_ID);
+    disk_manager.DeallocatePage(100);
+
+    // the first deallocation puts a bitmap page at the end of the file
+    disk_manager.DeallocatePage(7);
+    disk_manager.DeallocatePage(3);
+    disk_manager.DeallocatePage(3);
+    EXPECT_EQ(11, disk_manager.GetNextPageId());
+
+    // freed pages are reused lowest first before the file grows
+    EXPECT_EQ(3, disk_manager.AllocatePage());
+    EXPECT_EQ(7, disk_manager.AllocatePage());
+    EXPECT_EQ(11, disk_manager.AllocatePage());
+    disk_manager.DeallocatePage(5);
+  }
+
+  // the bitmap and the allocation counter survive a restart, even though
+  // page 11 was never written
+  DiskManager disk_manager("test.db");
+  EXPECT_EQ(12, disk_manager.GetNextPageId());
+  EXPECT_EQ(5, disk_manager.AllocatePage());
+  EXPECT_EQ(12, disk_manager.AllocatePage());
+
+  remove("test.db");
+}
+
+TEST(DiskManagerTest, HeaderTrailerTest) {
+  remove("test.db");
+  char data[PAGE_SIZE], buffer[PAGE_SIZE];
+  {
+    DiskManager disk_manager("test.db");
+    for (page_id_t i = 0; i < 4; ++i)
+      disk_manager.AllocatePage();
+    disk_manager.DeallocatePage(2);
+
+    // rewriting the header page does not lose the bitmap anchor
+    memset(data, 'h', PAGE_SIZE);
+    disk_manager.WritePage(HEADER_PAGE_ID, data);
+    disk_manager.ReadPage(HEADER_PAGE_ID, buffer);
+    EXPECT_EQ(0, memcmp(data, buffer, PAGE_SIZE - HEADER_PAGE_RESERVED));
+  }
+
+  DiskManager disk_manager("test.db");
+  EXPECT_EQ(2, disk_manager.AllocatePage());
+
+  remove("test.db");
+}
+
+TEST(DiskManagerTest, BitmapChainTest) {
+  remove("test.db");
+  const page_id_t num_pages = DiskManager::BITMAP_PAGE_BITS + 100;
+  {
+    DiskManager disk_manager("test.db");
+    disk_manager.AllocatePage();
+    disk_manager.AllocatePage();
+    disk_manager.DeallocatePage(1);
+    // page 2 holds the first bitmap, the second one is appended on demand
+    for (page_id_t i = 1; i < num_pages; ++i)
+      disk_manager.AllocatePage();
+    EXPECT_EQ(num_pages + 2, disk_manager.GetNextPageId());
+    disk_manager.DeallocatePage(num_pages - 10);
+  }
+
+  DiskManager disk_manager("test.db");
+  EXPECT_EQ(num_pages + 2, disk_manager.GetNextPageId());
+  EXPECT_EQ(num_pages - 10, disk_manager.AllocatePage());
+  EXPECT_EQ(num_pages + 2, disk_manager.AllocatePage());
+
+  remove("test.db");
+}
+
+} // namespace cmudb
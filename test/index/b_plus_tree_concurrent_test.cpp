@@ -326,4 +326,125 @@ TEST(BPlusTreeConcurrentTest, MixTest) {
   remove("test.db");
 }
 
+TEST(BPlusTreeConcurrentTest, SplitMergeTest) {
+  // create KeyComparator and index schema
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+  BufferPoolManager *bpm = new BufferPoolManager(50, "test.db");
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(page_id);
+  (void)header_page;
+  // small pages, so that most writes split or merge
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree(
+      "foo_pk", bpm, comparator, INVALID_PAGE_ID, 4, 4);
+  const int64_t scale = 4000;
+  const uint64_t num_threads = 2;
+  std::vector<int64_t> keys;
+  for (int64_t key = 0; key < scale; key++)
+    keys.push_back(key);
+  InsertHelper(tree, keys);
+
+  // insert new keys, remove the odd ones and look up the even ones at once
+  std::vector<int64_t> insert_keys, remove_keys;
+  for (int64_t key = 0; key < scale; key++) {
+    insert_keys.push_back(scale + key);
+    if (key % 2 == 1)
+      remove_keys.push_back(key);
+  }
+  std::vector<std::thread> threads;
+  for (uint64_t i = 0; i < num_threads; i++) {
+    threads.push_back(std::thread(InsertHelperSplit, std::ref(tree),
+                                  insert_keys, num_threads, i));
+    threads.push_back(std::thread(DeleteHelperSplit, std::ref(tree),
+                                  remove_keys, num_threads, i));
+    threads.push_back(std::thread([&tree, scale]() {
+      GenericKey<8> index_key;
+      std::vector<RID> rids;
+      for (int64_t key = 0; key < scale; key += 2) {
+        rids.clear();
+        index_key.SetFromInteger(key);
+        EXPECT_TRUE(tree.GetValue(index_key, rids));
+      }
+    }));
+  }
+  for (auto &thread : threads)
+    thread.join();
+
+  int64_t size = 0;
+  int64_t last_key = -1;
+  for (auto iterator = tree.Begin(); iterator.isEnd() == false; ++iterator) {
+    int64_t key = (*iterator).second.GetSlotNum();
+    EXPECT_LT(last_key, key);
+    EXPECT_TRUE(key >= scale || key % 2 == 0);
+    last_key = key;
+    size = size + 1;
+  }
+  EXPECT_EQ(scale / 2 + scale, size);
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete key_schema;
+  delete bpm;
+  remove("test.db");
+}
+
+TEST(BPlusTreeConcurrentTest, AscendingInsertTest) {
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+  BufferPoolManager *bpm = new BufferPoolManager(50, "test.db");
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(page_id);
+  (void)header_page;
+  // small pages, so that the splits at the right edge keep running into
+  // each other
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree(
+      "foo_pk", bpm, comparator, INVALID_PAGE_ID, 4, 4);
+  const int64_t scale = 8000;
+  const uint64_t num_threads = 4;
+  std::vector<int64_t> keys;
+  for (int64_t key = 0; key < scale; key++)
+    keys.push_back(key);
+
+  // every thread appends its share of ascending keys, scans run meanwhile
+  std::vector<std::thread> threads;
+  for (uint64_t i = 0; i < num_threads; i++) {
+    threads.push_back(
+        std::thread(InsertHelperSplit, std::ref(tree), keys, num_threads, i));
+    threads.push_back(std::thread([&tree, scale]() {
+      GenericKey<8> index_key;
+      for (int64_t start_key = 0; start_key < scale; start_key += 1000) {
+        index_key.SetFromInteger(start_key);
+        int64_t last_key = start_key - 1;
+        for (auto iterator = tree.Begin(index_key); !iterator.isEnd();
+             ++iterator) {
+          int64_t key = (*iterator).second.GetSlotNum();
+          EXPECT_LT(last_key, key);
+          last_key = key;
+        }
+      }
+    }));
+  }
+  for (auto &thread : threads)
+    thread.join();
+
+  GenericKey<8> index_key;
+  std::vector<RID> rids;
+  for (auto key : keys) {
+    rids.clear();
+    index_key.SetFromInteger(key);
+    EXPECT_TRUE(tree.GetValue(index_key, rids));
+  }
+  int64_t size = 0;
+  for (auto iterator = tree.Begin(); !iterator.isEnd(); ++iterator) {
+    EXPECT_EQ(size, (*iterator).second.GetSlotNum());
+    size = size + 1;
+  }
+  EXPECT_EQ(scale, size);
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete key_schema;
+  delete bpm;
+  remove("test.db");
+}
+
 } // namespace cmudb
@@ -0,0 +1,85 @@
+/**
+ * b_plus_tree_index_test.cpp
+ */
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "index/b_plus_tree_index.h"
+#include "vtable/virtual_table.h"
+#include "gtest/gtest.h"
+
+namespace cmudb {
+
+TEST(BPlusTreeIndexTest, ScanRangeTest) {
+  Schema *schema = ParseCreateStatement("a int, b varchar");
+  BufferPoolManager *bpm = new BufferPoolManager(50, "test.db");
+  page_id_t page_id;
+  bpm->NewPage(page_id);
+  BPlusTreeIndex<GenericKey<16>, RID, GenericComparator<16>> index(
+      new IndexMetadata("foo_pk", "foo", schema, {0, 1}), bpm);
+  Schema *key_schema = index.GetKeySchema();
+
+  auto make_key = [&](int a, const std::string &b) {
+    return Tuple(std::vector<Value>{Value(TypeId::INTEGER, a),
+                                    Value(TypeId::VARCHAR, b)},
+                 key_schema);
+  };
+  std::vector<std::string> names = {"x", "y", "z"};
+  for (int a = 19; a >= 0; a--) {
+    for (int b = 0; b < 3; b++)
+      index.InsertEntry(make_key(a, names[b]), RID(a, b));
+  }
+
+  // the entries of scan in key order as a * 3 + b
+  auto scan = [&](const ScanBound &low, const ScanBound &high) {
+    std::vector<RID> result;
+    index.ScanRange(low, high, result);
+    std::vector<int> entries;
+    for (auto &rid : result)
+      entries.push_back(rid.GetPageId() * 3 + rid.GetSlotNum());
+    return entries;
+  };
+  auto range = [](int begin, int end) {
+    std::vector<int> entries;
+    for (int entry = begin; entry < end; entry++)
+      entries.push_back(entry);
+    return entries;
+  };
+  Tuple low_key = make_key(5, "y");
+  Tuple high_key = make_key(7, "y");
+
+  // bounded by the first column
+  EXPECT_EQ(range(15, 24), scan(ScanBound(&low_key, 1, true),
+                                ScanBound(&high_key, 1, true)));
+  EXPECT_EQ(range(18, 21), scan(ScanBound(&low_key, 1, false),
+                                ScanBound(&high_key, 1, false)));
+  EXPECT_EQ(range(15, 18), scan(ScanBound(&low_key, 1, true),
+                                ScanBound(&low_key, 1, true)));
+  EXPECT_EQ(range(0, 15), scan(ScanBound(), ScanBound(&low_key, 1, false)));
+  EXPECT_EQ(range(24, 60), scan(ScanBound(&high_key, 1, false), ScanBound()));
+  EXPECT_EQ(range(0, 60), scan(ScanBound(), ScanBound()));
+
+  // bounded by both columns
+  EXPECT_EQ(range(16, 23), scan(ScanBound(&low_key, 2, true),
+                                ScanBound(&high_key, 2, true)));
+  EXPECT_EQ(range(17, 22), scan(ScanBound(&low_key, 2, false),
+                                ScanBound(&high_key, 2, false)));
+  EXPECT_EQ(range(16, 18), scan(ScanBound(&low_key, 2, true),
+                                ScanBound(&low_key, 1, true)));
+
+  // empty ranges
+  EXPECT_EQ(range(0, 0), scan(ScanBound(&high_key, 1, true),
+                              ScanBound(&low_key, 1, true)));
+  EXPECT_EQ(range(0, 0), scan(ScanBound(&low_key, 2, false),
+                              ScanBound(&low_key, 2, false)));
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete schema;
+  delete bpm;
+  remove("test.db");
+}
+
+} // namespace cmudb
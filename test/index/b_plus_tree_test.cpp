@@ -5,11 +5,14 @@
 #include <algorithm>
 #include <cstdio>
 #include <iostream>
+#include <random>
 #include <sstream>
 
 #include "buffer/buffer_pool_manager.h"
 #include "common/logger.h"
 #include "index/b_plus_tree.h"
+#include "index/external_sorter.h"
+#include "page/header_page.h"
 #include "vtable/virtual_table.h"
 #include "gtest/gtest.h"
 
@@ -370,4 +373,294 @@ TEST(BPlusTreeTests, ScaleTest) {
   delete transaction;
   remove("test.db");
 }
+TEST(BPlusTreeTests, SplitMergeTest) {
+  // create KeyComparator and index schema
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+  BufferPoolManager *bpm = new BufferPoolManager(50, "test.db");
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(page_id);
+  (void)header_page;
+  // small pages, so the tree grows several levels
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree(
+      "foo_pk", bpm, comparator, INVALID_PAGE_ID, 4, 4);
+  GenericKey<8> index_key;
+  RID rid;
+
+  std::vector<int64_t> keys;
+  for (int64_t key = 0; key < 1000; key++)
+    keys.push_back(key);
+  std::shuffle(keys.begin(), keys.end(), std::mt19937(15445));
+  for (auto key : keys) {
+    rid.Set(0, static_cast<int>(key));
+    index_key.SetFromInteger(key);
+    EXPECT_TRUE(tree.Insert(index_key, rid));
+  }
+  // duplicate keys are rejected
+  index_key.SetFromInteger(keys[0]);
+  EXPECT_FALSE(tree.Insert(index_key, rid));
+
+  // remove every other key, pages redistribute and merge
+  for (auto key : keys) {
+    if (key % 2 == 1) {
+      index_key.SetFromInteger(key);
+      tree.Remove(index_key);
+    }
+  }
+  std::vector<RID> rids;
+  for (int64_t key = 0; key < 1000; key++) {
+    rids.clear();
+    index_key.SetFromInteger(key);
+    EXPECT_EQ(key % 2 == 0, tree.GetValue(index_key, rids));
+  }
+  int64_t current_key = 0;
+  for (auto iterator = tree.Begin(); iterator.isEnd() == false; ++iterator) {
+    EXPECT_EQ(current_key, (*iterator).second.GetSlotNum());
+    current_key = current_key + 2;
+  }
+  EXPECT_EQ(1000, current_key);
+
+  // the root collapses until the tree is empty, then grows again
+  for (auto key : keys) {
+    index_key.SetFromInteger(key);
+    tree.Remove(index_key);
+  }
+  EXPECT_TRUE(tree.IsEmpty());
+  EXPECT_TRUE(tree.Begin().isEnd());
+  index_key.SetFromInteger(42);
+  EXPECT_TRUE(tree.Insert(index_key, rid));
+  rids.clear();
+  EXPECT_TRUE(tree.GetValue(index_key, rids));
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete key_schema;
+  delete bpm;
+  remove("test.db");
+}
+TEST(BPlusTreeTests, BulkLoadTest) {
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+  BufferPoolManager *bpm = new BufferPoolManager(50, "test.db");
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(page_id);
+  (void)header_page;
+  GenericKey<8> index_key;
+  RID rid;
+  std::vector<RID> rids;
+
+  // every size of the last pages, a few levels of small pages
+  for (int64_t num_keys : {1, 2, 3, 7, 100, 1000}) {
+    for (double fill_factor : {1.0, 0.5}) {
+      BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree(
+          "foo_pk", bpm, comparator, INVALID_PAGE_ID, 4, 4);
+      // unsorted input with duplicates, sorted in small runs
+      ExternalSorter<GenericKey<8>, RID, GenericComparator<8>> sorter(
+          comparator, 64);
+      std::vector<int64_t> keys;
+      for (int64_t key = 0; key < num_keys; key++) {
+        keys.push_back(key);
+        keys.push_back(key);
+      }
+      std::shuffle(keys.begin(), keys.end(), std::mt19937(15445));
+      for (auto key : keys) {
+        rid.Set(0, static_cast<int>(key));
+        index_key.SetFromInteger(key);
+        sorter.Add(index_key, rid);
+      }
+      EXPECT_TRUE(tree.BulkLoad(
+          [&sorter](GenericKey<8> &key, RID &value) {
+            return sorter.Next(key, value);
+          },
+          fill_factor));
+      // only an empty tree is bulk loaded
+      EXPECT_FALSE(tree.BulkLoad(
+          [](GenericKey<8> &, RID &) { return false; }, fill_factor));
+
+      for (int64_t key = 0; key < num_keys; key++) {
+        rids.clear();
+        index_key.SetFromInteger(key);
+        EXPECT_TRUE(tree.GetValue(index_key, rids));
+      }
+      int64_t current_key = 0;
+      for (auto iterator = tree.Begin(); iterator.isEnd() == false;
+           ++iterator) {
+        EXPECT_EQ(current_key, (*iterator).second.GetSlotNum());
+        current_key = current_key + 1;
+      }
+      EXPECT_EQ(num_keys, current_key);
+
+      // the tree splits and merges as usual afterwards
+      for (int64_t key = num_keys; key < 2 * num_keys; key++) {
+        rid.Set(0, static_cast<int>(key));
+        index_key.SetFromInteger(key);
+        EXPECT_TRUE(tree.Insert(index_key, rid));
+      }
+      for (int64_t key = 0; key < 2 * num_keys; key++) {
+        index_key.SetFromInteger(key);
+        tree.Remove(index_key);
+      }
+      EXPECT_TRUE(tree.IsEmpty());
+    }
+  }
+
+  // out of order input stops the load
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm,
+                                                           comparator);
+  std::vector<int64_t> keys = {1, 2, 4, 3, 5};
+  size_t next = 0;
+  EXPECT_FALSE(tree.BulkLoad([&](GenericKey<8> &key, RID &value) {
+    if (next == keys.size())
+      return false;
+    key.SetFromInteger(keys[next]);
+    value.Set(0, static_cast<int>(keys[next++]));
+    return true;
+  }));
+  rids.clear();
+  index_key.SetFromInteger(4);
+  EXPECT_TRUE(tree.GetValue(index_key, rids));
+  index_key.SetFromInteger(3);
+  EXPECT_FALSE(tree.GetValue(index_key, rids));
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete key_schema;
+  delete bpm;
+  remove("test.db");
+}
+
+TEST(BPlusTreeTests, LongKeyTest) {
+  // normalized varchar keys that share a long prefix
+  Schema *key_schema = ParseCreateStatement("a varchar");
+  GenericComparator<64> comparator(key_schema, true);
+  BufferPoolManager *bpm = new BufferPoolManager(50, "test.db");
+  BPlusTree<GenericKey<64>, RID, GenericComparator<64>> tree("foo_pk", bpm,
+                                                             comparator);
+  page_id_t page_id;
+  auto *header_page = static_cast<HeaderPage *>(bpm->NewPage(page_id));
+
+  const int num_keys = 20000;
+  std::vector<GenericKey<64>> keys(num_keys);
+  for (int i = 0; i < num_keys; i++) {
+    char name[64];
+    snprintf(name, sizeof(name), "customer/region-0042/order-%06d", i);
+    Tuple tuple(std::vector<Value>{Value(TypeId::VARCHAR, name)}, key_schema);
+    keys[i].SetFromKey(tuple, key_schema);
+  }
+  std::vector<int> order(num_keys);
+  for (int i = 0; i < num_keys; i++)
+    order[i] = i;
+  std::shuffle(order.begin(), order.end(), std::mt19937(15445));
+  RID rid;
+  for (int i : order) {
+    rid.Set(0, i);
+    EXPECT_TRUE(tree.Insert(keys[i], rid));
+  }
+
+  std::vector<RID> rids;
+  for (int i = 0; i < num_keys; i++) {
+    rids.clear();
+    EXPECT_TRUE(tree.GetValue(keys[i], rids));
+    EXPECT_EQ(i, rids[0].GetSlotNum());
+  }
+  int current = 0;
+  for (auto iterator = tree.Begin(); !iterator.isEnd(); ++iterator)
+    EXPECT_EQ(current++, (*iterator).second.GetSlotNum());
+  EXPECT_EQ(num_keys, current);
+
+  // internal pages take far more children than full 64 byte keys allow
+  page_id_t root_id;
+  EXPECT_TRUE(header_page->GetRootId("foo_pk", root_id));
+  using InternalPage =
+      BPlusTreeInternalPage<GenericKey<64>, page_id_t, GenericComparator<64>>;
+  auto *root = reinterpret_cast<InternalPage *>(
+      bpm->FetchPage(root_id)->GetData());
+  page_id_t child_id = root->GetLevel() == 1 ? root_id : root->ValueAt(0);
+  auto *child = reinterpret_cast<InternalPage *>(
+      bpm->FetchPage(child_id)->GetData());
+  int full_key_size =
+      (PAGE_SIZE - sizeof(InternalPage)) / (sizeof(GenericKey<64>) + 4);
+  EXPECT_GT(child->GetSize(), 2 * full_key_size);
+  bpm->UnpinPage(child_id, false);
+  bpm->UnpinPage(root_id, false);
+
+  // merges and redistributions keep the keys fitting
+  for (int i = 0; i < num_keys; i += 2)
+    tree.Remove(keys[i]);
+  for (int i = 0; i < num_keys; i++) {
+    rids.clear();
+    EXPECT_EQ(i % 2 == 1, tree.GetValue(keys[i], rids));
+  }
+  for (int i : order)
+    tree.Remove(keys[i]);
+  EXPECT_TRUE(tree.IsEmpty());
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete key_schema;
+  delete bpm;
+  remove("test.db");
+}
+
+/*
+ * Insert shuffled keys from -num_keys to num_keys in steps of 2 into a tree
+ * of normalized keys, then look up every key in between
+ */
+template <size_t KeySize>
+void NormalizedSearchHelper(const std::string &column, TypeId type,
+                            int leaf_max_size) {
+  Schema *key_schema = ParseCreateStatement(column);
+  GenericComparator<KeySize> comparator(key_schema, true);
+  BufferPoolManager *bpm = new BufferPoolManager(50, "test.db");
+  BPlusTree<GenericKey<KeySize>, RID, GenericComparator<KeySize>> tree(
+      "foo_pk", bpm, comparator, INVALID_PAGE_ID, leaf_max_size);
+  page_id_t page_id;
+  bpm->NewPage(page_id);
+
+  const int num_keys = 5000;
+  auto make_key = [&](int value) {
+    GenericKey<KeySize> key;
+    Tuple tuple(std::vector<Value>{Value(type, value)}, key_schema);
+    key.SetFromKey(tuple, key_schema);
+    return key;
+  };
+  std::vector<int> values;
+  for (int value = -num_keys; value < num_keys; value += 2)
+    values.push_back(value);
+  std::shuffle(values.begin(), values.end(), std::mt19937(15445));
+  RID rid;
+  for (int value : values) {
+    rid.Set(0, value);
+    EXPECT_TRUE(tree.Insert(make_key(value), rid));
+  }
+
+  std::vector<RID> rids;
+  for (int value = -num_keys - 1; value <= num_keys; value++) {
+    rids.clear();
+    bool even = value % 2 == 0 && value < num_keys;
+    EXPECT_EQ(even, tree.GetValue(make_key(value), rids));
+    if (even) {
+      EXPECT_EQ(value, rids[0].GetSlotNum());
+    }
+  }
+  // a scan starts at the first key not less than the one asked for
+  int current = -num_keys + 2;
+  for (auto iterator = tree.Begin(make_key(-num_keys + 1));
+       !iterator.isEnd(); ++iterator) {
+    EXPECT_EQ(current, (*iterator).second.GetSlotNum());
+    current += 2;
+  }
+  EXPECT_EQ(num_keys, current);
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete key_schema;
+  delete bpm;
+  remove("test.db");
+}
+
+TEST(BPlusTreeTests, NormalizedSearchTest) {
+  // large leaves are searched through a window, small ones at once
+  NormalizedSearchHelper<8>("a bigint", TypeId::BIGINT, 200);
+  NormalizedSearchHelper<8>("a bigint", TypeId::BIGINT, 5);
+  NormalizedSearchHelper<4>("a int", TypeId::INTEGER, 200);
+  NormalizedSearchHelper<4>("a int", TypeId::INTEGER, 5);
+}
 } // namespace cmudb
@@ -0,0 +1,195 @@
+/**
+ * extendible_hash_table_test.cpp
+ */
+
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "index/extendible_hash_table.h"
+#include "page/header_page.h"
+#include "vtable/virtual_table.h"
+#include "gtest/gtest.h"
+
+namespace cmudb {
+
+TEST(ExtendibleHashTableTest, InsertRemoveTest) {
+  // create KeyComparator and index schema
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+  BufferPoolManager *bpm = new BufferPoolManager(50, "test.db");
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(page_id);
+  static_cast<HeaderPage *>(header_page)->Init();
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+
+  ExtendibleHashTable<GenericKey<8>, RID, GenericComparator<8>> table(
+      "foo_pk", bpm, comparator);
+  EXPECT_TRUE(table.IsEmpty());
+  GenericKey<8> index_key;
+  RID rid;
+
+  // enough keys for the directory to grow
+  const int64_t num_keys = 5000;
+  for (int64_t key = 0; key < num_keys; key++) {
+    rid.Set(static_cast<int32_t>(key >> 32), static_cast<int>(key));
+    index_key.SetFromInteger(key);
+    EXPECT_TRUE(table.Insert(index_key, rid));
+  }
+  EXPECT_FALSE(table.IsEmpty());
+  EXPECT_LT(0u, table.GetGlobalDepth());
+  // duplicate keys are rejected
+  index_key.SetFromInteger(0);
+  EXPECT_FALSE(table.Insert(index_key, rid));
+
+  std::vector<RID> rids;
+  for (int64_t key = 0; key < num_keys; key++) {
+    rids.clear();
+    index_key.SetFromInteger(key);
+    EXPECT_TRUE(table.GetValue(index_key, rids));
+    ASSERT_EQ(1u, rids.size());
+    EXPECT_EQ(key, rids[0].GetSlotNum());
+  }
+  index_key.SetFromInteger(num_keys);
+  EXPECT_FALSE(table.GetValue(index_key, rids));
+
+  // the directory is found again through its page id
+  ExtendibleHashTable<GenericKey<8>, RID, GenericComparator<8>> reopened(
+      "foo_pk", bpm, comparator, table.GetDirectoryPageId());
+  rids.clear();
+  index_key.SetFromInteger(42);
+  EXPECT_TRUE(reopened.GetValue(index_key, rids));
+  ASSERT_EQ(1u, rids.size());
+  EXPECT_EQ(42, rids[0].GetSlotNum());
+  header_page = bpm->FetchPage(HEADER_PAGE_ID);
+  page_id_t directory_page_id;
+  EXPECT_TRUE(static_cast<HeaderPage *>(header_page)
+                  ->GetRootId("foo_pk", directory_page_id));
+  EXPECT_EQ(table.GetDirectoryPageId(), directory_page_id);
+  bpm->UnpinPage(HEADER_PAGE_ID, false);
+
+  // buckets merge and the directory shrinks as keys go away
+  for (int64_t key = 0; key < num_keys; key++) {
+    index_key.SetFromInteger(key);
+    table.Remove(index_key);
+    if (key % 1000 == 0) {
+      rids.clear();
+      EXPECT_FALSE(table.GetValue(index_key, rids));
+    }
+  }
+  EXPECT_TRUE(table.IsEmpty());
+  EXPECT_EQ(0u, table.GetGlobalDepth());
+
+  delete key_schema;
+  delete bpm;
+  remove("test.db");
+}
+
+TEST(ExtendibleHashTableTest, OverflowTest) {
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<64> comparator(key_schema);
+  BufferPoolManager *bpm = new BufferPoolManager(50, "test.db");
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(page_id);
+  static_cast<HeaderPage *>(header_page)->Init();
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+
+  ExtendibleHashTable<GenericKey<64>, RID, GenericComparator<64>> table(
+      "foo_pk", bpm, comparator);
+  GenericKey<64> index_key;
+  RID rid;
+
+  // more keys than 512 full buckets hold, they go to overflow pages
+  const int64_t num_keys =
+      DIRECTORY_ARRAY_SIZE *
+          HashTableBucketPage<GenericKey<64>, RID,
+                              GenericComparator<64>>::GetMaxSize() +
+      10000;
+  for (int64_t key = 0; key < num_keys; key++) {
+    rid.Set(0, static_cast<int>(key));
+    index_key.SetFromInteger(key);
+    ASSERT_TRUE(table.Insert(index_key, rid));
+  }
+  EXPECT_EQ(static_cast<uint32_t>(DIRECTORY_MAX_DEPTH),
+            table.GetGlobalDepth());
+  index_key.SetFromInteger(num_keys - 1);
+  EXPECT_FALSE(table.Insert(index_key, rid));
+
+  std::vector<RID> rids;
+  for (int64_t key = 0; key < num_keys; key++) {
+    index_key.SetFromInteger(key);
+    EXPECT_TRUE(table.GetValue(index_key, rids));
+  }
+  ASSERT_EQ(static_cast<size_t>(num_keys), rids.size());
+  for (int64_t key = 0; key < num_keys; key++)
+    EXPECT_EQ(key, rids[key].GetSlotNum());
+
+  // removing from the middle of the chains keeps the other keys reachable
+  for (int64_t key = 0; key < num_keys; key += 2) {
+    index_key.SetFromInteger(key);
+    table.Remove(index_key);
+  }
+  for (int64_t key = 0; key < num_keys; key++) {
+    rids.clear();
+    index_key.SetFromInteger(key);
+    EXPECT_EQ(key % 2 == 1, table.GetValue(index_key, rids));
+  }
+  for (int64_t key = 1; key < num_keys; key += 2) {
+    index_key.SetFromInteger(key);
+    table.Remove(index_key);
+  }
+  EXPECT_TRUE(table.IsEmpty());
+  EXPECT_EQ(0u, table.GetGlobalDepth());
+
+  delete key_schema;
+  delete bpm;
+  remove("test.db");
+}
+
+TEST(ExtendibleHashTableTest, ConcurrentInsertTest) {
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+  BufferPoolManager *bpm = new BufferPoolManager(50, "test.db");
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(page_id);
+  static_cast<HeaderPage *>(header_page)->Init();
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+
+  ExtendibleHashTable<GenericKey<8>, RID, GenericComparator<8>> table(
+      "foo_pk", bpm, comparator);
+  const int num_threads = 4;
+  const int64_t num_keys = 2000;
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; tid++) {
+    threads.push_back(std::thread([tid, &table]() {
+      GenericKey<8> index_key;
+      RID rid;
+      std::vector<RID> rids;
+      for (int64_t key = tid; key < num_keys; key += num_threads) {
+        rid.Set(0, static_cast<int>(key));
+        index_key.SetFromInteger(key);
+        EXPECT_TRUE(table.Insert(index_key, rid));
+        rids.clear();
+        EXPECT_TRUE(table.GetValue(index_key, rids));
+      }
+    }));
+  }
+  for (auto &thread : threads)
+    thread.join();
+
+  GenericKey<8> index_key;
+  std::vector<RID> rids;
+  for (int64_t key = 0; key < num_keys; key++) {
+    index_key.SetFromInteger(key);
+    EXPECT_TRUE(table.GetValue(index_key, rids));
+  }
+  EXPECT_EQ(static_cast<size_t>(num_keys), rids.size());
+
+  delete key_schema;
+  delete bpm;
+  remove("test.db");
+}
+
+} // namespace cmudb
@@ -0,0 +1,51 @@
+/**
+ * external_sorter_test.cpp
+ */
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "index/external_sorter.h"
+#include "vtable/virtual_table.h"
+#include "gtest/gtest.h"
+
+namespace cmudb {
+
+TEST(ExternalSorterTest, SortTest) {
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+  GenericKey<8> index_key;
+  RID rid;
+
+  // fits into one run, or is spilled to many
+  for (size_t run_size : {100000, 64, 1}) {
+    ExternalSorter<GenericKey<8>, RID, GenericComparator<8>> sorter(
+        comparator, run_size);
+    std::vector<int64_t> keys;
+    for (int64_t key = -500; key < 500; key++)
+      keys.push_back(key);
+    std::shuffle(keys.begin(), keys.end(), std::mt19937(15445));
+    for (auto key : keys) {
+      rid.Set(0, static_cast<int>(key));
+      index_key.SetFromInteger(key);
+      sorter.Add(index_key, rid);
+    }
+
+    int64_t current_key = -500;
+    while (sorter.Next(index_key, rid)) {
+      EXPECT_EQ(current_key, rid.GetSlotNum());
+      current_key = current_key + 1;
+    }
+    EXPECT_EQ(500, current_key);
+    EXPECT_FALSE(sorter.Next(index_key, rid));
+  }
+
+  // nothing to sort
+  ExternalSorter<GenericKey<8>, RID, GenericComparator<8>> sorter(comparator);
+  EXPECT_FALSE(sorter.Next(index_key, rid));
+
+  delete key_schema;
+}
+
+} // namespace cmudb
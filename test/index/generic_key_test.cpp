@@ -0,0 +1,96 @@
+/**
+ * generic_key_test.cpp
+ */
+
+#include <string>
+#include <vector>
+
+#include "index/generic_key.h"
+#include "vtable/virtual_table.h"
+#include "gtest/gtest.h"
+
+namespace cmudb {
+
+TEST(GenericKeyTest, NormalizedOrderTest) {
+  Schema *key_schema = ParseCreateStatement("a int, b varchar, c double");
+  GenericComparator<32> raw_comparator(key_schema);
+  GenericComparator<32> comparator(key_schema, true);
+
+  // sorted by value, negative numbers and prefixes included
+  std::vector<Tuple> tuples;
+  tuples.emplace_back(std::vector<Value>{Value(TypeId::INTEGER, -70000),
+                                         Value(TypeId::VARCHAR, "zz"),
+                                         Value(TypeId::DECIMAL, 0.0)},
+                      key_schema);
+  tuples.emplace_back(std::vector<Value>{Value(TypeId::INTEGER, -1),
+                                         Value(TypeId::VARCHAR, "b"),
+                                         Value(TypeId::DECIMAL, 1.0)},
+                      key_schema);
+  tuples.emplace_back(std::vector<Value>{Value(TypeId::INTEGER, 0),
+                                         Value(TypeId::VARCHAR, "ab"),
+                                         Value(TypeId::DECIMAL, 1.0)},
+                      key_schema);
+  tuples.emplace_back(std::vector<Value>{Value(TypeId::INTEGER, 0),
+                                         Value(TypeId::VARCHAR, "abc"),
+                                         Value(TypeId::DECIMAL, -2.5)},
+                      key_schema);
+  tuples.emplace_back(std::vector<Value>{Value(TypeId::INTEGER, 0),
+                                         Value(TypeId::VARCHAR, "abc"),
+                                         Value(TypeId::DECIMAL, -0.5)},
+                      key_schema);
+  tuples.emplace_back(std::vector<Value>{Value(TypeId::INTEGER, 0),
+                                         Value(TypeId::VARCHAR, "abc"),
+                                         Value(TypeId::DECIMAL, 3.25)},
+                      key_schema);
+  tuples.emplace_back(std::vector<Value>{Value(TypeId::INTEGER, 256),
+                                         Value(TypeId::VARCHAR, ""),
+                                         Value(TypeId::DECIMAL, 0.0)},
+                      key_schema);
+
+  std::vector<GenericKey<32>> keys(tuples.size());
+  std::vector<GenericKey<32>> raw_keys(tuples.size());
+  for (size_t i = 0; i < tuples.size(); i++) {
+    keys[i].SetFromKey(tuples[i], key_schema);
+    raw_keys[i].SetFromKey(tuples[i]);
+  }
+  // memcmp agrees with comparing the values
+  for (size_t i = 0; i < keys.size(); i++) {
+    for (size_t j = 0; j < keys.size(); j++) {
+      int expected = (i > j) - (i < j);
+      EXPECT_EQ(expected, comparator(keys[i], keys[j]));
+      EXPECT_EQ(expected, raw_comparator(raw_keys[i], raw_keys[j]));
+    }
+  }
+
+  // and decodes back to the values
+  for (size_t i = 0; i < keys.size(); i++) {
+    for (int column = 0; column < key_schema->GetColumnCount(); column++) {
+      Value expected = tuples[i].GetValue(key_schema, column);
+      Value value = keys[i].ToValue(key_schema, column, true);
+      EXPECT_EQ(CMP_TRUE, value.CompareEquals(expected));
+    }
+  }
+
+  delete key_schema;
+}
+
+TEST(GenericKeyTest, NormalizedTruncateTest) {
+  Schema *key_schema = ParseCreateStatement("a varchar, b bigint");
+  GenericComparator<8> comparator(key_schema, true);
+  Tuple left(std::vector<Value>{Value(TypeId::VARCHAR, "abcdefgh"),
+                                Value(TypeId::BIGINT, int64_t(1))},
+             key_schema);
+  Tuple right(std::vector<Value>{Value(TypeId::VARCHAR, "abcdefgz"),
+                                 Value(TypeId::BIGINT, int64_t(2))},
+              key_schema);
+  // longer keys are cut off and compare by their prefix
+  GenericKey<8> left_key, right_key;
+  left_key.SetFromKey(left, key_schema);
+  right_key.SetFromKey(right, key_schema);
+  EXPECT_EQ(0, comparator(left_key, right_key));
+  EXPECT_EQ("abcdefg", left_key.ToValue(key_schema, 0, true).ToString());
+
+  delete key_schema;
+}
+
+} // namespace cmudb
@@ -0,0 +1,123 @@
+/**
+ * table_heap_test.cpp
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <fcntl.h>
+#include <iostream>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "table/table_heap.h"
+#include "vtable/virtual_table.h"
+#include "gtest/gtest.h"
+
+namespace cmudb {
+
+namespace {
+Tuple MakeTuple(Schema *schema, int32_t key) {
+  std::vector<Value> values;
+  values.emplace_back(TypeId::INTEGER, key);
+  values.emplace_back(TypeId::VARCHAR, std::string(200, 'x'));
+  return Tuple(values, schema);
+}
+
+// drop the file from the page cache so that scans hit the disk
+void EvictFromPageCache(const std::string &file_name) {
+  int fd = open(file_name.c_str(), O_RDONLY);
+  if (fd < 0)
+    return;
+  fdatasync(fd);
+  posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+  close(fd);
+}
+} // namespace
+
+TEST(TableHeapTest, ReadaheadScanTest) {
+  remove("test.db");
+  Schema *schema = ParseCreateStatement("a int, b varchar");
+  const int num_tuples = 1000;
+
+  for (size_t readahead_pages : {0, 1, 4, 16}) {
+    BufferPoolManager *buffer_pool_manager =
+        new BufferPoolManager(10, "test.db", 2);
+    LockManager *lock_manager = new LockManager(true);
+    TableHeap *table = new TableHeap(buffer_pool_manager, lock_manager);
+    table->SetReadaheadPages(readahead_pages);
+    EXPECT_EQ(readahead_pages, table->GetReadaheadPages());
+    Transaction *transaction = new Transaction(0);
+
+    RID rid;
+    std::vector<RID> rids;
+    for (int i = 0; i < num_tuples; ++i) {
+      ASSERT_TRUE(table->InsertTuple(MakeTuple(schema, i), rid, transaction));
+      rids.push_back(rid);
+    }
+
+    // the table spans many more pages than there are frames, the window
+    // may even exceed the pool
+    for (bool bulk_read : {false, true}) {
+      size_t count = 0;
+      for (auto itr = table->begin(transaction, bulk_read);
+           itr != table->end(); ++itr) {
+        ASSERT_LT(count, rids.size());
+        EXPECT_EQ(rids[count].Get(), itr->GetRid().Get());
+        count++;
+      }
+      EXPECT_EQ(rids.size(), count);
+    }
+
+    delete transaction;
+    delete table;
+    delete lock_manager;
+    delete buffer_pool_manager;
+    remove("test.db");
+  }
+  delete schema;
+}
+
+// Cold full scan throughput with different readahead windows, run with
+// --gtest_also_run_disabled_tests
+TEST(TableHeapTest, DISABLED_ColdScanBenchmark) {
+  remove("test.db");
+  Schema *schema = ParseCreateStatement("a int, b varchar");
+  const int num_tuples = 30000;
+  page_id_t first_page_id;
+  {
+    // insertion walks the page chain, keep the whole table cached meanwhile
+    BufferPoolManager buffer_pool_manager(4096, "test.db");
+    LockManager lock_manager(true);
+    TableHeap table(&buffer_pool_manager, &lock_manager);
+    Transaction transaction(0);
+    RID rid;
+    for (int i = 0; i < num_tuples; ++i)
+      table.InsertTuple(MakeTuple(schema, i), rid, &transaction);
+    first_page_id = table.GetFirstPageId();
+  }
+
+  for (size_t readahead_pages : {0, 4, 16, 64}) {
+    EvictFromPageCache("test.db");
+    BufferPoolManager buffer_pool_manager(256, "test.db");
+    LockManager lock_manager(true);
+    TableHeap table(&buffer_pool_manager, &lock_manager, first_page_id);
+    table.SetReadaheadPages(readahead_pages);
+    Transaction transaction(0);
+
+    auto start = std::chrono::steady_clock::now();
+    int count = 0;
+    for (auto itr = table.begin(&transaction); itr != table.end(); ++itr)
+      count++;
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    EXPECT_EQ(num_tuples, count);
+    std::cout << "readahead " << readahead_pages << ": "
+              << count / elapsed.count() << " tuples per second" << std::endl;
+  }
+  delete schema;
+  remove("test.db");
+}
+
+} // namespace cmudb
@@ -0,0 +1,122 @@
+/**
+ * virtual_table_planner_test.cpp
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "vtable/virtual_table.h"
+#include "gtest/gtest.h"
+
+namespace cmudb {
+
+// outcome of VtabBestIndex for a set of usable constraints
+struct ScanPlan {
+  int idx_num_;
+  // argvIndex of every constraint, 0 if it is not passed to VtabFilter
+  std::vector<int> argv_indexes_;
+  double estimated_cost_;
+};
+
+ScanPlan PlanScan(VirtualTable *table,
+                  const std::vector<std::pair<int, unsigned char>> &where,
+                  int unusable = -1) {
+  std::vector<sqlite3_index_info::sqlite3_index_constraint> constraints(
+      where.size());
+  std::vector<sqlite3_index_info::sqlite3_index_constraint_usage> usages(
+      where.size());
+  for (size_t i = 0; i < where.size(); i++) {
+    constraints[i].iColumn = where[i].first;
+    constraints[i].op = where[i].second;
+    constraints[i].usable = static_cast<int>(i) != unusable;
+    usages[i].argvIndex = 0;
+  }
+  sqlite3_index_info info;
+  memset(&info, 0, sizeof(info));
+  info.nConstraint = static_cast<int>(where.size());
+  info.aConstraint = constraints.data();
+  info.aConstraintUsage = usages.data();
+  info.estimatedCost = 1e99;
+  EXPECT_EQ(SQLITE_OK,
+            VtabBestIndex(reinterpret_cast<sqlite3_vtab *>(table), &info));
+  ScanPlan plan{info.idxNum, {}, info.estimatedCost};
+  for (auto &usage : usages)
+    plan.argv_indexes_.push_back(usage.argvIndex);
+  return plan;
+}
+
+TEST(VtablePlannerTest, BPlusTreeIndexTest) {
+  BufferPoolManager *bpm = new BufferPoolManager(50, "test.db");
+  page_id_t page_id;
+  bpm->NewPage(page_id);
+  Schema *schema = ParseCreateStatement("a int, b int, c int");
+  Index *index = ConstructIndex(
+      new IndexMetadata("foo_pk", "foo", schema, {0, 1}), bpm);
+  VirtualTable *table = new VirtualTable(schema, bpm, nullptr, index);
+  const unsigned char EQ = SQLITE_INDEX_CONSTRAINT_EQ;
+
+  // full key equality, values in key column order whatever the WHERE order
+  ScanPlan plan = PlanScan(table, {{1, EQ}, {0, EQ}});
+  EXPECT_EQ(2, plan.idx_num_);
+  EXPECT_EQ((std::vector<int>{2, 1}), plan.argv_indexes_);
+  double point_cost = plan.estimated_cost_;
+
+  // equality on a prefix and both bounds on the next key column
+  plan = PlanScan(table, {{1, SQLITE_INDEX_CONSTRAINT_LE},
+                          {2, EQ},
+                          {1, SQLITE_INDEX_CONSTRAINT_GT},
+                          {0, EQ}});
+  EXPECT_EQ(1 | SCAN_LOW | SCAN_HIGH | SCAN_HIGH_INCLUSIVE, plan.idx_num_);
+  EXPECT_EQ((std::vector<int>{3, 0, 2, 1}), plan.argv_indexes_);
+  EXPECT_LT(point_cost, plan.estimated_cost_);
+  double prefix_cost = plan.estimated_cost_;
+
+  // a lone lower bound on the first key column
+  plan = PlanScan(table, {{0, SQLITE_INDEX_CONSTRAINT_GE}});
+  EXPECT_EQ(SCAN_LOW | SCAN_LOW_INCLUSIVE, plan.idx_num_);
+  EXPECT_EQ((std::vector<int>{1}), plan.argv_indexes_);
+  EXPECT_LT(prefix_cost, plan.estimated_cost_);
+
+  // unusable constraints are left out of the plan
+  plan = PlanScan(table, {{0, EQ}, {1, EQ}}, 1);
+  EXPECT_EQ(1, plan.idx_num_);
+  EXPECT_EQ((std::vector<int>{1, 0}), plan.argv_indexes_);
+
+  // no constraint on the first key column means a sequential scan
+  plan = PlanScan(table, {{1, EQ}, {2, SQLITE_INDEX_CONSTRAINT_LT}});
+  EXPECT_EQ(0, plan.idx_num_);
+  EXPECT_EQ((std::vector<int>{0, 0}), plan.argv_indexes_);
+
+  delete table;
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete bpm;
+  remove("test.db");
+}
+
+TEST(VtablePlannerTest, HashTableIndexTest) {
+  BufferPoolManager *bpm = new BufferPoolManager(50, "test.db");
+  page_id_t page_id;
+  bpm->NewPage(page_id);
+  Schema *schema = ParseCreateStatement("a int, b int");
+  Index *index = ConstructIndex(new IndexMetadata("foo_pk", "foo", schema, {0},
+                                                  IndexType::HashTableIndex),
+                                bpm);
+  VirtualTable *table = new VirtualTable(schema, bpm, nullptr, index);
+
+  // full key equality only
+  ScanPlan plan = PlanScan(table, {{0, SQLITE_INDEX_CONSTRAINT_EQ}});
+  EXPECT_EQ(1, plan.idx_num_);
+  EXPECT_EQ((std::vector<int>{1}), plan.argv_indexes_);
+  plan = PlanScan(table, {{0, SQLITE_INDEX_CONSTRAINT_GT}});
+  EXPECT_EQ(0, plan.idx_num_);
+
+  delete table;
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete bpm;
+  remove("test.db");
+}
+
+} // namespace cmudb
@@ -44,4 +44,153 @@ TEST(VtableTest, CreateTest) {
   remove("vtable.db");
   return;
 }
+
+TEST(VtableTest, BpmStatsTest) {
+  std::string db_file = "sqlite.db";
+  remove(db_file.c_str());
+  remove("vtable.db");
+  sqlite3 *db;
+  int rc;
+  rc = sqlite3_open(db_file.c_str(), &db);
+  EXPECT_EQ(rc, SQLITE_OK);
+
+  rc = sqlite3_enable_load_extension(db, 1);
+  EXPECT_EQ(rc, SQLITE_OK);
+  char *zErrMsg = 0;
+  rc = sqlite3_load_extension(db, "libvtable", 0, &zErrMsg);
+  EXPECT_EQ(rc, SQLITE_OK);
+
+  EXPECT_TRUE(ExecSQL(db, "CREATE VIRTUAL TABLE foo2 USING vtable ('a INT')"));
+  EXPECT_TRUE(ExecSQL(db, "INSERT INTO foo2 VALUES(1)"));
+  EXPECT_TRUE(ExecSQL(db, "SELECT * FROM foo2"));
+  // counters have no page id, every cached page has an accesses row
+  EXPECT_TRUE(ExecSQL(db, "SELECT * FROM vtable_bpm_stats"));
+  sqlite3_stmt *stmt;
+  rc = sqlite3_prepare_v2(db,
+                          "SELECT value FROM vtable_bpm_stats WHERE name = "
+                          "'hits' AND page_id IS NULL",
+                          -1, &stmt, nullptr);
+  EXPECT_EQ(rc, SQLITE_OK);
+  EXPECT_EQ(SQLITE_ROW, sqlite3_step(stmt));
+  EXPECT_LT(0, sqlite3_column_int64(stmt, 0));
+  sqlite3_finalize(stmt);
+  rc = sqlite3_prepare_v2(
+      db, "SELECT count(*) FROM vtable_bpm_stats WHERE name = 'accesses'", -1,
+      &stmt, nullptr);
+  EXPECT_EQ(rc, SQLITE_OK);
+  EXPECT_EQ(SQLITE_ROW, sqlite3_step(stmt));
+  EXPECT_LT(0, sqlite3_column_int64(stmt, 0));
+  sqlite3_finalize(stmt);
+  // the table is read only
+  EXPECT_FALSE(ExecSQL(db, "DELETE FROM vtable_bpm_stats"));
+  EXPECT_TRUE(ExecSQL(db, "DROP TABLE foo2"));
+
+  rc = sqlite3_close(db);
+  EXPECT_EQ(rc, SQLITE_OK);
+
+  remove(db_file.c_str());
+  remove("vtable.db");
+}
+
+TEST(VtableTest, HashIndexTest) {
+  std::string db_file = "sqlite.db";
+  remove(db_file.c_str());
+  remove("vtable.db");
+  sqlite3 *db;
+  int rc;
+  rc = sqlite3_open(db_file.c_str(), &db);
+  EXPECT_EQ(rc, SQLITE_OK);
+
+  rc = sqlite3_enable_load_extension(db, 1);
+  EXPECT_EQ(rc, SQLITE_OK);
+  char *zErrMsg = 0;
+  rc = sqlite3_load_extension(db, "libvtable", 0, &zErrMsg);
+  EXPECT_EQ(rc, SQLITE_OK);
+
+  EXPECT_TRUE(ExecSQL(db, "CREATE VIRTUAL TABLE foo3 USING vtable ('a INT, b "
+                          "varchar', 'foo3_pk hash a')"));
+  EXPECT_TRUE(ExecSQL(db, "INSERT INTO foo3 VALUES(1, 'hello')"));
+  EXPECT_TRUE(ExecSQL(db, "INSERT INTO foo3 VALUES(2, 'world')"));
+  EXPECT_TRUE(ExecSQL(db, "INSERT INTO foo3 VALUES(3, 'Nihao')"));
+  sqlite3_stmt *stmt;
+  rc = sqlite3_prepare_v2(db, "SELECT b FROM foo3 WHERE a = 2", -1, &stmt,
+                          nullptr);
+  EXPECT_EQ(rc, SQLITE_OK);
+  EXPECT_EQ(SQLITE_ROW, sqlite3_step(stmt));
+  EXPECT_STREQ("world",
+               reinterpret_cast<const char *>(sqlite3_column_text(stmt, 0)));
+  EXPECT_EQ(SQLITE_DONE, sqlite3_step(stmt));
+  sqlite3_finalize(stmt);
+  EXPECT_TRUE(ExecSQL(db, "DELETE FROM foo3 WHERE a = 2"));
+  rc = sqlite3_prepare_v2(db, "SELECT count(*) FROM foo3 WHERE a = 2", -1,
+                          &stmt, nullptr);
+  EXPECT_EQ(rc, SQLITE_OK);
+  EXPECT_EQ(SQLITE_ROW, sqlite3_step(stmt));
+  EXPECT_EQ(0, sqlite3_column_int(stmt, 0));
+  sqlite3_finalize(stmt);
+  EXPECT_TRUE(ExecSQL(db, "DROP TABLE foo3"));
+
+  rc = sqlite3_close(db);
+  EXPECT_EQ(rc, SQLITE_OK);
+
+  remove(db_file.c_str());
+  remove("vtable.db");
+}
+
+TEST(VtableTest, RangeScanTest) {
+  std::string db_file = "sqlite.db";
+  remove(db_file.c_str());
+  remove("vtable.db");
+  sqlite3 *db;
+  int rc;
+  rc = sqlite3_open(db_file.c_str(), &db);
+  EXPECT_EQ(rc, SQLITE_OK);
+
+  rc = sqlite3_enable_load_extension(db, 1);
+  EXPECT_EQ(rc, SQLITE_OK);
+  char *zErrMsg = 0;
+  rc = sqlite3_load_extension(db, "libvtable", 0, &zErrMsg);
+  EXPECT_EQ(rc, SQLITE_OK);
+
+  EXPECT_TRUE(ExecSQL(db, "CREATE VIRTUAL TABLE foo4 USING vtable ('a INT, b "
+                          "int, c varchar', 'foo4_pk a, b')"));
+  for (int a = 0; a < 10; a++) {
+    for (int b = 0; b < 5; b++)
+      EXPECT_TRUE(ExecSQL(db, "INSERT INTO foo4 VALUES(" + std::to_string(a) +
+                                  ", " + std::to_string(b) + ", 'hello')"));
+  }
+  auto count = [db](const std::string &where,
+                    const std::string &from = "foo4") {
+    sqlite3_stmt *stmt;
+    std::string sql = "SELECT count(*) FROM " + from + " WHERE " + where;
+    EXPECT_EQ(SQLITE_OK,
+              sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr));
+    EXPECT_EQ(SQLITE_ROW, sqlite3_step(stmt));
+    int result = sqlite3_column_int(stmt, 0);
+    sqlite3_finalize(stmt);
+    return result;
+  };
+  // key prefix and ranges
+  EXPECT_EQ(5, count("a = 2"));
+  EXPECT_EQ(2, count("a = 2 AND b >= 3"));
+  EXPECT_EQ(3, count("b < 3 AND a = 2"));
+  EXPECT_EQ(1, count("a = 2 AND b > 0 AND b < 2"));
+  EXPECT_EQ(15, count("a > 3 AND a <= 6"));
+  EXPECT_EQ(10, count("a BETWEEN 2 AND 3"));
+  EXPECT_EQ(20, count("a >= 6"));
+  EXPECT_EQ(0, count("a > 9"));
+  // bounds that do not fit the column
+  EXPECT_EQ(15, count("a < 2.5"));
+  EXPECT_EQ(50, count("a < 3000000000"));
+  // the inner scan is filtered again for every outer row
+  EXPECT_EQ(25, count("x.a = 0 AND y.a = x.b", "foo4 x, foo4 y"));
+  EXPECT_EQ(10, count("x.a = 1 AND y.a = 1 AND y.b < x.b", "foo4 x, foo4 y"));
+  EXPECT_TRUE(ExecSQL(db, "DROP TABLE foo4"));
+
+  rc = sqlite3_close(db);
+  EXPECT_EQ(rc, SQLITE_OK);
+
+  remove(db_file.c_str());
+  remove("vtable.db");
+}
 } // namespace cmudb